@@ -0,0 +1,228 @@
+#include "password_hasher.hpp"
+
+#include <boost/asio/post.hpp>
+#include <glog/logging.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include <cstdio>
+#include <stdexcept>
+
+namespace auth
+{
+    namespace
+    {
+        constexpr size_t salt_size = 16;
+        constexpr size_t key_size = 32;
+        constexpr char prefix[] = "$scrypt$";
+
+        // 存储的参数来自数据库，限制范围避免异常参数耗尽内存
+        constexpr unsigned max_log_n = 20;
+        constexpr unsigned max_r = 32;
+        constexpr unsigned max_p = 16;
+
+        std::string to_hex(const unsigned char *data, size_t size)
+        {
+            static const char digits[] = "0123456789abcdef";
+            std::string out(size * 2, '\0');
+            for (size_t i = 0; i < size; ++i)
+            {
+                out[i * 2] = digits[data[i] >> 4];
+                out[i * 2 + 1] = digits[data[i] & 0x0f];
+            }
+            return out;
+        }
+
+        bool from_hex(const std::string &hex, unsigned char *out, size_t size)
+        {
+            if (hex.size() != size * 2)
+            {
+                return false;
+            }
+            auto value = [](char c) -> int
+            {
+                if (c >= '0' && c <= '9')
+                    return c - '0';
+                if (c >= 'a' && c <= 'f')
+                    return c - 'a' + 10;
+                return -1;
+            };
+            for (size_t i = 0; i < size; ++i)
+            {
+                int hi = value(hex[i * 2]), lo = value(hex[i * 2 + 1]);
+                if (hi < 0 || lo < 0)
+                {
+                    return false;
+                }
+                out[i] = static_cast<unsigned char>(hi << 4 | lo);
+            }
+            return true;
+        }
+
+        bool derive(const std::string &password, const unsigned char *salt, const ScryptParams &params,
+                    unsigned char *key)
+        {
+            uint64_t const n = uint64_t(1) << params.log_n;
+            // scrypt 需要 128 * r * (N + p) 字节左右，默认上限 32MB 不足以容纳 N = 2^15, r = 8
+            uint64_t const maxmem = 128 * uint64_t(params.r) * (n + params.p + 2) + (1 << 20);
+            return EVP_PBE_scrypt(password.data(), password.size(), salt, salt_size,
+                                  n, params.r, params.p, maxmem, key, key_size) == 1;
+        }
+
+        // 解析 $scrypt$ln=..,r=..,p=..$<盐>$<哈希>
+        bool parse(const std::string &stored, ScryptParams &params,
+                   unsigned char *salt, unsigned char *key)
+        {
+            unsigned log_n = 0, r = 0, p = 0;
+            int consumed = 0;
+            if (std::sscanf(stored.c_str(), "$scrypt$ln=%u,r=%u,p=%u$%n", &log_n, &r, &p, &consumed) != 3 ||
+                consumed == 0)
+            {
+                return false;
+            }
+            if (log_n == 0 || log_n > max_log_n || r == 0 || r > max_r || p == 0 || p > max_p)
+            {
+                return false;
+            }
+
+            auto const rest = stored.substr(static_cast<size_t>(consumed));
+            auto const sep = rest.find('$');
+            if (sep == std::string::npos ||
+                !from_hex(rest.substr(0, sep), salt, salt_size) ||
+                !from_hex(rest.substr(sep + 1), key, key_size))
+            {
+                return false;
+            }
+
+            params = {log_n, r, p};
+            return true;
+        }
+    } // namespace
+
+    std::string hashPassword(const std::string &password, const ScryptParams &params)
+    {
+        unsigned char salt[salt_size];
+        unsigned char key[key_size];
+        if (RAND_bytes(salt, sizeof(salt)) != 1 || !derive(password, salt, params, key))
+        {
+            throw std::runtime_error("scrypt failed");
+        }
+
+        char header[64];
+        std::snprintf(header, sizeof(header), "%sln=%u,r=%u,p=%u$", prefix, params.log_n, params.r, params.p);
+        return header + to_hex(salt, sizeof(salt)) + "$" + to_hex(key, sizeof(key));
+    }
+
+    bool verifyPassword(const std::string &password, const std::string &stored,
+                        const ScryptParams &params, bool &needs_rehash)
+    {
+        needs_rehash = false;
+
+        if (stored.compare(0, sizeof(prefix) - 1, prefix) != 0)
+        {
+            // 旧数据：明文密码，校验成功后应升级为哈希
+            bool const valid = password.size() == stored.size() &&
+                               CRYPTO_memcmp(password.data(), stored.data(), stored.size()) == 0;
+            needs_rehash = valid;
+            return valid;
+        }
+
+        ScryptParams stored_params;
+        unsigned char salt[salt_size];
+        unsigned char expected[key_size];
+        unsigned char key[key_size];
+        if (!parse(stored, stored_params, salt, expected))
+        {
+            LOG(ERROR) << "Malformed password hash";
+            return false;
+        }
+        if (!derive(password, salt, stored_params, key))
+        {
+            LOG(ERROR) << "scrypt failed";
+            return false;
+        }
+
+        bool const valid = CRYPTO_memcmp(key, expected, key_size) == 0;
+        needs_rehash = valid && (stored_params.log_n != params.log_n ||
+                                 stored_params.r != params.r ||
+                                 stored_params.p != params.p);
+        return valid;
+    }
+
+    PasswordHasher &PasswordHasher::getInstance()
+    {
+        static PasswordHasher instance;
+        return instance;
+    }
+
+    bool PasswordHasher::initialize(size_t threads, size_t max_queue, const ScryptParams &params)
+    {
+        if (pool_)
+        {
+            LOG(WARNING) << "Password hasher already initialized";
+            return false;
+        }
+
+        if (threads == 0)
+        {
+            threads = 1;
+        }
+        params_ = params;
+        max_queue_ = max_queue == 0 ? threads : max_queue;
+        pool_ = std::make_unique<boost::asio::thread_pool>(threads);
+
+        LOG(INFO) << "Password hasher initialized with " << threads << " threads, queue limit "
+                  << max_queue_ << ", scrypt ln=" << params.log_n << " r=" << params.r << " p=" << params.p;
+        return true;
+    }
+
+    void PasswordHasher::shutdown()
+    {
+        if (pool_)
+        {
+            pool_->join();
+            pool_.reset();
+        }
+    }
+
+    PasswordHasher::~PasswordHasher()
+    {
+        shutdown();
+    }
+
+    bool PasswordHasher::tryReserve()
+    {
+        if (!pool_)
+        {
+            return false;
+        }
+
+        auto queued = queued_.load(std::memory_order_relaxed);
+        do
+        {
+            if (queued >= max_queue_)
+            {
+                rejected_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!queued_.compare_exchange_weak(queued, queued + 1, std::memory_order_relaxed));
+        return true;
+    }
+
+    void PasswordHasher::post(std::function<void()> task)
+    {
+        boost::asio::post(*pool_, [this, task = std::move(task)]
+                          {
+                              try
+                              {
+                                  task();
+                              }
+                              catch (const std::exception &e)
+                              {
+                                  LOG(ERROR) << "Password hashing task failed: " << e.what();
+                              }
+                              release(); });
+    }
+
+} // namespace auth
@@ -0,0 +1,74 @@
+#ifndef PASSWORD_HASHER_HPP
+#define PASSWORD_HASHER_HPP
+
+#include <boost/asio/thread_pool.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace auth
+{
+    // scrypt 参数：N = 2^log_n，内存占用约 128 * r * N 字节
+    struct ScryptParams
+    {
+        unsigned log_n{15};
+        unsigned r{8};
+        unsigned p{1};
+    };
+
+    // 使用当前参数计算密码哈希，格式为 $scrypt$ln=15,r=8,p=1$<盐>$<哈希>（十六进制）
+    std::string hashPassword(const std::string &password, const ScryptParams &params);
+
+    // 校验密码，stored 为 hashPassword 的结果或旧的明文密码（比较均为常数时间）。
+    // needs_rehash 表示校验成功但存储的是明文或参数与 params 不同，应重新哈希
+    bool verifyPassword(const std::string &password, const std::string &stored,
+                        const ScryptParams &params, bool &needs_rehash);
+
+    // 密码哈希线程池：KDF 每次耗费数十毫秒 CPU，不能在 I/O 线程上执行。
+    // 线程数与排队任务数都有上限，队列已满时调用方应返回 503
+    class PasswordHasher
+    {
+    public:
+        static PasswordHasher &getInstance();
+
+        bool initialize(size_t threads, size_t max_queue, const ScryptParams &params);
+        void shutdown(); // 等待已提交的任务完成后停止线程
+
+        const ScryptParams &params() const { return params_; }
+
+        // 占用一个排队名额，队列已满或未初始化时返回 false
+        bool tryReserve();
+
+        // 在哈希线程上执行已占用名额的任务，任务结束后释放名额
+        void post(std::function<void()> task);
+
+        // 直接向线程池提交任务的调用方（协程版本）须先 tryReserve，结束后 release
+        boost::asio::thread_pool::executor_type get_executor() { return pool_->get_executor(); }
+        void release() { queued_.fetch_sub(1, std::memory_order_relaxed); }
+
+        std::string hash(const std::string &password) const { return hashPassword(password, params_); }
+        bool verify(const std::string &password, const std::string &stored, bool &needs_rehash) const
+        {
+            return verifyPassword(password, stored, params_, needs_rehash);
+        }
+
+        size_t queued() const { return queued_.load(std::memory_order_relaxed); }
+        uint64_t rejected() const { return rejected_.load(std::memory_order_relaxed); }
+
+    private:
+        PasswordHasher() = default;
+        ~PasswordHasher();
+
+        std::unique_ptr<boost::asio::thread_pool> pool_;
+        ScryptParams params_;
+        size_t max_queue_{0};
+        std::atomic<size_t> queued_{0};     // 已占用名额（排队中与执行中）的任务数
+        std::atomic<uint64_t> rejected_{0}; // 因队列已满被拒绝的次数
+    };
+
+} // namespace auth
+
+#endif // PASSWORD_HASHER_HPP
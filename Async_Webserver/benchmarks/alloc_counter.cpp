@@ -0,0 +1,80 @@
+// 替换全局 operator new/delete，按线程计数分配次数，供微基准报告每次迭代的分配数
+#include "alloc_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local std::uint64_t allocation_count = 0;
+
+    void *allocate(std::size_t size)
+    {
+        ++allocation_count;
+        if (void *p = std::malloc(size ? size : 1))
+        {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+
+    void *allocate_aligned(std::size_t size, std::align_val_t alignment)
+    {
+        ++allocation_count;
+        auto const align = static_cast<std::size_t>(alignment);
+        // aligned_alloc 要求大小是对齐值的倍数
+        if (void *p = std::aligned_alloc(align, (size + align - 1) / align * align))
+        {
+            return p;
+        }
+        throw std::bad_alloc();
+    }
+} // namespace
+
+namespace bench
+{
+    std::uint64_t allocations()
+    {
+        return allocation_count;
+    }
+} // namespace bench
+
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return allocate_aligned(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return allocate_aligned(size, alignment); }
+
+void *operator new(std::size_t size, std::nothrow_t const &) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, std::nothrow_t const &) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::nothrow_t const &) noexcept { std::free(p); }
+void operator delete[](void *p, std::nothrow_t const &) noexcept { std::free(p); }
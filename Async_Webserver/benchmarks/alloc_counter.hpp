@@ -0,0 +1,13 @@
+#ifndef ALLOC_COUNTER_HPP
+#define ALLOC_COUNTER_HPP
+
+#include <cstdint>
+
+namespace bench
+{
+    // 当前线程经全局 operator new 分配的次数（alloc_counter.cpp 替换了全局的 new/delete）
+    std::uint64_t allocations();
+
+} // namespace bench
+
+#endif // ALLOC_COUNTER_HPP
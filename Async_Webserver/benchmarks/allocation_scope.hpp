@@ -0,0 +1,41 @@
+#ifndef ALLOCATION_SCOPE_HPP
+#define ALLOCATION_SCOPE_HPP
+
+#include "alloc_counter.hpp"
+
+#include <benchmark/benchmark.h>
+
+namespace bench
+{
+    // 统计一个基准在计时循环中的分配次数，结束时以 allocs_per_iter 计数器报告每次迭代的平均值。
+    // 在计时循环之前构造，准备数据时的分配不计入。
+    // require_none 为 true 时（应当零分配的路径，须先预热一次），循环中出现任何分配都使基准失败
+    class allocation_scope
+    {
+    public:
+        explicit allocation_scope(benchmark::State &state, bool require_none = false)
+            : state_(state), start_(allocations()), require_none_(require_none) {}
+
+        ~allocation_scope()
+        {
+            auto const count = allocations() - start_;
+            state_.counters["allocs_per_iter"] = benchmark::Counter(
+                static_cast<double>(count), benchmark::Counter::kAvgIterations);
+            if (require_none_ && count != 0)
+            {
+                state_.SkipWithError("global heap allocation in a steady-state arena path");
+            }
+        }
+
+        allocation_scope(const allocation_scope &) = delete;
+        allocation_scope &operator=(const allocation_scope &) = delete;
+
+    private:
+        benchmark::State &state_;
+        std::uint64_t start_;
+        bool require_none_;
+    };
+
+} // namespace bench
+
+#endif // ALLOCATION_SCOPE_HPP
@@ -0,0 +1,39 @@
+#ifndef BENCH_DOC_ROOT_HPP
+#define BENCH_DOC_ROOT_HPP
+
+#include "../http_server/file_cache.hpp"
+
+#include <glog/logging.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+namespace bench
+{
+    // 基准共用的静态文件目录：第一次调用时在临时目录中生成，并启用文件缓存，与线上命中缓存的 GET 一致
+    inline std::string const &doc_root()
+    {
+        static std::string const root = []
+        {
+            char dir[] = "/tmp/microbench.XXXXXX";
+            if (!::mkdtemp(dir))
+            {
+                std::abort();
+            }
+            std::string root = dir;
+            std::ofstream(root + "/index.html") << "<!DOCTYPE html><html><head><title>bench</title></head><body>"
+                                                << std::string(2048, 'x') << "</body></html>\n";
+            std::ofstream(root + "/style.css") << "body { margin: 0; }\n";
+
+            // 错误响应会记录 WARNING，避免日志输出进入计时
+            FLAGS_minloglevel = google::GLOG_ERROR;
+            http_server::FileCache::getInstance().initialize(root, 64 * 1024 * 1024, 1024 * 1024, 4);
+            return root;
+        }();
+        return root;
+    }
+
+} // namespace bench
+
+#endif // BENCH_DOC_ROOT_HPP
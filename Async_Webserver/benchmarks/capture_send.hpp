@@ -0,0 +1,60 @@
+#ifndef CAPTURE_SEND_HPP
+#define CAPTURE_SEND_HPP
+
+#include "../http_server/http_server.hpp"
+
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/optional.hpp>
+
+#include <memory_resource>
+
+namespace http_server
+{
+    // 不经过 socket、在内存中调用 handle_request 时使用的 send（微基准与测试）。
+    // 与 session 相同，响应放入从 resource 分配的 response_generator，sendfile 响应单独保存；
+    // POST 路由在后台线程完成后把结果投递到 executor 上再调用 send。
+    // handle_request 对它的实例化只在以 -DHTTP_SERVER_CAPTURE_SEND 编译的 http_server_capture.o 中，
+    // 服务器本身不包含
+    struct capture_send
+    {
+        struct result
+        {
+            std::pmr::memory_resource *resource{nullptr};
+            boost::optional<response_generator> msg;
+            boost::optional<http::response<sendfile_body>> file;
+            unsigned status{0};
+
+            // 先销毁响应，再回收它们所在的内存
+            void clear()
+            {
+                msg.reset();
+                file.reset();
+                status = 0;
+            }
+        };
+
+        result *result_;
+        net::any_io_executor executor_;
+
+        template <bool isRequest, class Body, class Fields>
+        void operator()(http::message<isRequest, Body, Fields> &&msg) const
+        {
+            if constexpr (!isRequest)
+            {
+                result_->status = msg.result_int();
+            }
+            result_->msg.emplace(std::move(msg), result_->resource);
+        }
+
+        void operator()(http::response<sendfile_body> &&msg) const
+        {
+            result_->status = msg.result_int();
+            result_->file.emplace(std::move(msg));
+        }
+
+        net::any_io_executor get_executor() const { return executor_; }
+    };
+
+} // namespace http_server
+
+#endif // CAPTURE_SEND_HPP
@@ -0,0 +1,149 @@
+// 表单解析的微基准：与原来基于 boost::split + std::map 的实现对比
+#include "allocation_scope.hpp"
+#include "../http_server/form_parser.hpp"
+
+#include <benchmark/benchmark.h>
+#include <boost/algorithm/string.hpp>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // 原来的 parse_form_data，作为对比基线
+    std::map<std::string, std::string> legacy_parse(std::string const &body)
+    {
+        std::map<std::string, std::string> data;
+        std::vector<std::string> pairs;
+        boost::split(pairs, body, boost::is_any_of("&"));
+
+        for (const auto &pair : pairs)
+        {
+            std::vector<std::string> kv;
+            boost::split(kv, pair, boost::is_any_of("="));
+            if (kv.size() == 2)
+            {
+                std::string decoded;
+                auto const &value = kv[1];
+                for (size_t i = 0; i < value.length(); ++i)
+                {
+                    if (value[i] == '%' && i + 2 < value.length())
+                    {
+                        int hex_val;
+                        std::stringstream ss;
+                        ss << std::hex << value.substr(i + 1, 2);
+                        ss >> hex_val;
+                        decoded += static_cast<char>(hex_val);
+                        i += 2;
+                    }
+                    else if (value[i] == '+')
+                    {
+                        decoded += ' ';
+                    }
+                    else
+                    {
+                        decoded += value[i];
+                    }
+                }
+                data[kv[0]] = decoded;
+            }
+        }
+        return data;
+    }
+
+    std::string const login_body = "username=alice%40example.com&password=correct+horse+battery+staple";
+
+    std::string const register_body =
+        "username=alice&password=p%40ss%21word&phone=%2B86+138+0000+0000";
+
+    // 一个较长的值：大段普通字符中夹少量转义
+    std::string large_body()
+    {
+        std::string body = "username=alice&comment=";
+        for (int i = 0; i < 256; ++i)
+        {
+            body += "lorem_ipsum_dolor_sit_amet_consectetur_adipiscing%2C";
+        }
+        body += "&password=secret";
+        return body;
+    }
+
+    std::string const multipart_type = "multipart/form-data; boundary=----bench";
+
+    std::string const multipart_body =
+        "------bench\r\n"
+        "Content-Disposition: form-data; name=\"username\"\r\n\r\n"
+        "alice\r\n"
+        "------bench\r\n"
+        "Content-Disposition: form-data; name=\"password\"\r\n\r\n"
+        "p@ss word\r\n"
+        "------bench\r\n"
+        "Content-Disposition: form-data; name=\"phone\"\r\n\r\n"
+        "+86 138 0000 0000\r\n"
+        "------bench--\r\n";
+
+    std::string const json_body =
+        R"({"username": "alice", "password": "p@ss word", "phone": "+86 138 0000 0000", "remember": true})";
+
+    // 解析会就地修改输入，每次迭代先复制回原文（两种实现都包含这次复制）
+    void run_parser(benchmark::State &state, std::string const &content_type, std::string const &body)
+    {
+        std::string buffer = body;
+        http_server::form_data form;
+        bench::allocation_scope allocs(state);
+        for (auto _ : state)
+        {
+            buffer.assign(body);
+            form.clear();
+            bool ok = http_server::parse_form(content_type, buffer.data(), buffer.size(), form);
+            benchmark::DoNotOptimize(ok);
+            benchmark::DoNotOptimize(form);
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * body.size()));
+    }
+
+    void run_legacy(benchmark::State &state, std::string const &body)
+    {
+        std::string buffer = body;
+        bench::allocation_scope allocs(state);
+        for (auto _ : state)
+        {
+            buffer.assign(body);
+            auto data = legacy_parse(buffer);
+            benchmark::DoNotOptimize(data);
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * body.size()));
+    }
+
+    void BM_LegacyLogin(benchmark::State &state) { run_legacy(state, login_body); }
+    void BM_UrlencodedLogin(benchmark::State &state)
+    {
+        run_parser(state, "application/x-www-form-urlencoded", login_body);
+    }
+
+    void BM_LegacyRegister(benchmark::State &state) { run_legacy(state, register_body); }
+    void BM_UrlencodedRegister(benchmark::State &state)
+    {
+        run_parser(state, "application/x-www-form-urlencoded", register_body);
+    }
+
+    void BM_LegacyLarge(benchmark::State &state) { run_legacy(state, large_body()); }
+    void BM_UrlencodedLarge(benchmark::State &state)
+    {
+        run_parser(state, "application/x-www-form-urlencoded", large_body());
+    }
+
+    void BM_Multipart(benchmark::State &state) { run_parser(state, multipart_type, multipart_body); }
+    void BM_Json(benchmark::State &state) { run_parser(state, "application/json", json_body); }
+} // namespace
+
+BENCHMARK(BM_LegacyLogin);
+BENCHMARK(BM_UrlencodedLogin);
+BENCHMARK(BM_LegacyRegister);
+BENCHMARK(BM_UrlencodedRegister);
+BENCHMARK(BM_LegacyLarge);
+BENCHMARK(BM_UrlencodedLarge);
+BENCHMARK(BM_Multipart);
+BENCHMARK(BM_Json);
@@ -0,0 +1,140 @@
+#ifndef HDR_HISTOGRAM_HPP
+#define HDR_HISTOGRAM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace bench
+{
+    // HDR（High Dynamic Range）直方图：在 [1, highest] 范围内以固定的有效数字精度记录数值，
+    // 与 HdrHistogram 的布局相同——每个桶是上一个的两倍宽，桶内等分为 sub_bucket_count 格，
+    // 记录与查询分位数都不排序，内存只与范围和精度有关。
+    // 不是线程安全的，每个线程一个，结束时 merge
+    class hdr_histogram
+    {
+    public:
+        explicit hdr_histogram(std::uint64_t highest = 60'000'000'000ull, int significant_digits = 3)
+            : highest_(highest)
+        {
+            // 覆盖 2 * 10^digits 所需的格数，向上取 2 的幂
+            auto const largest_single_unit = static_cast<std::uint64_t>(2 * std::pow(10, significant_digits));
+            int magnitude = 0;
+            while ((std::uint64_t{1} << magnitude) < largest_single_unit)
+            {
+                ++magnitude;
+            }
+            sub_bucket_half_count_magnitude_ = magnitude - 1;
+            sub_bucket_count_ = std::uint64_t{1} << magnitude;
+            sub_bucket_half_count_ = sub_bucket_count_ / 2;
+            sub_bucket_mask_ = sub_bucket_count_ - 1;
+
+            int buckets = 1;
+            for (auto smallest_untrackable = sub_bucket_count_; smallest_untrackable <= highest;
+                 smallest_untrackable <<= 1)
+            {
+                ++buckets;
+            }
+            counts_.assign(static_cast<std::size_t>(buckets + 1) * sub_bucket_half_count_, 0);
+        }
+
+        // 超出范围的值按上限记录
+        void record(std::uint64_t value)
+        {
+            value = std::clamp<std::uint64_t>(value, 1, highest_);
+            ++counts_[index_of(value)];
+            ++total_;
+            min_ = std::min(min_, value);
+            max_ = std::max(max_, value);
+            sum_ += static_cast<double>(value);
+        }
+
+        void merge(hdr_histogram const &other)
+        {
+            for (std::size_t i = 0; i < counts_.size() && i < other.counts_.size(); ++i)
+            {
+                counts_[i] += other.counts_[i];
+            }
+            total_ += other.total_;
+            min_ = std::min(min_, other.min_);
+            max_ = std::max(max_, other.max_);
+            sum_ += other.sum_;
+        }
+
+        std::uint64_t count() const { return total_; }
+        std::uint64_t min() const { return total_ ? min_ : 0; }
+        std::uint64_t max() const { return max_; }
+        double mean() const { return total_ ? sum_ / static_cast<double>(total_) : 0; }
+
+        // 第 p 百分位（0 < p <= 100），返回所在格的上界
+        std::uint64_t percentile(double p) const
+        {
+            if (total_ == 0)
+            {
+                return 0;
+            }
+            auto const target = std::max<std::uint64_t>(
+                1, static_cast<std::uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total_))));
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < counts_.size(); ++i)
+            {
+                seen += counts_[i];
+                if (seen >= target)
+                {
+                    return std::min(highest_equivalent(value_at(i)), max_);
+                }
+            }
+            return max_;
+        }
+
+    private:
+        int bucket_index(std::uint64_t value) const
+        {
+            // 有效位数，小于 sub_bucket_count 的值都在第 0 个桶
+            auto const bits = 64 - __builtin_clzll(value | sub_bucket_mask_);
+            return bits - (sub_bucket_half_count_magnitude_ + 1);
+        }
+
+        std::size_t index_of(std::uint64_t value) const
+        {
+            auto const bucket = bucket_index(value);
+            auto const sub_bucket = value >> bucket;
+            return static_cast<std::size_t>((static_cast<std::uint64_t>(bucket + 1) << sub_bucket_half_count_magnitude_) +
+                                            (sub_bucket - sub_bucket_half_count_));
+        }
+
+        std::uint64_t value_at(std::size_t index) const
+        {
+            auto bucket = static_cast<int>(index >> sub_bucket_half_count_magnitude_) - 1;
+            auto sub_bucket = (index & (sub_bucket_half_count_ - 1)) + sub_bucket_half_count_;
+            if (bucket < 0)
+            {
+                sub_bucket -= sub_bucket_half_count_;
+                bucket = 0;
+            }
+            return static_cast<std::uint64_t>(sub_bucket) << bucket;
+        }
+
+        // 与 value 落在同一格的最大值
+        std::uint64_t highest_equivalent(std::uint64_t value) const
+        {
+            return value + (std::uint64_t{1} << bucket_index(value)) - 1;
+        }
+
+        std::uint64_t highest_;
+        int sub_bucket_half_count_magnitude_{0};
+        std::uint64_t sub_bucket_count_{0};
+        std::uint64_t sub_bucket_half_count_{0};
+        std::uint64_t sub_bucket_mask_{0};
+        std::vector<std::uint64_t> counts_;
+        std::uint64_t total_{0};
+        std::uint64_t min_{std::numeric_limits<std::uint64_t>::max()};
+        std::uint64_t max_{0};
+        double sum_{0};
+    };
+
+} // namespace bench
+
+#endif // HDR_HISTOGRAM_HPP
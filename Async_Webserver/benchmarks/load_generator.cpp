@@ -0,0 +1,692 @@
+// HTTP 负载生成器：多连接、可选管线化与短连接，按场景压测服务器，
+// 输出 RPS 与延迟的 HDR 直方图分位数，并写成 JSON 供不同提交之间比较。
+//
+//   ./benchmarks/load_generator --scenario=get --connections=64 --pipeline=8 --output=results/get.json
+//
+// 场景：get（静态 GET）、head、404、login、register、large（大文件，走 sendfile）。
+// 每个线程一个 io_context，连接平均分配到各线程；统计按线程分开，结束时合并
+#include "hdr_histogram.hpp"
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+using clock_type = std::chrono::steady_clock;
+
+namespace
+{
+    enum class scenario
+    {
+        get,
+        head,
+        not_found,
+        login,
+        reg,
+        large,
+    };
+
+    struct options
+    {
+        std::string host = "127.0.0.1";
+        std::string port = "8080";
+        scenario kind = scenario::get;
+        std::string scenario_name = "get";
+        std::string target; // 为空时使用场景的缺省路径
+        std::size_t connections = 64;
+        std::size_t pipeline = 1; // 每批连续发送的请求数，只在保持连接时有效
+        bool keep_alive = true;
+        std::size_t threads = 2;
+        double duration = 10; // 秒
+        double warmup = 2;    // 秒，期间的请求不计入结果
+        std::string user = "benchuser";
+        std::string password = "benchpass";
+        std::string output; // JSON 结果文件，为空时不写
+        std::string label;  // 写入结果，用于区分提交或服务器配置
+        long server_pid = 0; // 非 0 时统计服务器进程在测量期间的 CPU 时间
+    };
+
+    // 测量阶段：预热、测量、停止（不再发出新请求）
+    enum class phase
+    {
+        warmup,
+        measure,
+        stop,
+    };
+
+    std::atomic<phase> current_phase{phase::warmup};
+
+    struct thread_stats
+    {
+        bench::hdr_histogram latency; // 纳秒
+        std::uint64_t requests = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t errors = 0;     // 连接、读写错误
+        std::uint64_t unexpected = 0; // 状态码或重定向目标与场景不符
+        std::map<unsigned, std::uint64_t> statuses;
+    };
+
+    std::string default_target(scenario kind)
+    {
+        switch (kind)
+        {
+        case scenario::not_found:
+            return "/does-not-exist.html";
+        case scenario::login:
+            return "/login";
+        case scenario::reg:
+            return "/register";
+        case scenario::large:
+            return "/large.bin";
+        default:
+            return "/index.html";
+        }
+    }
+
+    // 为一个连接生成请求；注册场景每个请求的用户名与手机号都不同
+    class request_source
+    {
+    public:
+        request_source(options const &opt, std::uint64_t run_id, std::size_t thread, std::size_t conn)
+            : opt_(opt), run_id_(run_id), thread_(thread), conn_(conn)
+        {
+            target_ = opt.target.empty() ? default_target(opt.kind) : opt.target;
+        }
+
+        void append(std::string &out, bool close)
+        {
+            switch (opt_.kind)
+            {
+            case scenario::head:
+                append_request(out, "HEAD", target_, {}, close);
+                break;
+            case scenario::login:
+                append_request(out, "POST", target_, "username=" + opt_.user + "&password=" + opt_.password, close);
+                break;
+            case scenario::reg:
+            {
+                // 用户名不超过 50 字符、手机号不超过 20 位，run_id 区分多次运行
+                std::ostringstream username, phone;
+                username << "b" << run_id_ << "_" << thread_ << "_" << conn_ << "_" << sequence_;
+                phone << std::setfill('0') << std::setw(6) << run_id_ % 1000000
+                      << std::setw(2) << thread_ % 100
+                      << std::setw(4) << conn_ % 10000
+                      << std::setw(8) << sequence_ % 100000000;
+                ++sequence_;
+                append_request(out, "POST", target_,
+                               "username=" + username.str() + "&password=" + opt_.password + "&phone=" + phone.str(),
+                               close);
+                break;
+            }
+            default:
+                append_request(out, "GET", target_, {}, close);
+                break;
+            }
+        }
+
+    private:
+        void append_request(std::string &out, char const *method, std::string const &target,
+                            std::string const &body, bool close) const
+        {
+            out += method;
+            out += ' ';
+            out += target;
+            out += " HTTP/1.1\r\nHost: ";
+            out += opt_.host;
+            out += "\r\nUser-Agent: load_generator\r\n";
+            if (close)
+            {
+                out += "Connection: close\r\n";
+            }
+            if (!body.empty())
+            {
+                out += "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: ";
+                out += std::to_string(body.size());
+                out += "\r\n";
+            }
+            out += "\r\n";
+            out += body;
+        }
+
+        options const &opt_;
+        std::uint64_t run_id_;
+        std::size_t thread_;
+        std::size_t conn_;
+        std::uint64_t sequence_ = 0;
+        std::string target_;
+    };
+
+    // 响应是否符合场景的预期
+    bool expected(scenario kind, http::response<http::string_body> const &res)
+    {
+        auto const location = res[http::field::location];
+        switch (kind)
+        {
+        case scenario::not_found:
+            return res.result() == http::status::not_found;
+        case scenario::login:
+            return res.result() == http::status::see_other && location == "/welcome.html";
+        case scenario::reg:
+            return res.result() == http::status::see_other && location == "/?success=registration";
+        default:
+            return res.result() == http::status::ok;
+        }
+    }
+
+    class connection : public std::enable_shared_from_this<connection>
+    {
+    public:
+        connection(net::io_context &ioc, tcp::resolver::results_type const &endpoints, options const &opt,
+                   thread_stats &stats, request_source source)
+            : endpoints_(endpoints), opt_(opt), stats_(stats), source_(std::move(source)),
+              stream_(ioc), retry_timer_(ioc)
+        {
+        }
+
+        void run() { do_connect(); }
+
+    private:
+        void do_connect()
+        {
+            if (current_phase.load(std::memory_order_relaxed) == phase::stop)
+            {
+                return;
+            }
+            connect_start_ = clock_type::now();
+            stream_.expires_after(std::chrono::seconds(10));
+            stream_.async_connect(endpoints_, beast::bind_front_handler(&connection::on_connect, shared_from_this()));
+        }
+
+        void on_connect(beast::error_code ec, tcp::endpoint)
+        {
+            if (ec)
+            {
+                return fail(ec);
+            }
+            stream_.socket().set_option(tcp::no_delay(true), ec);
+            send_batch();
+        }
+
+        void send_batch()
+        {
+            if (current_phase.load(std::memory_order_relaxed) == phase::stop)
+            {
+                return close();
+            }
+
+            // 短连接每个连接只发一个请求，延迟从开始建立连接算起
+            auto const depth = opt_.keep_alive ? opt_.pipeline : 1;
+            auto const now = clock_type::now();
+            out_.clear();
+            sent_.clear();
+            for (std::size_t i = 0; i < depth; ++i)
+            {
+                source_.append(out_, !opt_.keep_alive);
+                sent_.push_back(opt_.keep_alive ? now : connect_start_);
+            }
+            next_ = 0;
+
+            stream_.expires_after(std::chrono::seconds(30));
+            net::async_write(stream_, net::buffer(out_),
+                             beast::bind_front_handler(&connection::on_write, shared_from_this()));
+        }
+
+        void on_write(beast::error_code ec, std::size_t)
+        {
+            if (ec)
+            {
+                return fail(ec);
+            }
+            read_response();
+        }
+
+        void read_response()
+        {
+            parser_.emplace();
+            parser_->body_limit(std::uint64_t{1} << 32);
+            if (opt_.kind == scenario::head)
+            {
+                parser_->skip(true); // HEAD 响应有 Content-Length 但没有正文
+            }
+            http::async_read(stream_, buffer_, *parser_,
+                             beast::bind_front_handler(&connection::on_read, shared_from_this()));
+        }
+
+        void on_read(beast::error_code ec, std::size_t bytes_transferred)
+        {
+            if (ec)
+            {
+                return fail(ec);
+            }
+
+            auto const &res = parser_->get();
+            if (current_phase.load(std::memory_order_relaxed) == phase::measure)
+            {
+                stats_.latency.record(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - sent_[next_]).count()));
+                ++stats_.requests;
+                stats_.bytes += bytes_transferred;
+                ++stats_.statuses[res.result_int()];
+                if (!expected(opt_.kind, res))
+                {
+                    ++stats_.unexpected;
+                }
+            }
+
+            bool const keep_alive = res.keep_alive();
+            if (++next_ < sent_.size())
+            {
+                if (!keep_alive)
+                {
+                    // 服务器提前关闭连接，本批其余请求作废
+                    ++stats_.errors;
+                    return reconnect();
+                }
+                return read_response();
+            }
+
+            if (!opt_.keep_alive || !keep_alive)
+            {
+                return reconnect();
+            }
+            send_batch();
+        }
+
+        void fail(beast::error_code)
+        {
+            if (current_phase.load(std::memory_order_relaxed) == phase::stop)
+            {
+                return close();
+            }
+            ++stats_.errors;
+
+            // 稍后重连，避免服务器拒绝连接时空转
+            close();
+            retry_timer_.expires_after(std::chrono::milliseconds(50));
+            retry_timer_.async_wait(
+                [self = shared_from_this()](beast::error_code ec)
+                {
+                    if (!ec)
+                    {
+                        self->do_connect();
+                    }
+                });
+        }
+
+        void reconnect()
+        {
+            close();
+            do_connect();
+        }
+
+        void close()
+        {
+            beast::error_code ec;
+            stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
+            stream_.close();
+            buffer_.consume(buffer_.size());
+        }
+
+        tcp::resolver::results_type const &endpoints_;
+        options const &opt_;
+        thread_stats &stats_;
+        request_source source_;
+        beast::tcp_stream stream_;
+        net::steady_timer retry_timer_;
+        beast::flat_buffer buffer_;
+        std::string out_;
+        std::vector<clock_type::time_point> sent_; // 本批各请求的发送时间
+        std::size_t next_ = 0;                     // 下一个待读取响应的下标
+        boost::optional<http::response_parser<http::string_body>> parser_;
+        clock_type::time_point connect_start_;
+    };
+
+    // 同步发送一个请求，用于准备登录用户
+    http::response<http::string_body> send_once(options const &opt, tcp::resolver::results_type const &endpoints,
+                                                http::verb method, std::string const &target, std::string const &body)
+    {
+        net::io_context ioc;
+        beast::tcp_stream stream(ioc);
+        stream.connect(endpoints);
+
+        http::request<http::string_body> req{method, target, 11};
+        req.set(http::field::host, opt.host);
+        req.set(http::field::content_type, "application/x-www-form-urlencoded");
+        req.body() = body;
+        req.prepare_payload();
+        http::write(stream, req);
+
+        beast::flat_buffer buffer;
+        http::response<http::string_body> res;
+        http::read(stream, buffer, res);
+
+        beast::error_code ec;
+        stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+        return res;
+    }
+
+    // 登录场景需要一个已存在的用户：先注册（已存在时服务器返回冲突的重定向），再确认能登录
+    bool prepare_login_user(options const &opt, tcp::resolver::results_type const &endpoints)
+    {
+        std::ostringstream phone;
+        phone << "1" << std::setfill('0') << std::setw(10) << std::hash<std::string>{}(opt.user) % 10000000000ull;
+        send_once(opt, endpoints, http::verb::post, "/register",
+                  "username=" + opt.user + "&password=" + opt.password + "&phone=" + phone.str());
+
+        auto const res = send_once(opt, endpoints, http::verb::post, "/login",
+                                   "username=" + opt.user + "&password=" + opt.password);
+        if (!expected(scenario::login, res))
+        {
+            std::cerr << "User " << opt.user << " cannot log in (status " << res.result_int()
+                      << ", location " << res[http::field::location] << ")\n";
+            return false;
+        }
+        return true;
+    }
+
+    // /proc/<pid>/stat 中的 utime + stime，单位秒
+    double process_cpu_seconds(long pid)
+    {
+        std::ifstream in("/proc/" + std::to_string(pid) + "/stat");
+        std::string stat((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        auto const end = stat.rfind(')');
+        if (end == std::string::npos)
+        {
+            return 0;
+        }
+
+        // ')' 之后依次为 state(3) ... utime(14) stime(15)
+        std::istringstream fields(stat.substr(end + 2));
+        std::string field;
+        unsigned long long utime = 0, stime = 0;
+        for (int i = 3; i <= 15 && fields >> field; ++i)
+        {
+            if (i == 14)
+                utime = std::stoull(field);
+            else if (i == 15)
+                stime = std::stoull(field);
+        }
+        return static_cast<double>(utime + stime) / static_cast<double>(::sysconf(_SC_CLK_TCK));
+    }
+
+    bool parse_scenario(std::string const &name, scenario &kind)
+    {
+        static const std::map<std::string, scenario> names = {
+            {"get", scenario::get}, {"head", scenario::head}, {"404", scenario::not_found},
+            {"login", scenario::login}, {"register", scenario::reg}, {"large", scenario::large}};
+        auto it = names.find(name);
+        if (it == names.end())
+        {
+            return false;
+        }
+        kind = it->second;
+        return true;
+    }
+
+    void usage(char const *program)
+    {
+        std::cerr << "Usage: " << program << " [--option=value ...]\n"
+                  << "  --host=127.0.0.1 --port=8080\n"
+                  << "  --scenario=get|head|404|login|register|large  --target=PATH\n"
+                  << "  --connections=64 --pipeline=1 --keep-alive=1 --threads=2\n"
+                  << "  --duration=10 --warmup=2 (seconds)\n"
+                  << "  --user=benchuser --password=benchpass (login scenario)\n"
+                  << "  --server-pid=PID (report server CPU time)\n"
+                  << "  --output=FILE.json --label=TEXT\n";
+    }
+
+    bool parse_options(int argc, char *argv[], options &opt)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            auto const eq = arg.find('=');
+            if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            {
+                return false;
+            }
+            auto const name = arg.substr(2, eq - 2);
+            auto const value = arg.substr(eq + 1);
+            try
+            {
+                if (name == "host")
+                    opt.host = value;
+                else if (name == "port")
+                    opt.port = value;
+                else if (name == "scenario")
+                {
+                    opt.scenario_name = value;
+                    if (!parse_scenario(value, opt.kind))
+                        return false;
+                }
+                else if (name == "target")
+                    opt.target = value;
+                else if (name == "connections")
+                    opt.connections = std::stoul(value);
+                else if (name == "pipeline")
+                    opt.pipeline = std::max<std::size_t>(std::stoul(value), 1);
+                else if (name == "keep-alive")
+                    opt.keep_alive = value != "0" && value != "false";
+                else if (name == "threads")
+                    opt.threads = std::max<std::size_t>(std::stoul(value), 1);
+                else if (name == "duration")
+                    opt.duration = std::stod(value);
+                else if (name == "warmup")
+                    opt.warmup = std::stod(value);
+                else if (name == "user")
+                    opt.user = value;
+                else if (name == "password")
+                    opt.password = value;
+                else if (name == "output")
+                    opt.output = value;
+                else if (name == "label")
+                    opt.label = value;
+                else if (name == "server-pid")
+                    opt.server_pid = std::stol(value);
+                else
+                    return false;
+            }
+            catch (const std::exception &)
+            {
+                return false;
+            }
+        }
+        return opt.connections > 0 && opt.duration > 0;
+    }
+
+    std::string json_escape(std::string const &s)
+    {
+        std::string out;
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20)
+                out += c;
+        }
+        return out;
+    }
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    options opt;
+    if (!parse_options(argc, argv, opt))
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    tcp::resolver::results_type endpoints;
+    try
+    {
+        net::io_context ioc;
+        endpoints = tcp::resolver(ioc).resolve(opt.host, opt.port);
+        if (opt.kind == scenario::login && !prepare_login_user(opt, endpoints))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Cannot reach " << opt.host << ":" << opt.port << ": " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    auto const run_id = static_cast<std::uint64_t>(std::time(nullptr)) % 1000000;
+    opt.threads = std::min(opt.threads, opt.connections);
+
+    std::vector<std::unique_ptr<net::io_context>> contexts;
+    std::vector<std::unique_ptr<thread_stats>> stats;
+    for (std::size_t t = 0; t < opt.threads; ++t)
+    {
+        contexts.push_back(std::make_unique<net::io_context>(1));
+        stats.push_back(std::make_unique<thread_stats>());
+    }
+    for (std::size_t c = 0; c < opt.connections; ++c)
+    {
+        auto const t = c % opt.threads;
+        std::make_shared<connection>(*contexts[t], endpoints, opt, *stats[t],
+                                     request_source(opt, run_id, t, c))
+            ->run();
+    }
+
+    std::vector<std::thread> threads;
+    for (auto &ioc : contexts)
+    {
+        threads.emplace_back([&ioc]
+                             { ioc->run(); });
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(opt.warmup));
+    double const cpu_start = opt.server_pid ? process_cpu_seconds(opt.server_pid) : 0;
+    auto const start = clock_type::now();
+    current_phase.store(phase::measure);
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(opt.duration));
+    current_phase.store(phase::stop);
+    auto const elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+    double const cpu_seconds = opt.server_pid ? process_cpu_seconds(opt.server_pid) - cpu_start : 0;
+
+    // 给进行中的请求一点时间完成，然后强制结束
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    for (auto &ioc : contexts)
+    {
+        ioc->stop();
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    thread_stats total;
+    for (auto const &s : stats)
+    {
+        total.latency.merge(s->latency);
+        total.requests += s->requests;
+        total.bytes += s->bytes;
+        total.errors += s->errors;
+        total.unexpected += s->unexpected;
+        for (auto const &[status, n] : s->statuses)
+        {
+            total.statuses[status] += n;
+        }
+    }
+
+    auto const rps = static_cast<double>(total.requests) / elapsed;
+    auto const us = [&total](double p)
+    { return static_cast<double>(total.latency.percentile(p)) / 1000.0; };
+    struct percentile_entry
+    {
+        char const *name;
+        double value;
+    };
+    percentile_entry const percentiles[] = {
+        {"p50", us(50)}, {"p90", us(90)}, {"p99", us(99)}, {"p999", us(99.9)}, {"p9999", us(99.99)}};
+
+    std::cout << std::fixed << std::setprecision(1)
+              << opt.scenario_name << ": " << opt.connections << " connections, pipeline " << opt.pipeline
+              << (opt.keep_alive ? "" : ", no keep-alive") << ", " << elapsed << " s\n"
+              << "  requests " << total.requests << "  errors " << total.errors
+              << "  unexpected " << total.unexpected << "\n"
+              << "  " << rps << " req/s  " << static_cast<double>(total.bytes) / elapsed / (1 << 20) << " MiB/s\n"
+              << "  latency (us): mean " << total.latency.mean() / 1000.0;
+    for (auto const &p : percentiles)
+    {
+        std::cout << "  " << p.name << " " << p.value;
+    }
+    std::cout << "  max " << static_cast<double>(total.latency.max()) / 1000.0 << "\n";
+    if (opt.server_pid)
+    {
+        std::cout << "  server CPU " << cpu_seconds << " s\n";
+    }
+
+    if (!opt.output.empty())
+    {
+        std::ofstream out(opt.output);
+        out << std::fixed << std::setprecision(3)
+            << "{\n"
+            << "  \"label\": \"" << json_escape(opt.label) << "\",\n"
+            << "  \"scenario\": \"" << json_escape(opt.scenario_name) << "\",\n"
+            << "  \"target\": \"" << json_escape(opt.target.empty() ? default_target(opt.kind) : opt.target) << "\",\n"
+            << "  \"connections\": " << opt.connections << ",\n"
+            << "  \"pipeline\": " << opt.pipeline << ",\n"
+            << "  \"keep_alive\": " << (opt.keep_alive ? "true" : "false") << ",\n"
+            << "  \"threads\": " << opt.threads << ",\n"
+            << "  \"duration_s\": " << elapsed << ",\n"
+            << "  \"requests\": " << total.requests << ",\n"
+            << "  \"errors\": " << total.errors << ",\n"
+            << "  \"unexpected\": " << total.unexpected << ",\n"
+            << "  \"rps\": " << rps << ",\n"
+            << "  \"bytes\": " << total.bytes << ",\n"
+            << "  \"bytes_per_s\": " << static_cast<double>(total.bytes) / elapsed << ",\n"
+            << "  \"status\": {";
+        bool first = true;
+        for (auto const &[status, n] : total.statuses)
+        {
+            out << (first ? "" : ", ") << "\"" << status << "\": " << n;
+            first = false;
+        }
+        out << "},\n"
+            << "  \"latency_us\": {\"min\": " << static_cast<double>(total.latency.min()) / 1000.0
+            << ", \"mean\": " << total.latency.mean() / 1000.0;
+        for (auto const &p : percentiles)
+        {
+            out << ", \"" << p.name << "\": " << p.value;
+        }
+        out << ", \"max\": " << static_cast<double>(total.latency.max()) / 1000.0 << "}";
+        if (opt.server_pid)
+        {
+            auto const gb = static_cast<double>(total.bytes) / 1e9;
+            out << ",\n  \"server_cpu_s\": " << cpu_seconds
+                << ",\n  \"server_cpu_s_per_gb\": " << (gb > 0 ? cpu_seconds / gb : 0.0);
+        }
+        out << "\n}\n";
+    }
+
+    return total.requests > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
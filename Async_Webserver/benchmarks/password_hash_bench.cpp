@@ -0,0 +1,46 @@
+// 密码哈希的微基准：不同 scrypt 参数下 auth::hashPassword 的吞吐（hashes/s），
+// 用于为 auth.scrypt_log_n / scrypt_r / scrypt_p 选择参数，并估算哈希线程池的容量
+// （每个哈希线程每秒可处理的登录、注册数约等于这里的 hashes/s）
+#include "../auth/password_hasher.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <exception>
+#include <string>
+
+namespace
+{
+    // 参数：log_n, r, p
+    void BM_HashPassword(benchmark::State &state)
+    {
+        auth::ScryptParams const params{static_cast<unsigned>(state.range(0)),
+                                        static_cast<unsigned>(state.range(1)),
+                                        static_cast<unsigned>(state.range(2))};
+        std::string const password = "correct horse battery staple";
+        try
+        {
+            for (auto _ : state)
+            {
+                benchmark::DoNotOptimize(auth::hashPassword(password, params));
+            }
+        }
+        catch (std::exception const &e)
+        {
+            state.SkipWithError(e.what());
+            return;
+        }
+        state.counters["hashes_per_sec"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                              benchmark::Counter::kIsRate);
+        state.counters["mem_kib"] = static_cast<double>(128 * std::uint64_t(params.r) << params.log_n) / 1024;
+    }
+} // namespace
+
+// 每次哈希耗时数十毫秒，按真实时间计时，迭代次数由 Google Benchmark 决定
+BENCHMARK(BM_HashPassword)
+    ->ArgNames({"log_n", "r", "p"})
+    ->ArgsProduct({{10, 12, 14, 15, 16}, {8}, {1, 2}})
+    ->Args({14, 16, 1})
+    ->Args({15, 16, 1})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
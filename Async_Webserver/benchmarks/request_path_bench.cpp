@@ -0,0 +1,240 @@
+// 请求热路径的微基准：MIME 类型查找、路径拼接、请求目标处理、请求体解析、
+// 内存中的请求经 handle_request 生成响应，以及错误响应的构造。
+// 每个基准都报告每次迭代的分配次数（allocs_per_iter），这些函数的退化先体现为这里的数字。
+// 处理器通过 capture_send 在内存中调用（链接以 -DHTTP_SERVER_CAPTURE_SEND 编译的 http_server_capture.o）
+#include "allocation_scope.hpp"
+#include "bench_doc_root.hpp"
+#include "capture_send.hpp"
+#include "../http_server/http_server.hpp"
+#include "../http_server/mime_types.hpp"
+
+#include <benchmark/benchmark.h>
+#include <boost/asio/io_context.hpp>
+#include <glog/logging.h>
+
+#include <iterator>
+#include <string>
+
+namespace
+{
+    using namespace http_server;
+
+    // 与 session 相同：请求头、请求体从 arena 分配，arena 每次迭代复用
+    arena_request make_request(request_arena &arena, http::verb method, beast::string_view target)
+    {
+        auto const alloc = arena.allocator();
+        arena_request req(std::piecewise_construct, std::make_tuple(alloc), std::make_tuple(alloc));
+        req.method(method);
+        req.target(target);
+        req.version(11);
+        req.set(http::field::host, "localhost:8080");
+        req.set(http::field::user_agent, "microbench");
+        req.set(http::field::accept, "text/html,application/xhtml+xml,*/*;q=0.8");
+        return req;
+    }
+
+    // POST 路由才会把结果投递回 send 的 executor，基准只走 GET/HEAD，不会真正用到
+    net::any_io_executor bench_executor()
+    {
+        static net::io_context ioc;
+        return ioc.get_executor();
+    }
+
+    // 像 session 一样把响应序列化到 socket 缓冲区之前为止，返回字节数
+    std::size_t serialize(capture_send::result &result)
+    {
+        std::size_t bytes = 0;
+        if (!result.msg)
+        {
+            return bytes;
+        }
+        beast::error_code ec;
+        while (!result.msg->is_done())
+        {
+            std::size_t n = 0;
+            for (auto const &b : result.msg->prepare(ec))
+            {
+                n += b.size();
+            }
+            if (ec)
+            {
+                break;
+            }
+            result.msg->consume(n);
+            bytes += n;
+        }
+        return bytes;
+    }
+
+    void BM_MimeType(benchmark::State &state)
+    {
+        auto const &mime = MimeTypes::getInstance();
+        std::string_view const paths[] = {"/index.html", "/css/style.css", "/js/app.min.js", "/img/logo.PNG",
+                                          "/fonts/a.woff2", "/download/archive.unknown", "/README"};
+        bench::allocation_scope allocs(state);
+        for (auto _ : state)
+        {
+            for (auto path : paths)
+            {
+                benchmark::DoNotOptimize(&mime.lookup(path));
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * std::size(paths)));
+    }
+
+    void BM_PathCat(benchmark::State &state)
+    {
+        bench::allocation_scope allocs(state);
+        for (auto _ : state)
+        {
+            auto path = path_cat("/var/www/html/", "/assets/css/style.css");
+            benchmark::DoNotOptimize(path);
+        }
+    }
+
+    void BM_PathCatArena(benchmark::State &state)
+    {
+        request_arena arena;
+        bench::allocation_scope allocs(state);
+        for (auto _ : state)
+        {
+            arena.reset();
+            auto path = path_cat("/var/www/html/", "/assets/css/style.css", arena.allocator());
+            benchmark::DoNotOptimize(path);
+        }
+    }
+
+    void BM_ProcessTarget(benchmark::State &state)
+    {
+        beast::string_view const targets[] = {"/", "/index.html?utm_source=bench", "/assets/css/style.css"};
+        bench::allocation_scope allocs(state);
+        for (auto _ : state)
+        {
+            for (auto target : targets)
+            {
+                benchmark::DoNotOptimize(process_target(target));
+            }
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * std::size(targets)));
+    }
+
+    // POST /login 的请求体解析（parse_body），包括把请求体复制进 arena
+    void BM_ParseBody(benchmark::State &state)
+    {
+        beast::string_view const body = "username=alice%40example.com&password=correct+horse+battery+staple";
+        request_arena arena;
+        bench::allocation_scope allocs(state);
+        for (auto _ : state)
+        {
+            arena.reset();
+            auto req = make_request(arena, http::verb::post, "/login");
+            req.set(http::field::content_type, "application/x-www-form-urlencoded");
+            req.body().assign(body.data(), body.size());
+            auto form = parse_body(req);
+            benchmark::DoNotOptimize(form);
+        }
+    }
+
+    // 内存中的请求经 handle_request 处理并序列化响应；zero_alloc 为 true 时预热后不允许任何全局堆分配
+    void run_handle_request(benchmark::State &state, http::verb method, beast::string_view target,
+                            bool zero_alloc = false)
+    {
+        auto const &root = bench::doc_root();
+        request_arena arena;
+        capture_send::result result;
+        result.resource = arena.resource();
+        auto const ex = bench_executor();
+
+        // 第一次请求把文件读入缓存
+        handle_request(root, make_request(arena, method, target), capture_send{&result, ex});
+        serialize(result);
+        result.clear();
+
+        bench::allocation_scope allocs(state, zero_alloc);
+        for (auto _ : state)
+        {
+            arena.reset();
+            handle_request(root, make_request(arena, method, target), capture_send{&result, ex});
+            benchmark::DoNotOptimize(serialize(result));
+            result.clear();
+        }
+    }
+
+    void BM_HandleGetCached(benchmark::State &state) { run_handle_request(state, http::verb::get, "/", true); }
+    void BM_HandleHeadCached(benchmark::State &state) { run_handle_request(state, http::verb::head, "/style.css"); }
+    void BM_HandleNotFound(benchmark::State &state) { run_handle_request(state, http::verb::get, "/missing.html"); }
+    void BM_HandleIllegalTarget(benchmark::State &state) { run_handle_request(state, http::verb::get, "/../etc/passwd"); }
+
+    // 错误响应的构造：arena 请求（线上路径）与使用全局堆的普通请求对比
+    // arena 路径不允许任何全局堆分配，先预热一次（如 glog 的线程局部缓冲区）
+    template <class Make>
+    void run_arena_response(benchmark::State &state, Make make)
+    {
+        FLAGS_minloglevel = google::GLOG_ERROR;
+        request_arena arena;
+        {
+            auto req = make_request(arena, http::verb::get, "/missing.html");
+            benchmark::DoNotOptimize(make(req));
+        }
+        bench::allocation_scope allocs(state, true);
+        for (auto _ : state)
+        {
+            arena.reset();
+            auto req = make_request(arena, http::verb::get, "/missing.html");
+            auto res = make(req);
+            benchmark::DoNotOptimize(res);
+        }
+    }
+
+    template <class Make>
+    void run_heap_response(benchmark::State &state, Make make)
+    {
+        FLAGS_minloglevel = google::GLOG_ERROR;
+        bench::allocation_scope allocs(state);
+        for (auto _ : state)
+        {
+            http::request<http::string_body> req{http::verb::get, "/missing.html", 11};
+            req.set(http::field::host, "localhost:8080");
+            auto res = make(req);
+            benchmark::DoNotOptimize(res);
+        }
+    }
+
+    void BM_BadRequestArena(benchmark::State &state)
+    {
+        run_arena_response(state, [](auto &req)
+                           { return bad_request(req, "Illegal request-target"); });
+    }
+
+    void BM_BadRequestHeap(benchmark::State &state)
+    {
+        run_heap_response(state, [](auto &req)
+                          { return bad_request(req, "Illegal request-target"); });
+    }
+
+    void BM_NotFoundArena(benchmark::State &state)
+    {
+        run_arena_response(state, [](auto &req)
+                           { return not_found(req, req.target()); });
+    }
+
+    void BM_NotFoundHeap(benchmark::State &state)
+    {
+        run_heap_response(state, [](auto &req)
+                          { return not_found(req, req.target()); });
+    }
+} // namespace
+
+BENCHMARK(BM_MimeType);
+BENCHMARK(BM_PathCat);
+BENCHMARK(BM_PathCatArena);
+BENCHMARK(BM_ProcessTarget);
+BENCHMARK(BM_ParseBody);
+BENCHMARK(BM_HandleGetCached);
+BENCHMARK(BM_HandleHeadCached);
+BENCHMARK(BM_HandleNotFound);
+BENCHMARK(BM_HandleIllegalTarget);
+BENCHMARK(BM_BadRequestArena);
+BENCHMARK(BM_BadRequestHeap);
+BENCHMARK(BM_NotFoundArena);
+BENCHMARK(BM_NotFoundHeap);
@@ -0,0 +1,190 @@
+#!/bin/bash
+# 基准测试套件（make bench）：启动一个临时的本地 mysqld 与服务器，
+# 按服务器模式依次运行各场景的负载生成器，结果写到 benchmarks/results/<LABEL>/。
+#
+# 服务器模式：
+#   shared       所有线程共享一个 io_context（默认配置）
+#   reuse_port   每线程一个 io_context 与 SO_REUSEPORT 监听套接字
+#   no_sendfile  共享模式但关闭 sendfile，只运行 large 场景，与 shared 的 large 对比吞吐与每 GB 的 CPU 时间
+#
+# 可用环境变量覆盖：SERVER、LABEL、MODES、SCENARIOS、CONNECTIONS、PIPELINE、THREADS、
+# CLIENT_THREADS、DURATION、WARMUP、PORT；设置 MYSQL_HOST（及 MYSQL_PORT/MYSQL_USER/MYSQL_PASSWORD）
+# 时使用已有的 MySQL 而不启动 mysqld。
+# 协程版本：make clean && make CORO=1 && make bench LABEL=coro
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+SERVER="${SERVER:-$ROOT/server}"
+LOADGEN="${LOADGEN:-$ROOT/benchmarks/load_generator}"
+LABEL="${LABEL:-$(git -C "$ROOT" rev-parse --short HEAD 2>/dev/null || echo local)}"
+MODES="${MODES:-shared reuse_port no_sendfile}"
+SCENARIOS="${SCENARIOS:-get head 404 login register large}"
+CONNECTIONS="${CONNECTIONS:-64}"
+PIPELINE="${PIPELINE:-1}"
+THREADS="${THREADS:-4}"
+CLIENT_THREADS="${CLIENT_THREADS:-2}"
+DURATION="${DURATION:-10}"
+WARMUP="${WARMUP:-2}"
+PORT="${PORT:-18080}"
+RESULTS="$ROOT/benchmarks/results/$LABEL"
+
+WORK="$(mktemp -d /tmp/async_server_bench.XXXXXX)"
+MYSQLD_PID=""
+SERVER_PID=""
+
+cleanup()
+{
+    [ -n "$SERVER_PID" ] && kill "$SERVER_PID" 2>/dev/null && wait "$SERVER_PID" 2>/dev/null || true
+    if [ -n "$MYSQLD_PID" ]; then
+        kill "$MYSQLD_PID" 2>/dev/null || true
+        wait "$MYSQLD_PID" 2>/dev/null || true
+    fi
+    rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+wait_for_port()
+{
+    for _ in $(seq 1 100); do
+        if (exec 3<>"/dev/tcp/127.0.0.1/$1") 2>/dev/null; then
+            return 0
+        fi
+        sleep 0.2
+    done
+    echo "Timed out waiting for port $1" >&2
+    return 1
+}
+
+# 临时的 mysqld：数据目录、套接字都在 $WORK 中，测试结束后删除
+start_mysqld()
+{
+    MYSQL_HOST=127.0.0.1
+    MYSQL_PORT="${MYSQL_PORT:-13306}"
+    MYSQL_USER=bench
+    MYSQL_PASSWORD=bench
+
+    mysqld --no-defaults --initialize-insecure --datadir="$WORK/mysql" --user="$(id -un)" \
+        >"$WORK/mysqld-init.log" 2>&1
+    mysqld --no-defaults --datadir="$WORK/mysql" --user="$(id -un)" \
+        --socket="$WORK/mysqld.sock" --port="$MYSQL_PORT" --bind-address=127.0.0.1 \
+        --mysqlx=OFF --pid-file="$WORK/mysqld.pid" --innodb-flush-log-at-trx-commit=2 \
+        >"$WORK/mysqld.log" 2>&1 &
+    MYSQLD_PID=$!
+
+    for _ in $(seq 1 150); do
+        mysqladmin --socket="$WORK/mysqld.sock" -uroot ping >/dev/null 2>&1 && break
+        sleep 0.2
+    done
+    mysql --socket="$WORK/mysqld.sock" -uroot <<SQL
+CREATE DATABASE bench;
+CREATE USER '$MYSQL_USER'@'%' IDENTIFIED BY '$MYSQL_PASSWORD';
+GRANT ALL ON bench.* TO '$MYSQL_USER'@'%';
+SQL
+}
+
+# 生成服务器配置：$1 为 reuse_port（true/false），$2 为是否启用 sendfile
+write_config()
+{
+    cat >"$WORK/server_config.json" <<JSON
+{
+    "server": {
+        "address": "127.0.0.1",
+        "port": $PORT,
+        "threads": $THREADS,
+        "doc_root": "$WORK/root",
+        "reuse_port": $1,
+        "pin_threads": true
+    },
+    "sendfile": { "enabled": $2, "threshold": 1048576 },
+    "access_log": { "enabled": true, "path": "$WORK/logs/access.log" },
+    "database": {
+        "host": "$MYSQL_HOST",
+        "port": ${MYSQL_PORT:-3306},
+        "user": "$MYSQL_USER",
+        "password": "$MYSQL_PASSWORD",
+        "database": "${MYSQL_DATABASE:-bench}",
+        "pool_size": 10,
+        "max_pool_size": 20,
+        "executor_threads": 8
+    },
+    "logging": {
+        "enabled": true,
+        "minloglevel": 1,
+        "log_dir": "$WORK/logs",
+        "log_to_stderr": false,
+        "max_log_size": 100,
+        "log_prefix": true,
+        "log_buf_secs": 30,
+        "async": true,
+        "stop_logging_if_full_disk": true,
+        "alsologtostderr": false,
+        "logtostderr": false,
+        "stderrthreshold": 3,
+        "log_file_extension": "",
+        "timestamp_in_logfile_name": false
+    }
+}
+JSON
+}
+
+run_mode()
+{
+    local mode=$1 reuse_port=false sendfile=true scenarios=$SCENARIOS
+    case "$mode" in
+    shared) ;;
+    reuse_port) reuse_port=true ;;
+    no_sendfile)
+        sendfile=false
+        scenarios=large
+        ;;
+    *)
+        echo "Unknown mode $mode" >&2
+        return 1
+        ;;
+    esac
+
+    write_config "$reuse_port" "$sendfile"
+    (cd "$WORK" && exec "$SERVER") >"$WORK/server-$mode.log" 2>&1 &
+    SERVER_PID=$!
+    wait_for_port "$PORT"
+
+    for scenario in $scenarios; do
+        echo "== $mode / $scenario"
+        "$LOADGEN" --port="$PORT" --scenario="$scenario" --connections="$CONNECTIONS" \
+            --pipeline="$PIPELINE" --threads="$CLIENT_THREADS" --duration="$DURATION" --warmup="$WARMUP" \
+            --server-pid="$SERVER_PID" --label="$LABEL $mode" \
+            --output="$RESULTS/$mode-$scenario.json" || echo "$mode / $scenario failed" >&2
+    done
+
+    kill "$SERVER_PID"
+    wait "$SERVER_PID" 2>/dev/null || true
+    SERVER_PID=""
+}
+
+mkdir -p "$RESULTS" "$WORK/logs"
+cp -r "$ROOT/root" "$WORK/root"
+head -c $((8 * 1024 * 1024)) /dev/urandom >"$WORK/root/large.bin" # 超过 sendfile 阈值
+
+if [ -z "${MYSQL_HOST:-}" ]; then
+    start_mysqld
+else
+    MYSQL_USER="${MYSQL_USER:-root}"
+    MYSQL_PASSWORD="${MYSQL_PASSWORD:-}"
+fi
+
+for mode in $MODES; do
+    run_mode "$mode"
+done
+
+# 合并为一个文件，便于与其他提交的结果比较
+{
+    echo "["
+    first=1
+    for f in "$RESULTS"/*-*.json; do
+        [ "$first" = 1 ] || echo ","
+        first=0
+        cat "$f"
+    done
+    echo "]"
+} >"$RESULTS/summary.json"
+echo "Results written to $RESULTS"
@@ -0,0 +1,170 @@
+// session 的基准：在进程内通过回环连接运行真实的 listener/session，客户端与服务器共用一个 io_context
+// 和线程，因此每个请求的分配（allocs_per_request）与往返时间都包含完整的会话路径：读请求、解析、
+// handle_request、写响应。客户端只写入预先构造的请求、读入固定长度的响应，预热后自身不分配。
+// 同一基准在默认构建中测回调版本的 session，在 make CORO=1 构建中测协程版本（标签 callback/coroutine），
+// 两次运行的结果即两种实现的对比。参数为流水线深度：每次迭代连续发送的请求数
+#include "alloc_counter.hpp"
+#include "bench_doc_root.hpp"
+#include "../http_server/handler_memory.hpp"
+#include "../http_server/http_server.hpp"
+
+#include <benchmark/benchmark.h>
+#include <boost/asio/bind_allocator.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/http/read.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    using namespace http_server;
+
+#ifdef HTTP_SERVER_COROUTINES
+    constexpr char session_kind[] = "coroutine";
+#else
+    constexpr char session_kind[] = "callback";
+#endif
+
+    // 每批请求的平均往返时间超过该值即视为写出被延迟
+    constexpr std::chrono::milliseconds stall_threshold{10};
+
+    constexpr std::string_view get_request =
+        "GET / HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "User-Agent: microbench\r\n"
+        "Accept: text/html,application/xhtml+xml,*/*;q=0.8\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+
+    // 进程内的服务器：listener 在第一次使用时启动，此后一直接受连接
+    struct loopback_server
+    {
+        net::io_context ioc{1};
+        tcp::endpoint endpoint;
+
+        loopback_server()
+        {
+            // 先绑定 0 端口取得一个空闲端口，listener 再绑定该端口
+            tcp::acceptor probe(ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0});
+            endpoint = probe.local_endpoint();
+            probe.close();
+            std::make_shared<listener>(ioc, endpoint, std::make_shared<std::string const>(bench::doc_root()))->run();
+        }
+
+        // 运行事件循环直到 done 为真
+        void run_until(bool const &done)
+        {
+            while (!done && ioc.run_one() != 0)
+            {
+            }
+        }
+    };
+
+    loopback_server &server()
+    {
+        static loopback_server instance;
+        return instance;
+    }
+
+    void BM_SessionKeepAliveGet(benchmark::State &state)
+    {
+        auto &srv = server();
+        auto const depth = static_cast<std::size_t>(state.range(0));
+        state.SetLabel(session_kind);
+
+        // 具体的执行器类型：any_io_executor 派发完成回调时要分配类型擦除的函数对象
+        tcp::socket::rebind_executor<net::io_context::executor_type>::other client(srv.ioc.get_executor());
+        client.connect(srv.endpoint);
+        client.set_option(tcp::no_delay(true));
+
+        std::string requests;
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            requests.append(get_request);
+        }
+
+        // 第一个请求把文件读入缓存，并取得响应的长度（响应没有 Date 等变长字段，长度固定）
+        std::size_t response_size = 0;
+        {
+            beast::flat_buffer buffer;
+            http::response<http::string_body> res;
+            bool done = false;
+            beast::error_code ec;
+            net::async_write(client, net::buffer(get_request.data(), get_request.size()),
+                             [](beast::error_code, std::size_t) {});
+            http::async_read(client, buffer, res,
+                             [&](beast::error_code e, std::size_t n)
+                             {
+                                 ec = e;
+                                 response_size = n;
+                                 done = true;
+                             });
+            srv.run_until(done);
+            if (ec || res.result() != http::status::ok || buffer.size() != 0)
+            {
+                state.SkipWithError("warm-up request failed");
+                return;
+            }
+        }
+
+        std::vector<char> responses(response_size * depth);
+        handler_memory client_memory;
+        beast::error_code ec;
+        auto round_trip = [&]
+        {
+            bool done = false;
+            net::async_write(client, net::buffer(requests),
+                             net::bind_allocator(handler_allocator<void>(client_memory),
+                                                 [](beast::error_code, std::size_t) {}));
+            net::async_read(client, net::buffer(responses),
+                            net::bind_allocator(handler_allocator<void>(client_memory),
+                                                [&](beast::error_code e, std::size_t)
+                                                {
+                                                    ec = e;
+                                                    done = true;
+                                                }));
+            srv.run_until(done);
+        };
+
+        // 再预热一轮流水线，使服务器与客户端的缓冲区、处理器内存都达到稳定大小
+        round_trip();
+
+        auto const start = bench::allocations();
+        auto const started = std::chrono::steady_clock::now();
+        for (auto _ : state)
+        {
+            round_trip();
+            if (ec)
+            {
+                state.SkipWithError(ec.message().c_str());
+                break;
+            }
+        }
+        auto const elapsed = std::chrono::steady_clock::now() - started;
+        auto const allocations = bench::allocations() - start;
+
+        // 回环上一次往返远小于 1 ms；每批接近 40 ms 说明小响应被 Nagle 算法与对端的延迟 ACK 卡住
+        if (state.iterations() != 0 && elapsed / state.iterations() > stall_threshold)
+        {
+            state.SkipWithError("responses stalled on Nagle's algorithm and delayed ACK, "
+                                "is TCP_NODELAY set on accepted sockets?");
+        }
+
+        auto const requests_done = static_cast<int64_t>(state.iterations() * depth);
+        state.SetItemsProcessed(requests_done);
+        state.counters["allocs_per_request"] = benchmark::Counter(
+            static_cast<double>(allocations) / static_cast<double>(depth), benchmark::Counter::kAvgIterations);
+
+        // 关闭连接并让服务器端的会话处理完 EOF
+        client.close();
+        srv.ioc.poll();
+    }
+} // namespace
+
+// 深度 1 为逐个请求的往返延迟；回调版本的 session 支持流水线，协程版本逐个处理请求
+BENCHMARK(BM_SessionKeepAliveGet)->Arg(1)->Arg(8)->UseRealTime();
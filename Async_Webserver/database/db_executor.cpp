@@ -0,0 +1,50 @@
+#include "db_executor.hpp"
+
+#include <glog/logging.h>
+
+namespace db
+{
+    Executor &Executor::getInstance()
+    {
+        static Executor instance;
+        return instance;
+    }
+
+    bool Executor::initialize(size_t threads)
+    {
+        if (pool_)
+        {
+            LOG(WARNING) << "Database executor already initialized";
+            return false;
+        }
+
+        if (threads == 0)
+        {
+            threads = 1;
+        }
+        pool_ = std::make_unique<boost::asio::thread_pool>(threads);
+
+        LOG(INFO) << "Database executor initialized with " << threads << " threads";
+        return true;
+    }
+
+    void Executor::shutdown()
+    {
+        if (pool_)
+        {
+            pool_->join();
+            pool_.reset();
+        }
+    }
+
+    Executor::executor_type Executor::get_executor()
+    {
+        return pool_->get_executor();
+    }
+
+    Executor::~Executor()
+    {
+        shutdown();
+    }
+
+} // namespace db
@@ -0,0 +1,31 @@
+#ifndef DB_EXECUTOR_HPP
+#define DB_EXECUTOR_HPP
+
+#include <boost/asio/thread_pool.hpp>
+#include <memory>
+
+namespace db
+{
+    // 数据库任务线程池：所有阻塞的 MySQL 调用都在这里执行，避免占用 Asio 的 I/O 线程
+    class Executor
+    {
+    public:
+        using executor_type = boost::asio::thread_pool::executor_type;
+
+        static Executor &getInstance();
+
+        bool initialize(size_t threads);
+        void shutdown(); // 等待已提交的任务完成后停止线程
+
+        executor_type get_executor();
+
+    private:
+        Executor() = default;
+        ~Executor();
+
+        std::unique_ptr<boost::asio::thread_pool> pool_;
+    };
+
+} // namespace db
+
+#endif // DB_EXECUTOR_HPP
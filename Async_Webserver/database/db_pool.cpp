@@ -1,11 +1,89 @@
 #include "db_pool.hpp"
+#include "db_executor.hpp"
 
+#include <boost/asio/post.hpp>
 #include <glog/logging.h>
+#include <algorithm>
 #include <sstream>
 #include <cppconn/prepared_statement.h>
 
 namespace db
 {
+    PooledConnection::PooledConnection(std::unique_ptr<sql::Connection> conn)
+        : conn_(std::move(conn))
+    {
+    }
+
+    sql::PreparedStatement *PooledConnection::prepare(const std::string &sql)
+    {
+        auto it = statements_.find(sql);
+        if (it != statements_.end())
+        {
+            return it->second.get();
+        }
+
+        std::unique_ptr<sql::PreparedStatement> stmt(conn_->prepareStatement(sql));
+        auto *raw = stmt.get();
+        statements_.emplace(sql, std::move(stmt));
+        return raw;
+    }
+
+    void PooledConnection::checkError(const sql::SQLException &e)
+    {
+        // CR_SERVER_GONE_ERROR / CR_SERVER_LOST / CR_SERVER_LOST_EXTENDED
+        switch (e.getErrorCode())
+        {
+        case 2006:
+        case 2013:
+        case 2055:
+            broken_ = true;
+            break;
+        default:
+            break;
+        }
+    }
+
+    ConnectionLease::ConnectionLease(ConnectionPool *pool, std::unique_ptr<PooledConnection> conn)
+        : pool_(pool), conn_(std::move(conn)), acquired_(std::chrono::steady_clock::now())
+    {
+    }
+
+    ConnectionLease::~ConnectionLease()
+    {
+        release();
+    }
+
+    ConnectionLease::ConnectionLease(ConnectionLease &&other) noexcept
+        : pool_(other.pool_), conn_(std::move(other.conn_)), acquired_(other.acquired_)
+    {
+    }
+
+    ConnectionLease &ConnectionLease::operator=(ConnectionLease &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            pool_ = other.pool_;
+            conn_ = std::move(other.conn_);
+            acquired_ = other.acquired_;
+        }
+        return *this;
+    }
+
+    std::chrono::steady_clock::duration ConnectionLease::elapsed() const
+    {
+        return std::chrono::steady_clock::now() - acquired_;
+    }
+
+    void ConnectionLease::release()
+    {
+        if (conn_ && pool_)
+        {
+            pool_->releaseConnection(std::move(conn_), elapsed());
+        }
+        conn_.reset();
+    }
+
     ConnectionPool &ConnectionPool::getInstance()
     {
         static ConnectionPool instance;
@@ -45,6 +123,8 @@ namespace db
             database_ = database;
 
             pool_size_ = pool_size;
+            max_size_ = pool_size;
+            max_idle_ = pool_size;
 
             // Pre-create connections
             for (size_t i = 0; i < pool_size_; ++i)
@@ -52,7 +132,8 @@ namespace db
                 auto conn = createConnection();
                 if (conn)
                 {
-                    connections_.push(conn);
+                    connections_.push_back(std::move(conn));
+                    ++total_;
                 }
             }
 
@@ -74,66 +155,439 @@ namespace db
         }
     }
 
-    std::shared_ptr<sql::Connection> ConnectionPool::getConnection()
+    void ConnectionPool::setLimits(size_t max_size, size_t min_idle, size_t max_idle,
+                                   std::chrono::milliseconds acquire_timeout)
     {
         std::lock_guard<std::mutex> lock(mutex_);
+        max_size_ = std::max(max_size, pool_size_);
+        min_idle_ = std::min(min_idle, max_size_);
+        max_idle_ = std::max({max_idle, min_idle_, static_cast<size_t>(1)});
+        acquire_timeout_ = acquire_timeout;
+
+        LOG(INFO) << "Connection pool limits: max " << max_size_ << ", idle " << min_idle_
+                  << "-" << max_idle_ << ", acquire timeout " << acquire_timeout_.count() << "ms";
+    }
+
+    std::unique_ptr<PooledConnection> ConnectionPool::tryAcquire(bool &grow)
+    {
+        grow = false;
+        if (!connections_.empty() && waiters_.empty())
+        {
+            auto conn = std::move(connections_.front());
+            connections_.pop_front();
+            ++acquired_;
+            return conn;
+        }
+
+        // 预留新建名额，连接在锁外创建后经 handOff 交给最早的等待者
+        if (total_ < max_size_)
+        {
+            ++total_;
+            grow = true;
+        }
+        else
+        {
+            ++exhausted_;
+        }
+        return nullptr;
+    }
+
+    void ConnectionPool::recordWait(Waiter &waiter)
+    {
+        auto const us = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - waiter.enqueued)
+                            .count();
+        ++acquired_;
+        ++waited_;
+        wait_time_us_ += static_cast<uint64_t>(us);
+        max_wait_us_ = std::max(max_wait_us_, static_cast<uint64_t>(us));
+    }
+
+    ConnectionLease ConnectionPool::getConnection()
+    {
+        return getConnection(acquire_timeout_);
+    }
+
+    ConnectionLease ConnectionPool::getConnection(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
 
         if (!initialized_)
         {
             LOG(ERROR) << "Connection pool not initialized";
-            return nullptr;
+            return {};
+        }
+
+        bool grow = false;
+        if (auto conn = tryAcquire(grow))
+        {
+            return ConnectionLease(this, std::move(conn));
+        }
+
+        auto const deadline = std::chrono::steady_clock::now() + timeout;
+        auto waiter = std::make_shared<Waiter>();
+        waiters_.push_back(waiter);
+
+        if (grow)
+        {
+            lock.unlock();
+            auto conn = createConnection();
+            bool const created = conn != nullptr;
+            if (created)
+            {
+                handOff(std::move(conn));
+            }
+            lock.lock();
+
+            if (!created)
+            {
+                --total_;
+                if (!waiter->done)
+                {
+                    // 新建失败时不再等待，避免数据库不可用时请求全部堆积到超时
+                    waiters_.erase(std::find(waiters_.begin(), waiters_.end(), waiter));
+                    waiter->done = true;
+                    return {};
+                }
+            }
+        }
+
+        if (!waiter->cv.wait_until(lock, deadline, [&]
+                                   { return waiter->done; }))
+        {
+            waiters_.erase(std::find(waiters_.begin(), waiters_.end(), waiter));
+            waiter->done = true;
+            ++timeouts_;
+            LOG(WARNING) << "Timed out waiting for a database connection";
+            return {};
+        }
+        return ConnectionLease(this, std::move(waiter->conn));
+    }
+
+    void ConnectionPool::asyncGetConnection(boost::asio::any_io_executor ex, acquire_handler handler)
+    {
+        asyncGetConnection(std::move(ex), acquire_timeout_, std::move(handler));
+    }
+
+    void ConnectionPool::asyncGetConnection(boost::asio::any_io_executor ex,
+                                            std::chrono::milliseconds timeout,
+                                            acquire_handler handler)
+    {
+        auto waiter = std::make_shared<Waiter>();
+        waiter->async = true;
+        waiter->ex = ex;
+        waiter->handler = std::move(handler);
+        waiter->timer = std::make_unique<boost::asio::steady_timer>(ex);
+
+        // 定时器在入队前启动，保证之后只有 ex 上的代码会访问它
+        waiter->timer->expires_after(timeout);
+        waiter->timer->async_wait(
+            [this, waiter](const boost::system::error_code &ec)
+            {
+                if (ec)
+                {
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (waiter->done)
+                    {
+                        return;
+                    }
+                    waiter->done = true;
+                    auto it = std::find(waiters_.begin(), waiters_.end(), waiter);
+                    if (it != waiters_.end())
+                    {
+                        waiters_.erase(it);
+                    }
+                    ++timeouts_;
+                }
+                LOG(WARNING) << "Timed out waiting for a database connection";
+                auto handler = std::move(waiter->handler);
+                handler(ConnectionLease());
+            });
+
+        bool grow = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (waiter->done)
+            {
+                return; // 已超时
+            }
+            if (!initialized_)
+            {
+                LOG(ERROR) << "Connection pool not initialized";
+                waiter->done = true;
+            }
+            else if (auto conn = tryAcquire(grow))
+            {
+                waiter->conn = std::move(conn);
+                waiter->done = true;
+            }
+            else
+            {
+                waiters_.push_back(waiter);
+            }
+        }
+
+        if (waiter->done)
+        {
+            completeAsync(std::move(waiter));
+            return;
         }
 
-        if (connections_.empty())
+        if (grow)
         {
-            LOG(WARNING) << "No available connections, creating new one";
-            return createConnection();
+            boost::asio::post(Executor::getInstance().get_executor(),
+                              [this]
+                              {
+                                  auto conn = createConnection();
+                                  if (conn)
+                                  {
+                                      handOff(std::move(conn));
+                                      return;
+                                  }
+                                  std::lock_guard<std::mutex> lock(mutex_);
+                                  --total_;
+                              });
         }
+    }
 
-        auto conn = connections_.front();
-        connections_.pop();
-        return conn;
+    void ConnectionPool::completeAsync(std::shared_ptr<Waiter> waiter)
+    {
+        auto ex = waiter->ex;
+        boost::asio::post(ex, [this, waiter = std::move(waiter)]
+                          {
+                              waiter->timer->cancel();
+                              auto handler = std::move(waiter->handler);
+                              handler(waiter->conn ? ConnectionLease(this, std::move(waiter->conn))
+                                                   : ConnectionLease()); });
     }
 
-    void ConnectionPool::releaseConnection(std::shared_ptr<sql::Connection> conn)
+    void ConnectionPool::handOff(std::unique_ptr<PooledConnection> conn)
+    {
+        std::unique_ptr<PooledConnection> excess; // 在锁外析构
+        std::shared_ptr<Waiter> waiter;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (waiters_.empty())
+            {
+                if (connections_.size() >= max_idle_)
+                {
+                    --total_;
+                    excess = std::move(conn);
+                }
+                else
+                {
+                    connections_.push_back(std::move(conn));
+                }
+                return;
+            }
+
+            waiter = std::move(waiters_.front());
+            waiters_.pop_front();
+            waiter->conn = std::move(conn);
+            waiter->done = true;
+            recordWait(*waiter);
+
+            if (!waiter->async)
+            {
+                waiter->cv.notify_one();
+                return;
+            }
+        }
+        completeAsync(std::move(waiter));
+    }
+
+    void ConnectionPool::releaseConnection(std::unique_ptr<PooledConnection> conn,
+                                           std::chrono::steady_clock::duration held)
     {
         if (!conn)
             return;
 
+        auto const us = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(held).count());
+        hold_time_us_.fetch_add(us, std::memory_order_relaxed);
+        auto max_hold = max_hold_us_.load(std::memory_order_relaxed);
+        while (us > max_hold && !max_hold_us_.compare_exchange_weak(max_hold, us, std::memory_order_relaxed))
+        {
+        }
+
+        if (conn->broken())
+        {
+            // 断开的连接在锁外析构，缺少的连接由下一次健康检查补足
+            LOG(WARNING) << "Dropping broken database connection";
+            std::lock_guard<std::mutex> lock(mutex_);
+            --total_;
+            ++dropped_broken_;
+            return;
+        }
+
+        conn->touch();
+        handOff(std::move(conn));
+    }
+
+    PoolStats ConnectionPool::stats()
+    {
+        PoolStats stats;
         std::lock_guard<std::mutex> lock(mutex_);
-        try
+        stats.total = total_;
+        stats.idle = connections_.size();
+        stats.waiting = waiters_.size();
+        stats.acquired = acquired_;
+        stats.waited = waited_;
+        stats.wait_time_us = wait_time_us_;
+        stats.max_wait_us = max_wait_us_;
+        stats.hold_time_us = hold_time_us_.load(std::memory_order_relaxed);
+        stats.max_hold_us = max_hold_us_.load(std::memory_order_relaxed);
+        stats.exhausted = exhausted_;
+        stats.timeouts = timeouts_;
+        stats.created = created_.load(std::memory_order_relaxed);
+        stats.validation_failures = validation_failures_.load(std::memory_order_relaxed);
+        stats.dropped_broken = dropped_broken_;
+        return stats;
+    }
+
+    void ConnectionPool::startHealthCheck(std::chrono::seconds interval, std::chrono::seconds idle_threshold)
+    {
+        if (!initialized_ || interval.count() <= 0 || health_timer_)
         {
-            // 测试连接是否有效
-            std::unique_ptr<sql::Statement> stmt(conn->createStatement());
-            std::unique_ptr<sql::ResultSet> rs(stmt->executeQuery("SELECT 1"));
+            return;
+        }
+
+        health_interval_ = interval;
+        idle_threshold_ = idle_threshold;
+        health_timer_ = std::make_unique<boost::asio::steady_timer>(*ioc_);
+        health_check_running_ = true;
+        scheduleHealthCheck();
+
+        LOG(INFO) << "Database health check every " << interval.count()
+                  << "s, pinging connections idle for " << idle_threshold.count() << "s";
+    }
+
+    void ConnectionPool::stopHealthCheck()
+    {
+        health_check_running_ = false;
+        health_timer_.reset();
+    }
 
-            // 有效则放回队列
-            connections_.push(conn);
+    void ConnectionPool::scheduleHealthCheck()
+    {
+        if (!health_check_running_)
+        {
+            return;
         }
-        catch (const sql::SQLException &e)
+
+        // 定时器只负责计时，ping 和重连都是阻塞调用，交给数据库线程池执行
+        health_timer_->expires_after(health_interval_);
+        health_timer_->async_wait(
+            [this](const boost::system::error_code &ec)
+            {
+                if (ec || !health_check_running_)
+                {
+                    return;
+                }
+                boost::asio::post(Executor::getInstance().get_executor(),
+                                  [this]
+                                  { runHealthCheck(); });
+            });
+    }
+
+    void ConnectionPool::runHealthCheck()
+    {
+        auto const now = std::chrono::steady_clock::now();
+
+        // 取出空闲超过阈值的连接，在锁外逐个 ping，期间其它连接照常借还
+        std::vector<std::unique_ptr<PooledConnection>> idle;
         {
-            // 当前连接无效，创建新连接
-            LOG(WARNING) << "Connection test failed: " << e.what() << ", creating new connection";
-            auto new_conn = createConnection();
-            if (new_conn)
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto it = connections_.begin(); it != connections_.end();)
             {
-                connections_.push(new_conn);
+                if (now - (*it)->lastUsed() >= idle_threshold_)
+                {
+                    idle.push_back(std::move(*it));
+                    it = connections_.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
             }
         }
-        catch (const std::exception &e)
+
+        size_t dropped = 0;
+        for (auto &conn : idle)
         {
-            LOG(ERROR) << "Error releasing connection: " << e.what();
+            bool valid = false;
+            try
+            {
+                valid = conn->connection()->isValid();
+            }
+            catch (const sql::SQLException &e)
+            {
+                LOG(WARNING) << "Connection ping failed: " << e.what();
+            }
+
+            if (valid)
+            {
+                conn->touch();
+                handOff(std::move(conn));
+            }
+            else
+            {
+                validation_failures_.fetch_add(1, std::memory_order_relaxed);
+                conn.reset();
+                ++dropped;
+            }
+        }
+
+        // 补足被丢弃的连接（包括归还时发现已断开的连接），保证连接总数不低于初始值、
+        // 空闲连接不少于 min_idle，且不超过上限；新建连接同样在锁外进行
+        size_t missing = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            total_ -= dropped;
+            if (total_ < pool_size_)
+            {
+                missing = pool_size_ - total_;
+            }
+            if (connections_.size() + missing < min_idle_)
+            {
+                missing = min_idle_ - connections_.size();
+            }
+            missing = std::min(missing, max_size_ > total_ ? max_size_ - total_ : 0);
+            total_ += missing;
         }
+
+        if (dropped > 0 || missing > 0)
+        {
+            LOG(WARNING) << "Health check dropped " << dropped << " dead connections, creating "
+                         << missing << " new connections";
+        }
+
+        for (size_t i = 0; i < missing; ++i)
+        {
+            auto conn = createConnection();
+            if (conn)
+            {
+                handOff(std::move(conn));
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            --total_;
+        }
+
+        scheduleHealthCheck();
     }
 
-    std::shared_ptr<sql::Connection> ConnectionPool::createConnection()
+    std::unique_ptr<PooledConnection> ConnectionPool::createConnection()
     {
         try
         {
             std::ostringstream url;
             url << "tcp://" << host_ << ":" << port_; // 数据库地址和端口
 
-            std::shared_ptr<sql::Connection> conn(
+            std::unique_ptr<sql::Connection> conn(
                 driver_->connect(url.str(), user_, password_));
 
             conn->setSchema(database_); // 数据库名称
@@ -144,7 +598,10 @@ namespace db
             stmt->execute("SET CHARACTER SET utf8mb4");
             stmt->execute("SET character_set_connection=utf8mb4");
 
-            return conn;
+            created_.fetch_add(1, std::memory_order_relaxed);
+
+            // 新连接的预处理语句缓存为空，语句在首次使用时重新 prepare
+            return std::make_unique<PooledConnection>(std::move(conn));
         }
         catch (const sql::SQLException &e)
         {
@@ -165,11 +622,11 @@ namespace db
         std::lock_guard<std::mutex> lock(mutex_);
         while (!connections_.empty())
         {
-            auto conn = connections_.front();
-            connections_.pop();
+            auto conn = std::move(connections_.front());
+            connections_.pop_front();
             try
             {
-                conn->close();
+                conn->connection()->close();
             }
             catch (const std::exception &e)
             {
@@ -6,17 +6,109 @@
 #include <cppconn/exception.h>
 #include <cppconn/resultset.h>
 #include <cppconn/statement.h>
+#include <cppconn/prepared_statement.h>
+#include <boost/asio/any_io_executor.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <vector>
-#include <queue>
 #include <mutex>
 #include <memory>
+#include <string>
+#include <unordered_map>
 
 namespace db
 {
+    // 连接池中的连接：底层 MySQL 连接及其预处理语句缓存。
+    // 每条 SQL 在该连接上只 prepare 一次，连接被替换时缓存随之重建
+    class PooledConnection
+    {
+    public:
+        explicit PooledConnection(std::unique_ptr<sql::Connection> conn);
+
+        sql::Connection *connection() const { return conn_.get(); }
+
+        // 获取 SQL 对应的预处理语句，首次使用时 prepare 并缓存；
+        // 返回的语句归连接所有，不能在多个线程间同时使用
+        sql::PreparedStatement *prepare(const std::string &sql);
+
+        // 根据 SQL 异常判断连接是否已断开（服务器断开、连接丢失），断开的连接归还时直接丢弃
+        void checkError(const sql::SQLException &e);
+        bool broken() const { return broken_; }
+
+        // 最近一次归还到连接池的时间，健康检查据此决定是否需要 ping
+        std::chrono::steady_clock::time_point lastUsed() const { return last_used_; }
+        void touch() { last_used_ = std::chrono::steady_clock::now(); }
+
+    private:
+        std::unique_ptr<sql::Connection> conn_; // 必须先于语句声明，保证语句先析构
+        std::unordered_map<std::string, std::unique_ptr<sql::PreparedStatement>> statements_;
+        std::chrono::steady_clock::time_point last_used_{std::chrono::steady_clock::now()};
+        bool broken_{false};
+    };
+
+    class ConnectionPool;
+
+    // 从连接池借出的连接，只能移动；析构时自动归还，异常路径也不会泄漏连接。
+    // 通过 -> 访问连接及其预处理语句缓存，并记录借出时长
+    class ConnectionLease
+    {
+    public:
+        ConnectionLease() = default;
+        ConnectionLease(ConnectionPool *pool, std::unique_ptr<PooledConnection> conn);
+        ~ConnectionLease();
+
+        ConnectionLease(ConnectionLease &&other) noexcept;
+        ConnectionLease &operator=(ConnectionLease &&other) noexcept;
+        ConnectionLease(const ConnectionLease &) = delete;
+        ConnectionLease &operator=(const ConnectionLease &) = delete;
+
+        explicit operator bool() const { return conn_ != nullptr; }
+        PooledConnection *operator->() const { return conn_.get(); }
+        PooledConnection &operator*() const { return *conn_; }
+
+        // 借出至今的时长
+        std::chrono::steady_clock::duration elapsed() const;
+
+        // 提前归还连接，之后租约为空
+        void release();
+
+    private:
+        ConnectionPool *pool_{nullptr};
+        std::unique_ptr<PooledConnection> conn_;
+        std::chrono::steady_clock::time_point acquired_{};
+    };
+
+    // 连接池运行统计，供日志与监控使用
+    struct PoolStats
+    {
+        size_t total{0};   // 已创建的连接数（含借出的）
+        size_t idle{0};    // 空闲连接数
+        size_t waiting{0}; // 正在排队等待的请求数
+
+        uint64_t acquired{0};            // 成功获取连接的次数
+        uint64_t waited{0};              // 需要排队等待的获取次数
+        uint64_t wait_time_us{0};        // 排队等待的总时长（微秒）
+        uint64_t max_wait_us{0};         // 单次最长等待（微秒）
+        uint64_t hold_time_us{0};        // 连接被借出的总时长（微秒）
+        uint64_t max_hold_us{0};         // 单次最长借出（微秒）
+        uint64_t exhausted{0};           // 连接数已达上限、无空闲连接的次数
+        uint64_t timeouts{0};            // 等待超时的次数
+        uint64_t created{0};             // 新建连接的次数
+        uint64_t validation_failures{0}; // 健康检查 ping 失败的次数
+        uint64_t dropped_broken{0};      // 归还时已断开而被丢弃的连接数
+    };
+
     class ConnectionPool
     {
     public:
+        using acquire_handler = std::function<void(ConnectionLease)>;
+
         static ConnectionPool &getInstance();
 
         // 初始化连接池
@@ -29,14 +121,69 @@ namespace db
             const std::string &database,
             size_t pool_size);
 
-        std::shared_ptr<sql::Connection> getConnection(); // 获取数据库连接
-        void releaseConnection(std::shared_ptr<sql::Connection> conn);
+        // 设置连接数上限与空闲连接数范围，max_size 不小于初始连接数
+        void setLimits(size_t max_size, size_t min_idle, size_t max_idle,
+                       std::chrono::milliseconds acquire_timeout);
+
+        // 同步获取数据库连接：没有空闲连接时按先来先到排队，超时返回空租约。
+        // 连接数未达上限时在锁外新建连接
+        ConnectionLease getConnection();
+        ConnectionLease getConnection(std::chrono::milliseconds timeout);
+
+        // 异步获取数据库连接：handler 在 ex 上执行，超时或失败时参数为空租约。
+        // 调用线程不会阻塞，新建连接在数据库线程池中进行
+        void asyncGetConnection(boost::asio::any_io_executor ex, acquire_handler handler);
+        void asyncGetConnection(boost::asio::any_io_executor ex,
+                                std::chrono::milliseconds timeout,
+                                acquire_handler handler);
+
+        // 启动后台健康检查：定时器在 ioc 上触发，检查在数据库线程池中执行，
+        // 只 ping 空闲超过 idle_threshold 的连接，并补足被丢弃的连接
+        void startHealthCheck(std::chrono::seconds interval, std::chrono::seconds idle_threshold);
+        void stopHealthCheck(); // 须在数据库线程池停止后调用
+
+        uint64_t validationFailures() const { return validation_failures_.load(std::memory_order_relaxed); }
+        PoolStats stats();
 
     private:
+        friend class ConnectionLease;
+
+        // 归还连接（由 ConnectionLease 调用）：优先交给最早排队的请求，否则放回空闲队列；
+        // 不做任何网络操作。已断开的连接直接丢弃，由健康检查补足
+        void releaseConnection(std::unique_ptr<PooledConnection> conn,
+                               std::chrono::steady_clock::duration held);
+
+        // 排队等待连接的请求；done 与 conn 只在 mutex_ 内修改
+        struct Waiter
+        {
+            std::chrono::steady_clock::time_point enqueued{std::chrono::steady_clock::now()};
+            std::unique_ptr<PooledConnection> conn;
+            bool done{false};
+
+            std::condition_variable cv; // 同步等待者
+
+            // 异步等待者：在调用者的执行器上完成 handler，timer 负责超时
+            bool async{false};
+            boost::asio::any_io_executor ex;
+            acquire_handler handler;
+            std::unique_ptr<boost::asio::steady_timer> timer;
+        };
+
         ConnectionPool() = default;
         ~ConnectionPool();
 
-        std::shared_ptr<sql::Connection> createConnection();
+        std::unique_ptr<PooledConnection> createConnection();
+
+        // 已持有 mutex_：取出空闲连接，或在未达上限时预留一个新建名额
+        std::unique_ptr<PooledConnection> tryAcquire(bool &grow);
+        void recordWait(Waiter &waiter);
+
+        // 把连接交给最早的等待者，没有等待者时放回空闲队列（超过 max_idle 时丢弃）
+        void handOff(std::unique_ptr<PooledConnection> conn);
+        void completeAsync(std::shared_ptr<Waiter> waiter);
+
+        void scheduleHealthCheck();
+        void runHealthCheck();
 
         boost::asio::io_context *ioc_{nullptr}; // 异步IO上下文
 
@@ -47,13 +194,38 @@ namespace db
         std::string password_;
         std::string database_;
 
-        size_t pool_size_{10}; // 连接池大小
+        size_t pool_size_{10}; // 初始连接数，健康检查保证连接总数不低于该值
+        size_t max_size_{10};  // 连接总数上限
+        size_t min_idle_{0};   // 健康检查补足的最少空闲连接数
+        size_t max_idle_{10};  // 空闲连接超过该数量时，归还的连接直接关闭
+        std::chrono::milliseconds acquire_timeout_{3000};
 
         sql::Driver *driver_{nullptr}; // mysql驱动
 
-        std::queue<std::shared_ptr<sql::Connection>> connections_; // 连接队列
+        std::deque<std::unique_ptr<PooledConnection>> connections_; // 空闲连接队列
+        size_t total_{0};                                            // 已创建且未丢弃的连接数（含借出的）
+        std::deque<std::shared_ptr<Waiter>> waiters_;                // 先来先到的等待队列
         std::mutex mutex_;
+
+        // 以下统计在 mutex_ 内更新
+        uint64_t acquired_{0};
+        uint64_t waited_{0};
+        uint64_t wait_time_us_{0};
+        uint64_t max_wait_us_{0};
+        uint64_t exhausted_{0};
+        uint64_t timeouts_{0};
+        uint64_t dropped_broken_{0};
+        std::atomic<uint64_t> created_{0};
+        std::atomic<uint64_t> hold_time_us_{0}; // 归还时更新，不占用 mutex_
+        std::atomic<uint64_t> max_hold_us_{0};
         bool initialized_{false}; // 初始化标志
+
+        // 健康检查
+        std::unique_ptr<boost::asio::steady_timer> health_timer_;
+        std::chrono::seconds health_interval_{0};
+        std::chrono::seconds idle_threshold_{0};
+        std::atomic<bool> health_check_running_{false};
+        std::atomic<uint64_t> validation_failures_{0}; // ping 失败（连接被替换）的次数
     };
 
 } // namespace db
@@ -0,0 +1,237 @@
+#include "registration.hpp"
+#include "db_executor.hpp"
+
+#include <boost/asio/post.hpp>
+#include <glog/logging.h>
+#include <cppconn/prepared_statement.h>
+#include <cppconn/resultset.h>
+#include <memory>
+#include <string>
+
+namespace db
+{
+    namespace
+    {
+        // MySQL ER_DUP_ENTRY
+        constexpr int ER_DUP_ENTRY = 1062;
+
+        const std::string SQL_INSERT_USER = "INSERT INTO users (username, password, phone) VALUES (?, ?, ?)";
+
+        // 冲突的是用户名还是手机号。用户名在 SQL 中比较，与唯一索引使用同一排序规则（大小写不敏感等）
+        const std::string SQL_FIND_CONFLICT =
+            "SELECT username = ? AS username_taken FROM users WHERE username = ? OR phone = ?";
+
+        // n 行的多行 INSERT，每种行数在连接上只 prepare 一次
+        std::string insertUsersSql(size_t rows)
+        {
+            std::string sql = "INSERT INTO users (username, password, phone) VALUES ";
+            for (size_t i = 0; i < rows; ++i)
+            {
+                sql += i == 0 ? "(?, ?, ?)" : ", (?, ?, ?)";
+            }
+            return sql;
+        }
+    } // namespace
+
+    RegisterResult duplicateKeyResult(PooledConnection &conn, const UserRecord &user)
+    {
+        // 错误信息中的键名随表定义变化，信息本身也可能被本地化，因此不解析，而是查询冲突的记录
+        try
+        {
+            auto *stmt = conn.prepare(SQL_FIND_CONFLICT);
+            stmt->setString(1, user.username);
+            stmt->setString(2, user.username);
+            stmt->setString(3, user.phone);
+
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+            bool found = false;
+            while (res->next())
+            {
+                if (res->getBoolean("username_taken"))
+                {
+                    return RegisterResult::username_taken;
+                }
+                found = true;
+            }
+
+            // 冲突的记录可能在 INSERT 之后已被删除
+            return found ? RegisterResult::phone_taken : RegisterResult::failed;
+        }
+        catch (const sql::SQLException &e)
+        {
+            LOG(ERROR) << "SQL Error looking up duplicate user: " << e.what()
+                       << " (MySQL error code: " << e.getErrorCode()
+                       << ", SQLState: " << e.getSQLState() << ")";
+            conn.checkError(e);
+            return RegisterResult::failed;
+        }
+    }
+
+    RegisterResult insertUser(PooledConnection &conn, const UserRecord &user)
+    {
+        try
+        {
+            auto *stmt = conn.prepare(SQL_INSERT_USER);
+            stmt->setString(1, user.username);
+            stmt->setString(2, user.password); // 已由 auth::PasswordHasher 哈希
+            stmt->setString(3, user.phone);
+            stmt->execute();
+
+            UserCache::getInstance().put(user);
+            return RegisterResult::ok;
+        }
+        catch (const sql::SQLException &e)
+        {
+            if (e.getErrorCode() != ER_DUP_ENTRY)
+            {
+                LOG(ERROR) << "SQL Error registering user: " << e.what()
+                           << " (MySQL error code: " << e.getErrorCode()
+                           << ", SQLState: " << e.getSQLState() << ")";
+                conn.checkError(e);
+                return RegisterResult::failed;
+            }
+        }
+
+        // 违反唯一约束，INSERT 已结束，再查询是哪个字段冲突
+        auto const result = duplicateKeyResult(conn, user);
+        if (result == RegisterResult::username_taken)
+        {
+            LOG(WARNING) << "Username already exists: " << user.username;
+        }
+        else if (result == RegisterResult::phone_taken)
+        {
+            LOG(WARNING) << "Phone number already exists: " << user.phone;
+        }
+        return result;
+    }
+
+    RegistrationBatcher &RegistrationBatcher::getInstance()
+    {
+        static RegistrationBatcher instance;
+        return instance;
+    }
+
+    bool RegistrationBatcher::initialize(size_t max_batch, size_t max_inflight)
+    {
+        if (enabled())
+        {
+            LOG(WARNING) << "Registration batcher already initialized";
+            return false;
+        }
+
+        max_inflight_ = max_inflight == 0 ? 1 : max_inflight;
+        max_batch_ = max_batch;
+
+        LOG(INFO) << "Registration batching enabled: up to " << max_batch_ << " rows per INSERT, "
+                  << max_inflight_ << " concurrent batches";
+        return true;
+    }
+
+    void RegistrationBatcher::submit(UserRecord user, handler_type handler)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back({std::move(user), std::move(handler)});
+
+            // 所有批次都在执行时只排队，下一批会带上它们
+            if (inflight_ >= max_inflight_)
+            {
+                return;
+            }
+            ++inflight_;
+        }
+
+        boost::asio::post(Executor::getInstance().get_executor(), [this]
+                          { flush(); });
+    }
+
+    void RegistrationBatcher::flush()
+    {
+        std::vector<pending> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            while (!queue_.empty() && batch.size() < max_batch_)
+            {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+
+        if (!batch.empty())
+        {
+            std::vector<RegisterResult> results(batch.size(), RegisterResult::failed);
+            insertBatch(batch, results);
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                batch[i].handler(results[i]);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.empty())
+            {
+                --inflight_;
+                return;
+            }
+        }
+
+        // 执行期间又有请求到达，继续下一批
+        boost::asio::post(Executor::getInstance().get_executor(), [this]
+                          { flush(); });
+    }
+
+    void RegistrationBatcher::insertBatch(std::vector<pending> &batch, std::vector<RegisterResult> &results)
+    {
+        auto conn = ConnectionPool::getInstance().getConnection();
+        if (!conn)
+        {
+            LOG(ERROR) << "Failed to get database connection for user registration";
+            return;
+        }
+
+        if (batch.size() == 1)
+        {
+            results[0] = insertUser(*conn, batch[0].user);
+            return;
+        }
+
+        try
+        {
+            auto *stmt = conn->prepare(insertUsersSql(batch.size()));
+            int index = 1;
+            for (auto const &p : batch)
+            {
+                stmt->setString(index++, p.user.username);
+                stmt->setString(index++, p.user.password);
+                stmt->setString(index++, p.user.phone);
+            }
+            stmt->execute();
+
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                UserCache::getInstance().put(batch[i].user);
+                results[i] = RegisterResult::ok;
+            }
+            return;
+        }
+        catch (const sql::SQLException &e)
+        {
+            if (e.getErrorCode() != ER_DUP_ENTRY)
+            {
+                LOG(ERROR) << "SQL Error registering " << batch.size() << " users: " << e.what()
+                           << " (MySQL error code: " << e.getErrorCode()
+                           << ", SQLState: " << e.getSQLState() << ")";
+                conn->checkError(e);
+                return;
+            }
+        }
+
+        // 批次中至少有一行冲突，整条语句已回滚，逐条插入确定每行的结果
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            results[i] = insertUser(*conn, batch[i].user);
+        }
+    }
+
+} // namespace db
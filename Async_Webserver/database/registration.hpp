@@ -0,0 +1,67 @@
+#ifndef DB_REGISTRATION_HPP
+#define DB_REGISTRATION_HPP
+
+#include "db_pool.hpp"
+#include "user_cache.hpp"
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace db
+{
+    enum class RegisterResult
+    {
+        ok,
+        username_taken,
+        phone_taken,
+        failed
+    };
+
+    // 重复键错误（1062）之后查询冲突的记录，得到用户名或手机号已存在；
+    // 冲突的记录已不存在或查询失败时返回 failed
+    RegisterResult duplicateKeyResult(PooledConnection &conn, const UserRecord &user);
+
+    // 单条 INSERT 完成注册，依靠 users 表的唯一约束检测冲突；成功后放入用户缓存
+    RegisterResult insertUser(PooledConnection &conn, const UserRecord &user);
+
+    // 批量注册：并发的注册请求排队，由数据库线程池合并为多行 INSERT。
+    // 多行 INSERT 遇到重复键时整体回滚，此时退回逐条插入以得到每个请求的结果
+    class RegistrationBatcher
+    {
+    public:
+        using handler_type = std::function<void(RegisterResult)>;
+
+        static RegistrationBatcher &getInstance();
+
+        // max_batch：单条 INSERT 最多包含的行数；max_inflight：同时执行的批次数
+        bool initialize(size_t max_batch, size_t max_inflight);
+        bool enabled() const { return max_batch_ > 0; }
+
+        // 提交注册请求，handler 在数据库线程上调用
+        void submit(UserRecord user, handler_type handler);
+
+    private:
+        RegistrationBatcher() = default;
+
+        struct pending
+        {
+            UserRecord user;
+            handler_type handler;
+        };
+
+        void flush();
+        void insertBatch(std::vector<pending> &batch, std::vector<RegisterResult> &results);
+
+        size_t max_batch_{0};
+        size_t max_inflight_{1};
+
+        std::mutex mutex_;
+        std::deque<pending> queue_;
+        size_t inflight_{0}; // 已提交到线程池、尚未结束的批次数
+    };
+
+} // namespace db
+
+#endif // DB_REGISTRATION_HPP
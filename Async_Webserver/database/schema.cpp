@@ -9,7 +9,7 @@ namespace db
 
     bool initializeSchema(ConnectionPool &pool)
     {
-        auto conn = pool.getConnection(); // 获取数据库连接
+        auto conn = pool.getConnection(); // 获取数据库连接，离开作用域时自动归还
         if (!conn)
         {
             LOG(ERROR) << "Failed to get database connection for schema initialization";
@@ -19,13 +19,12 @@ namespace db
         try
         {
             // 创建 Statement 对象
-            std::unique_ptr<sql::Statement> stmt(conn->createStatement());
+            std::unique_ptr<sql::Statement> stmt(conn->connection()->createStatement());
 
             // 执行 SQL 语句，创建 Users 表
             stmt->execute(CREATE_USERS_TABLE);
 
             LOG(INFO) << "Database schema initialized successfully";
-            pool.releaseConnection(conn);
             return true;
         }
         catch (const sql::SQLException &e)
@@ -33,13 +32,12 @@ namespace db
             LOG(ERROR) << "SQL Error initializing schema: " << e.what()
                        << " (MySQL error code: " << e.getErrorCode()
                        << ", SQLState: " << e.getSQLState() << ")";
-            pool.releaseConnection(conn);
+            conn->checkError(e);
             return false;
         }
         catch (const std::exception &e)
         {
             LOG(ERROR) << "Error initializing database schema: " << e.what();
-            pool.releaseConnection(conn);
             return false;
         }
     }
@@ -0,0 +1,203 @@
+#include "user_cache.hpp"
+
+#include <glog/logging.h>
+#include <functional>
+
+namespace db
+{
+    UserCache::entry *UserCache::lru_table::find(std::string_view username)
+    {
+        auto it = index.find(username);
+        if (it == index.end())
+        {
+            return nullptr;
+        }
+        items.splice(items.begin(), items, it->second);
+        return &*it->second;
+    }
+
+    void UserCache::lru_table::put(entry e)
+    {
+        if (capacity == 0)
+        {
+            return;
+        }
+
+        erase(e.record.username);
+        items.push_front(std::move(e));
+        index.emplace(items.front().record.username, items.begin());
+
+        while (items.size() > capacity)
+        {
+            index.erase(items.back().record.username);
+            items.pop_back();
+        }
+    }
+
+    void UserCache::lru_table::erase(std::string_view username)
+    {
+        auto it = index.find(username);
+        if (it == index.end())
+        {
+            return;
+        }
+        auto item = it->second;
+        index.erase(it); // 先删除索引，键引用的是条目中的字符串
+        items.erase(item);
+    }
+
+    void UserCache::lru_table::clear()
+    {
+        index.clear();
+        items.clear();
+    }
+
+    UserCache &UserCache::getInstance()
+    {
+        static UserCache instance;
+        return instance;
+    }
+
+    bool UserCache::initialize(size_t max_entries,
+                               size_t max_negative_entries,
+                               size_t shard_count,
+                               std::chrono::seconds ttl,
+                               std::chrono::seconds negative_ttl)
+    {
+        if (enabled())
+        {
+            LOG(WARNING) << "User cache already initialized";
+            return false;
+        }
+
+        if (shard_count == 0)
+        {
+            shard_count = 1;
+        }
+
+        ttl_ = ttl;
+        negative_ttl_ = negative_ttl;
+
+        shards_.clear();
+        for (size_t i = 0; i < shard_count; ++i)
+        {
+            auto s = std::make_unique<shard>();
+            s->users.capacity = (max_entries + shard_count - 1) / shard_count;
+            s->missing.capacity = negative_ttl.count() > 0
+                                      ? (max_negative_entries + shard_count - 1) / shard_count
+                                      : 0;
+            shards_.push_back(std::move(s));
+        }
+
+        enabled_.store(true, std::memory_order_release);
+        LOG(INFO) << "User cache initialized: " << max_entries << " entries, "
+                  << max_negative_entries << " negative entries, " << shard_count << " shards, ttl "
+                  << ttl.count() << "s, negative ttl " << negative_ttl.count() << "s";
+        return true;
+    }
+
+    UserCache::shard &UserCache::shard_for(std::string_view username)
+    {
+        return *shards_[std::hash<std::string_view>{}(username) % shards_.size()];
+    }
+
+    UserCache::lookup_result UserCache::find(const std::string &username, UserRecord &record)
+    {
+        if (!enabled())
+        {
+            return lookup_result::miss;
+        }
+
+        auto const now = std::chrono::steady_clock::now();
+        auto &s = shard_for(username);
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        if (auto *e = s.users.find(username))
+        {
+            if (e->expires > now)
+            {
+                record = e->record;
+                return lookup_result::found;
+            }
+            s.users.erase(username);
+        }
+
+        if (auto *e = s.missing.find(username))
+        {
+            if (e->expires > now)
+            {
+                return lookup_result::not_found;
+            }
+            s.missing.erase(username);
+        }
+        return lookup_result::miss;
+    }
+
+    void UserCache::put(UserRecord record)
+    {
+        if (!enabled())
+        {
+            return;
+        }
+
+        auto &s = shard_for(record.username);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        ++s.generation;
+        s.missing.erase(record.username);
+        s.users.put({std::move(record), std::chrono::steady_clock::now() + ttl_});
+    }
+
+    uint64_t UserCache::generation(const std::string &username)
+    {
+        if (!enabled())
+        {
+            return 0;
+        }
+
+        auto &s = shard_for(username);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.generation;
+    }
+
+    void UserCache::putMissing(const std::string &username, uint64_t generation)
+    {
+        if (!enabled())
+        {
+            return;
+        }
+
+        auto &s = shard_for(username);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.generation != generation)
+        {
+            // 查询期间有更新的记录放入（可能正是这个用户名），不能用旧结果覆盖
+            return;
+        }
+        s.users.erase(username);
+        s.missing.put({{username, {}, {}}, std::chrono::steady_clock::now() + negative_ttl_});
+    }
+
+    void UserCache::erase(const std::string &username)
+    {
+        if (!enabled())
+        {
+            return;
+        }
+
+        auto &s = shard_for(username);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.users.erase(username);
+        s.missing.erase(username);
+    }
+
+    void UserCache::clear()
+    {
+        for (auto &s : shards_)
+        {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            s->users.clear();
+            s->missing.clear();
+        }
+    }
+
+} // namespace db
@@ -0,0 +1,103 @@
+#ifndef USER_CACHE_HPP
+#define USER_CACHE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace db
+{
+    // users 表中与登录相关的字段
+    struct UserRecord
+    {
+        std::string username;
+        std::string password;
+        std::string phone;
+    };
+
+    // 用户记录缓存：按用户名哈希分片，每个分片独立加锁并按 LRU 淘汰，条目在 TTL 后过期。
+    // 不存在的用户名单独缓存（较短的 TTL、独立的容量），重复的枚举请求不会到达数据库，
+    // 也不会挤掉已存在用户的记录
+    class UserCache
+    {
+    public:
+        enum class lookup_result
+        {
+            miss,     // 没有缓存或已过期，需要查询数据库
+            found,    // 用户存在，record 已填充
+            not_found // 用户不存在（负缓存）
+        };
+
+        static UserCache &getInstance();
+
+        bool initialize(size_t max_entries,
+                        size_t max_negative_entries,
+                        size_t shard_count,
+                        std::chrono::seconds ttl,
+                        std::chrono::seconds negative_ttl);
+
+        bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+        lookup_result find(const std::string &username, UserRecord &record);
+
+        // 放入用户记录，同时清除该用户名的负缓存
+        void put(UserRecord record);
+
+        // 查询数据库之前取得，交给 putMissing。该分片此后每次 put 都会使其失效
+        uint64_t generation(const std::string &username);
+
+        // 记录用户名不存在。若取得 generation 之后该分片有过 put（例如并发的注册），
+        // 查询结果可能已过时，不做任何修改
+        void putMissing(const std::string &username, uint64_t generation);
+
+        void erase(const std::string &username);
+        void clear();
+
+    private:
+        UserCache() = default;
+
+        struct entry
+        {
+            UserRecord record; // 负缓存只使用 record.username
+            std::chrono::steady_clock::time_point expires;
+        };
+
+        // 带容量上限的 LRU 表，索引的键指向条目中的 username
+        struct lru_table
+        {
+            std::list<entry> items; // 表头为最近使用
+            std::unordered_map<std::string_view, std::list<entry>::iterator> index;
+            size_t capacity{0};
+
+            entry *find(std::string_view username);
+            void put(entry e);
+            void erase(std::string_view username);
+            void clear();
+        };
+
+        struct shard
+        {
+            std::mutex mutex;
+            lru_table users;
+            lru_table missing;
+            uint64_t generation{0}; // 每次 put 递增
+        };
+
+        shard &shard_for(std::string_view username);
+
+        std::vector<std::unique_ptr<shard>> shards_;
+        std::chrono::seconds ttl_{0};
+        std::chrono::seconds negative_ttl_{0};
+        std::atomic<bool> enabled_{false};
+    };
+
+} // namespace db
+
+#endif // USER_CACHE_HPP
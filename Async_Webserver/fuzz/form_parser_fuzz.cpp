@@ -0,0 +1,67 @@
+// 表单解析的 libFuzzer 入口：make fuzz 后运行 ./fuzz/form_parser_fuzz
+// 第一个字节选择解析方式，其余字节作为请求体
+#include "../http_server/form_parser.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // 字段必须落在请求体内
+    void check_inside(std::string_view view, char const *begin, char const *end)
+    {
+        if (!view.empty() && (view.data() < begin || view.data() + view.size() > end))
+        {
+            std::abort();
+        }
+    }
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(std::uint8_t const *data, std::size_t size)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    unsigned const mode = data[0] % 4;
+    std::vector<char> body(data + 1, data + size);
+    char *const begin = body.data();
+    char *const end = begin + body.size();
+
+    http_server::form_data form;
+    switch (mode)
+    {
+    case 0:
+        http_server::parse_form("application/x-www-form-urlencoded", begin, body.size(), form);
+        break;
+    case 1:
+        http_server::parse_form("multipart/form-data; boundary=\"xyz\"", begin, body.size(), form);
+        break;
+    case 2:
+        http_server::parse_form("application/json", begin, body.size(), form);
+        break;
+    default:
+    {
+        // 解码结果不会比原文长
+        if (http_server::percent_decode(begin, body.size()) > body.size())
+        {
+            std::abort();
+        }
+        return 0;
+    }
+    }
+
+    if (form.size() > http_server::form_data::max_fields)
+    {
+        std::abort();
+    }
+    for (auto const &field : form)
+    {
+        check_inside(field.name, begin, end);
+        check_inside(field.value, begin, end);
+    }
+    return 0;
+}
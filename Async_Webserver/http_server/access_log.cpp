@@ -0,0 +1,421 @@
+#include "access_log.hpp"
+
+#include <glog/logging.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+namespace http_server
+{
+    namespace
+    {
+        constexpr std::size_t batch_size = 64 * 1024;                  // 攒够后立即写出
+        constexpr auto flush_interval = std::chrono::milliseconds(50); // 后台线程的轮询间隔
+
+        constexpr std::string_view event_names[] = {"open", "request", "client_close", "server_close"};
+
+        std::size_t round_up_pow2(std::size_t n)
+        {
+            std::size_t p = 1;
+            while (p < n)
+            {
+                p *= 2;
+            }
+            return p;
+        }
+
+        template <class T>
+        void append_number(std::string &out, T value)
+        {
+            char buffer[24];
+            auto const result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        }
+
+        // "a.b.c.d:port" 或 "[v6]:port"
+        void append_peer(std::string &out, tcp::endpoint const &peer)
+        {
+            char buffer[INET6_ADDRSTRLEN];
+            auto const *sa = peer.data();
+            if (sa->sa_family == AF_INET6)
+            {
+                auto const *sin6 = reinterpret_cast<sockaddr_in6 const *>(sa);
+                out += '[';
+                out += ::inet_ntop(AF_INET6, &sin6->sin6_addr, buffer, sizeof(buffer)) ? buffer : "?";
+                out += ']';
+            }
+            else
+            {
+                auto const *sin = reinterpret_cast<sockaddr_in const *>(sa);
+                out += ::inet_ntop(AF_INET, &sin->sin_addr, buffer, sizeof(buffer)) ? buffer : "?";
+            }
+            out += ':';
+            append_number(out, peer.port());
+        }
+
+        // JSON 字符串转义：引号、反斜杠与控制字符
+        void append_escaped(std::string &out, std::string_view s)
+        {
+            constexpr char hex[] = "0123456789abcdef";
+            for (char c : s)
+            {
+                auto const u = static_cast<unsigned char>(c);
+                if (c == '"' || c == '\\')
+                {
+                    out += '\\';
+                    out += c;
+                }
+                else if (u < 0x20 || u == 0x7f)
+                {
+                    out += "\\u00";
+                    out += hex[u >> 4];
+                    out += hex[u & 0xf];
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+    } // namespace
+
+    AccessLog &AccessLog::getInstance()
+    {
+        static AccessLog instance;
+        return instance;
+    }
+
+    AccessLog::~AccessLog()
+    {
+        shutdown();
+    }
+
+    AccessLog::ring::ring(std::size_t capacity)
+        : records(new access_record[capacity]), mask(capacity - 1)
+    {
+    }
+
+    bool AccessLog::ring::push(access_record const &record)
+    {
+        auto const h = head.load(std::memory_order_relaxed);
+        if (h - cached_tail > mask)
+        {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h - cached_tail > mask)
+            {
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        records[h & mask] = record;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool AccessLog::initialize(const std::string &path, std::size_t ring_size,
+                               std::uint64_t max_bytes, std::size_t max_files)
+    {
+        if (writer_.joinable() || path.empty())
+        {
+            return false;
+        }
+
+        path_ = path;
+        ring_size_ = round_up_pow2(std::max<std::size_t>(ring_size, 64));
+        max_bytes_ = max_bytes;
+        max_files_ = max_files;
+
+        if (!open_file())
+        {
+            return false;
+        }
+
+        stop_ = false;
+        writer_ = std::thread(&AccessLog::run, this);
+        enabled_.store(true, std::memory_order_relaxed);
+        LOG(INFO) << "Access log enabled: " << path_ << ", " << ring_size_ << " records per thread";
+        return true;
+    }
+
+    void AccessLog::shutdown()
+    {
+        if (!writer_.joinable())
+        {
+            return;
+        }
+
+        enabled_.store(false, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        writer_.join();
+
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+
+        if (auto const n = dropped())
+        {
+            LOG(WARNING) << "Access log dropped " << n << " records because the queue was full";
+        }
+    }
+
+    void AccessLog::connection_event(access_record::kind event, tcp::endpoint const &peer)
+    {
+        if (!enabled())
+        {
+            return;
+        }
+
+        access_record record;
+        record.event = event;
+        record.peer = peer;
+        push(record);
+    }
+
+    void AccessLog::request(tcp::endpoint const &peer, http::verb method, std::string_view target, unsigned status,
+                            std::uint64_t bytes, std::chrono::steady_clock::duration duration)
+    {
+        if (!enabled())
+        {
+            return;
+        }
+
+        access_record record;
+        record.event = access_record::kind::request;
+        record.peer = peer;
+        record.method = method;
+        record.status = static_cast<std::uint16_t>(status);
+        record.bytes = bytes;
+        auto const us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        record.duration_us = static_cast<std::uint32_t>(std::clamp<std::int64_t>(us, 0, UINT32_MAX));
+        auto const n = std::min(target.size(), access_record::max_target);
+        std::memcpy(record.target, target.data(), n);
+        record.target_size = static_cast<std::uint8_t>(n);
+        push(record);
+    }
+
+    void AccessLog::push(access_record &record)
+    {
+        record.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count();
+        local().push(record);
+    }
+
+    std::uint64_t AccessLog::dropped() const
+    {
+        std::uint64_t total = 0;
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto const &r : rings_)
+        {
+            total += r->dropped.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    AccessLog::ring *AccessLog::register_thread()
+    {
+        auto r = std::make_unique<ring>(ring_size_);
+        auto *p = r.get();
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(std::move(r));
+        return p;
+    }
+
+    void AccessLog::run()
+    {
+        std::string batch;
+        batch.reserve(batch_size + 1024);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_)
+        {
+            // I/O 线程放入记录时不通知，按固定间隔取出
+            cv_.wait_for(lock, flush_interval, [this]
+                         { return stop_; });
+            lock.unlock();
+            while (drain(batch))
+            {
+            }
+            write_batch(batch);
+            lock.lock();
+        }
+        lock.unlock();
+
+        // 停止前取出剩余记录
+        while (drain(batch))
+        {
+        }
+        write_batch(batch);
+    }
+
+    bool AccessLog::drain(std::string &batch)
+    {
+        std::vector<ring *> rings;
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings.reserve(rings_.size());
+            for (auto const &r : rings_)
+            {
+                rings.push_back(r.get());
+            }
+        }
+
+        std::uint64_t count = 0;
+        for (auto *r : rings)
+        {
+            auto const t = r->tail.load(std::memory_order_relaxed);
+            auto const h = r->head.load(std::memory_order_acquire);
+            for (auto i = t; i != h; ++i)
+            {
+                auto const &record = r->records[i & r->mask];
+
+                auto const seconds = record.time_ns / 1000000000;
+                if (seconds != cached_second_)
+                {
+                    auto const time = static_cast<std::time_t>(seconds);
+                    std::tm tm{};
+                    ::gmtime_r(&time, &tm);
+                    std::strftime(cached_time_, sizeof(cached_time_), "%Y-%m-%dT%H:%M:%S", &tm);
+                    cached_second_ = seconds;
+                }
+                char fraction[8];
+                auto const us = static_cast<unsigned>(record.time_ns % 1000000000 / 1000);
+                std::snprintf(fraction, sizeof(fraction), ".%06u", us);
+
+                batch += "{\"time\":\"";
+                batch += cached_time_;
+                batch += fraction;
+                batch += "Z\",\"event\":\"";
+                batch += event_names[static_cast<std::size_t>(record.event)];
+                batch += "\",\"peer\":\"";
+                append_peer(batch, record.peer);
+                batch += '"';
+                if (record.event == access_record::kind::request)
+                {
+                    batch += ",\"method\":\"";
+                    auto const method = http::to_string(record.method);
+                    batch.append(method.data(), method.size());
+                    batch += "\",\"target\":\"";
+                    append_escaped(batch, std::string_view(record.target, record.target_size));
+                    batch += "\",\"status\":";
+                    append_number(batch, record.status);
+                    batch += ",\"bytes\":";
+                    append_number(batch, record.bytes);
+                    batch += ",\"duration_us\":";
+                    append_number(batch, record.duration_us);
+                }
+                batch += "}\n";
+
+                if (batch.size() >= batch_size)
+                {
+                    write_batch(batch);
+                }
+            }
+            r->tail.store(h, std::memory_order_release);
+            count += h - t;
+        }
+
+        written_.store(written_.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        return count != 0;
+    }
+
+    void AccessLog::write_batch(std::string &batch)
+    {
+        if (batch.empty())
+        {
+            return;
+        }
+
+        if (max_bytes_ != 0 && file_size_ != 0 && file_size_ + batch.size() > max_bytes_)
+        {
+            rotate();
+        }
+        if (fd_ < 0 && !open_file())
+        {
+            batch.clear();
+            return;
+        }
+
+        char const *data = batch.data();
+        std::size_t left = batch.size();
+        while (left != 0)
+        {
+            auto const n = ::write(fd_, data, left);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                LOG_EVERY_N(WARNING, 1000) << "Access log write failed: " << std::strerror(errno);
+                break;
+            }
+            data += n;
+            left -= static_cast<std::size_t>(n);
+        }
+        file_size_ += batch.size() - left;
+        batch.clear();
+    }
+
+    bool AccessLog::open_file()
+    {
+        std::error_code ec;
+        auto const parent = std::filesystem::path(path_).parent_path();
+        if (!parent.empty())
+        {
+            std::filesystem::create_directories(parent, ec);
+        }
+
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+        {
+            LOG_EVERY_N(ERROR, 1000) << "Cannot open access log " << path_ << ": " << std::strerror(errno);
+            return false;
+        }
+
+        struct stat st;
+        file_size_ = ::fstat(fd_, &st) == 0 ? static_cast<std::uint64_t>(st.st_size) : 0;
+        return true;
+    }
+
+    // path -> path.1 -> path.2 ...，最旧的被覆盖
+    void AccessLog::rotate()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+
+        if (max_files_ == 0)
+        {
+            ::unlink(path_.c_str());
+        }
+        else
+        {
+            for (auto i = max_files_; i > 1; --i)
+            {
+                ::rename((path_ + '.' + std::to_string(i - 1)).c_str(), (path_ + '.' + std::to_string(i)).c_str());
+            }
+            ::rename(path_.c_str(), (path_ + ".1").c_str());
+        }
+        file_size_ = 0;
+        open_file();
+    }
+
+} // namespace http_server
@@ -0,0 +1,146 @@
+#ifndef ACCESS_LOG_HPP
+#define ACCESS_LOG_HPP
+
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/http/verb.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace http = boost::beast::http;
+using tcp = boost::asio::ip::tcp;
+
+namespace http_server
+{
+    // 一条访问日志记录，定长，I/O 线程只做复制，格式化留给后台线程
+    struct access_record
+    {
+        enum class kind : std::uint8_t
+        {
+            open,         // 接受连接
+            request,      // 一个请求的响应已写出
+            client_close, // 对端关闭连接
+            server_close, // 请求不保持连接，服务器关闭
+        };
+
+        static constexpr std::size_t max_target = 160; // 更长的请求目标被截断
+
+        std::int64_t time_ns{0}; // system_clock，自纪元起的纳秒
+        tcp::endpoint peer;      // 接受连接时取得，之后不再调用 getpeername
+        std::uint64_t bytes{0};  // 响应写出的字节数（含响应头）
+        std::uint32_t duration_us{0};
+        std::uint16_t status{0};
+        http::verb method{http::verb::unknown};
+        kind event{kind::request};
+        std::uint8_t target_size{0};
+        char target[max_target];
+    };
+
+    // 异步批量写出的访问日志，取代每个连接、每个请求在 I/O 线程上同步格式化的 glog 调用。
+    // 每个 I/O 线程把记录放入自己的单生产者单消费者环形队列（无锁，不唤醒后台线程），
+    // 后台线程定期取出全部记录，格式化为 JSON 行后一次 write(2) 写出，文件超过上限时轮转。
+    // 队列满时丢弃记录并计数，不阻塞 I/O 线程
+    class AccessLog
+    {
+    public:
+        static AccessLog &getInstance();
+
+        // ring_size 为每个线程的队列容量（条，向上取 2 的幂）；max_bytes 为 0 时不轮转，
+        // 否则保留 path.1 ... path.<max_files> 共 max_files 个旧文件
+        bool initialize(const std::string &path, std::size_t ring_size,
+                        std::uint64_t max_bytes, std::size_t max_files);
+        void shutdown(); // 写出剩余记录后停止后台线程
+
+        bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        void connection_opened(tcp::endpoint const &peer) { connection_event(access_record::kind::open, peer); }
+        void connection_closed(tcp::endpoint const &peer, bool by_client)
+        {
+            connection_event(by_client ? access_record::kind::client_close : access_record::kind::server_close, peer);
+        }
+
+        void request(tcp::endpoint const &peer, http::verb method, std::string_view target, unsigned status,
+                     std::uint64_t bytes, std::chrono::steady_clock::duration duration);
+
+        std::uint64_t dropped() const; // 因队列满而丢弃的记录数
+        std::uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+
+    private:
+        AccessLog() = default;
+        ~AccessLog();
+        AccessLog(const AccessLog &) = delete;
+        AccessLog &operator=(const AccessLog &) = delete;
+
+        // 单生产者（所属 I/O 线程）单消费者（后台线程）的环形队列。
+        // head_ 只由生产者写，tail_ 只由消费者写，各占一个缓存行；
+        // 生产者缓存 tail_，只有队列看起来已满时才重新读取
+        struct alignas(64) ring
+        {
+            explicit ring(std::size_t capacity);
+
+            bool push(access_record const &record);
+
+            std::unique_ptr<access_record[]> records;
+            std::size_t mask;
+            alignas(64) std::atomic<std::uint64_t> head{0};
+            std::uint64_t cached_tail{0};
+            std::atomic<std::uint64_t> dropped{0}; // 只由生产者写
+            alignas(64) std::atomic<std::uint64_t> tail{0};
+        };
+
+        void connection_event(access_record::kind event, tcp::endpoint const &peer);
+        void push(access_record &record);
+
+        ring &local()
+        {
+            thread_local ring *r = nullptr;
+            if (!r)
+            {
+                r = register_thread();
+            }
+            return *r;
+        }
+
+        ring *register_thread();
+
+        void run();
+        bool drain(std::string &batch); // 取出所有队列中的记录，返回是否取到
+        void write_batch(std::string &batch);
+        bool open_file();
+        void rotate();
+
+        std::atomic<bool> enabled_{false};
+        std::size_t ring_size_{0};
+        std::string path_;
+        std::uint64_t max_bytes_{0};
+        std::size_t max_files_{0};
+
+        // 线程退出后其队列保留，后台线程仍会取出剩余记录
+        mutable std::mutex rings_mutex_;
+        std::vector<std::unique_ptr<ring>> rings_;
+
+        // 以下只由后台线程访问
+        int fd_{-1};
+        std::uint64_t file_size_{0};
+        std::int64_t cached_second_{-1};
+        char cached_time_[32]{};
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        bool stop_{false};
+        std::thread writer_;
+        std::atomic<std::uint64_t> written_{0};
+    };
+
+} // namespace http_server
+
+#endif // ACCESS_LOG_HPP
@@ -0,0 +1,113 @@
+#include "admission.hpp"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+namespace http_server
+{
+    Admission &Admission::getInstance()
+    {
+        static Admission instance;
+        return instance;
+    }
+
+    void Admission::initialize(admission_options const &options)
+    {
+        max_sessions_ = options.max_sessions;
+        classes_[index(request_class::light)].limit.store(options.max_light_inflight, std::memory_order_relaxed);
+        classes_[index(request_class::database)].limit.store(options.max_db_inflight, std::memory_order_relaxed);
+        retry_after_ = std::to_string(std::max(options.retry_after, 1u));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        adaptive_ = options.adaptive && options.max_db_inflight != 0;
+        if (options.adaptive && !adaptive_)
+        {
+            LOG(WARNING) << "Adaptive database concurrency needs admission.max_db_inflight, using no limit";
+        }
+        max_db_limit_ = static_cast<double>(options.max_db_inflight);
+        min_db_limit_ = std::clamp(static_cast<double>(options.min_db_inflight), 1.0, std::max(max_db_limit_, 1.0));
+        backoff_ = std::clamp(options.backoff, 0.1, 0.99);
+        latency_target_ = options.db_latency_target;
+        db_limit_ = max_db_limit_; // 从上限开始，延迟超过目标后才收缩
+
+        LOG(INFO) << "Admission control: max sessions " << max_sessions_
+                  << ", max light requests " << options.max_light_inflight
+                  << ", max database requests " << options.max_db_inflight
+                  << (adaptive_ ? " (adaptive)" : "");
+    }
+
+    bool Admission::try_open_session()
+    {
+        if (max_sessions_ == 0)
+        {
+            return true;
+        }
+        if (sessions_.fetch_add(1, std::memory_order_relaxed) >= max_sessions_)
+        {
+            sessions_.fetch_sub(1, std::memory_order_relaxed);
+            accept_pauses_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void Admission::close_session()
+    {
+        if (max_sessions_ != 0)
+        {
+            sessions_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool Admission::try_acquire(request_class c)
+    {
+        auto &s = classes_[index(c)];
+        auto const limit = s.limit.load(std::memory_order_relaxed);
+        if (s.inflight.fetch_add(1, std::memory_order_relaxed) >= limit && limit != 0)
+        {
+            s.inflight.fetch_sub(1, std::memory_order_relaxed);
+            s.rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void Admission::release(request_class c)
+    {
+        classes_[index(c)].inflight.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void Admission::record_db_latency(std::chrono::steady_clock::duration latency)
+    {
+        if (!adaptive_)
+        {
+            return;
+        }
+
+        auto &db = classes_[index(request_class::database)];
+        auto const now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (latency > latency_target_)
+        {
+            // 同一批超时的请求只收缩一次：距上次收缩不足一个目标延迟时忽略
+            if (now - last_decrease_ < latency_target_)
+            {
+                return;
+            }
+            last_decrease_ = now;
+            db_limit_ = std::max(min_db_limit_, db_limit_ * backoff_);
+            LOG_EVERY_N(WARNING, 10) << "Database latency "
+                                     << std::chrono::duration_cast<std::chrono::milliseconds>(latency).count()
+                                     << " ms over target, database request limit lowered to "
+                                     << static_cast<std::size_t>(db_limit_);
+        }
+        else if (static_cast<double>(db.inflight.load(std::memory_order_relaxed)) * 2 >= db_limit_)
+        {
+            // 加性增长：每完成约 limit 个请求加 1；负载远低于上限时不增长，避免空闲期间上限失去意义
+            db_limit_ = std::min(max_db_limit_, db_limit_ + 1.0 / db_limit_);
+        }
+        db.limit.store(static_cast<std::size_t>(db_limit_), std::memory_order_relaxed);
+    }
+
+} // namespace http_server
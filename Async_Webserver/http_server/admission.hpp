@@ -0,0 +1,169 @@
+#ifndef ADMISSION_HPP
+#define ADMISSION_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace http_server
+{
+    // 请求按开销分为两类，各自限制同时处理的数量
+    enum class request_class : std::uint8_t
+    {
+        light,    // 静态文件、/metrics 以及未知端点等只在 I/O 线程上处理的请求
+        database, // 登录、注册等需要数据库或密码哈希线程池的请求
+    };
+
+    struct admission_options
+    {
+        std::size_t max_sessions{0};       // 同时打开的连接数上限，达到后暂停 accept；0 为不限制
+        std::size_t max_light_inflight{0}; // 两类请求各自的并发上限，超出时直接返回 503；0 为不限制
+        std::size_t max_db_inflight{0};
+
+        // 数据库类请求的自适应上限（AIMD）：数据库延迟低于目标时每个窗口加 1，
+        // 超过目标时乘以 backoff，在 [min_db_inflight, max_db_inflight] 之间变化
+        bool adaptive{false};
+        std::size_t min_db_inflight{1};
+        std::chrono::milliseconds db_latency_target{200};
+        double backoff{0.9};
+
+        unsigned retry_after{1}; // 503 响应的 Retry-After（秒）
+    };
+
+    // 准入控制：过载时尽快拒绝，而不是让连接、内存和数据库连接池的等待者无限增长。
+    // 上限检查只是一次原子加减；未设上限的类别不计数，没有额外开销。
+    // initialize 须在开始接受连接前调用
+    class Admission
+    {
+    public:
+        static Admission &getInstance();
+
+        void initialize(admission_options const &options);
+
+        // 占用一个连接名额，已达上限时返回 false，调用方暂停 accept 后重试
+        bool try_open_session();
+        void close_session();
+
+        // 占用一个请求名额，已达上限时返回 false 并计入拒绝数
+        bool try_acquire(request_class c);
+        void release(request_class c);
+
+        // 一次数据库操作（含在数据库线程池中排队的时间）的耗时，用于调整数据库类请求的上限
+        void record_db_latency(std::chrono::steady_clock::duration latency);
+
+        std::string const &retry_after() const { return retry_after_; }
+
+        std::size_t sessions() const { return sessions_.load(std::memory_order_relaxed); }
+        std::size_t inflight(request_class c) const { return classes_[index(c)].inflight.load(std::memory_order_relaxed); }
+        std::size_t limit(request_class c) const { return classes_[index(c)].limit.load(std::memory_order_relaxed); }
+        std::uint64_t rejected(request_class c) const { return classes_[index(c)].rejected.load(std::memory_order_relaxed); }
+        std::uint64_t accept_pauses() const { return accept_pauses_.load(std::memory_order_relaxed); }
+
+    private:
+        Admission() = default;
+        Admission(const Admission &) = delete;
+        Admission &operator=(const Admission &) = delete;
+
+        static constexpr std::size_t index(request_class c) { return static_cast<std::size_t>(c); }
+
+        // 各类别的计数器被所有 I/O 线程修改，分别放在独立的缓存行上
+        struct alignas(64) class_state
+        {
+            std::atomic<std::size_t> inflight{0};
+            std::atomic<std::size_t> limit{0}; // 0 为不限制
+            std::atomic<std::uint64_t> rejected{0};
+        };
+
+        alignas(64) std::atomic<std::size_t> sessions_{0};
+        std::size_t max_sessions_{0};
+        std::atomic<std::uint64_t> accept_pauses_{0};
+        std::array<class_state, 2> classes_;
+        std::string retry_after_{"1"};
+
+        // AIMD 状态，只在 record_db_latency 中加锁访问
+        std::mutex mutex_;
+        bool adaptive_{false};
+        double db_limit_{0};
+        double min_db_limit_{1};
+        double max_db_limit_{0};
+        double backoff_{0.9};
+        std::chrono::steady_clock::duration latency_target_{};
+        std::chrono::steady_clock::time_point last_decrease_{};
+    };
+
+    // 一个请求占用的名额，析构时归还；未占用（类别不限制或被拒绝）时为空
+    class admission_ticket
+    {
+    public:
+        admission_ticket() = default;
+        admission_ticket(admission_ticket &&other) noexcept : class_(other.class_), held_(other.held_)
+        {
+            other.held_ = false;
+        }
+        admission_ticket &operator=(admission_ticket &&other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                class_ = other.class_;
+                held_ = other.held_;
+                other.held_ = false;
+            }
+            return *this;
+        }
+        ~admission_ticket() { reset(); }
+
+        // 占用 c 类的名额，已达上限时返回 false
+        bool acquire(request_class c)
+        {
+            reset();
+            auto &admission = Admission::getInstance();
+            if (admission.limit(c) == 0)
+            {
+                return true;
+            }
+            if (!admission.try_acquire(c))
+            {
+                return false;
+            }
+            class_ = c;
+            held_ = true;
+            return true;
+        }
+
+        void reset()
+        {
+            if (held_)
+            {
+                Admission::getInstance().release(class_);
+                held_ = false;
+            }
+        }
+
+    private:
+        request_class class_{request_class::light};
+        bool held_{false};
+    };
+
+    // 记录一次数据库操作的耗时：投递到数据库线程池时构造，结果返回时调用 done
+    class db_latency_sample
+    {
+    public:
+        db_latency_sample() : start_(std::chrono::steady_clock::now()) {}
+
+        void done() const
+        {
+            Admission::getInstance().record_db_latency(std::chrono::steady_clock::now() - start_);
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start_;
+    };
+
+} // namespace http_server
+
+#endif // ADMISSION_HPP
@@ -0,0 +1,203 @@
+#include "compressor.hpp"
+
+#include <boost/asio/post.hpp>
+#include <brotli/encode.h>
+#include <glog/logging.h>
+#include <zlib.h>
+
+#include <cstdlib>
+
+namespace http_server
+{
+    namespace
+    {
+        // gzip 格式压缩，失败返回 false
+        bool gzip_compress(const std::string &in, std::string &out, int level)
+        {
+            z_stream zs{};
+            // windowBits 加 16 表示输出 gzip 头
+            if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                return false;
+            }
+
+            out.resize(deflateBound(&zs, static_cast<uLong>(in.size())));
+            zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+            zs.avail_in = static_cast<uInt>(in.size());
+            zs.next_out = reinterpret_cast<Bytef *>(&out[0]);
+            zs.avail_out = static_cast<uInt>(out.size());
+
+            int ret = deflate(&zs, Z_FINISH);
+            out.resize(zs.total_out);
+            deflateEnd(&zs);
+            return ret == Z_STREAM_END;
+        }
+
+        bool brotli_compress(const std::string &in, std::string &out, int quality)
+        {
+            size_t size = BrotliEncoderMaxCompressedSize(in.size());
+            if (size == 0)
+            {
+                return false;
+            }
+            out.resize(size);
+            if (!BrotliEncoderCompress(quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                                       in.size(), reinterpret_cast<const uint8_t *>(in.data()),
+                                       &size, reinterpret_cast<uint8_t *>(&out[0])))
+            {
+                return false;
+            }
+            out.resize(size);
+            return true;
+        }
+
+        // 解析 q 值，缺省为 1
+        double parse_qvalue(http::param_list const &params)
+        {
+            for (auto const &param : params)
+            {
+                if (beast::iequals(param.first, "q"))
+                {
+                    std::string value(param.second);
+                    return std::strtod(value.c_str(), nullptr);
+                }
+            }
+            return 1.0;
+        }
+    } // namespace
+
+    content_coding negotiate_encoding(beast::string_view accept_encoding)
+    {
+        double br_q = 0, gzip_q = 0, any_q = -1;
+        bool br_listed = false, gzip_listed = false;
+
+        for (auto const &coding : http::ext_list{accept_encoding})
+        {
+            auto const name = coding.first;
+            double const q = parse_qvalue(coding.second);
+
+            if (beast::iequals(name, "br"))
+            {
+                br_q = q;
+                br_listed = true;
+            }
+            else if (beast::iequals(name, "gzip") || beast::iequals(name, "x-gzip"))
+            {
+                gzip_q = q;
+                gzip_listed = true;
+            }
+            else if (name == "*")
+            {
+                any_q = q;
+            }
+        }
+
+        // "*" 覆盖未显式列出的编码
+        if (any_q >= 0)
+        {
+            if (!br_listed)
+                br_q = any_q;
+            if (!gzip_listed)
+                gzip_q = any_q;
+        }
+
+        if (br_q > 0 && br_q >= gzip_q)
+            return content_coding::br;
+        if (gzip_q > 0)
+            return content_coding::gzip;
+        return content_coding::identity;
+    }
+
+    Compressor &Compressor::getInstance()
+    {
+        static Compressor instance;
+        return instance;
+    }
+
+    bool Compressor::initialize(size_t threads, size_t min_size, int gzip_level, int brotli_quality)
+    {
+        if (pool_)
+        {
+            LOG(WARNING) << "Compressor already initialized";
+            return false;
+        }
+
+        min_size_ = min_size;
+        gzip_level_ = gzip_level;
+        brotli_quality_ = brotli_quality;
+        pool_ = std::make_unique<net::thread_pool>(threads == 0 ? 1 : threads);
+
+        LOG(INFO) << "Compressor initialized with " << threads << " threads";
+        return true;
+    }
+
+    void Compressor::shutdown()
+    {
+        if (pool_)
+        {
+            pool_->stop();
+            pool_->join();
+            pool_.reset();
+        }
+    }
+
+    Compressor::~Compressor()
+    {
+        shutdown();
+    }
+
+    bool Compressor::should_compress(cached_file const &file) const
+    {
+        return file.mime->compressible && file.content.size() >= min_size_;
+    }
+
+    void Compressor::submit(cached_file_ptr file, content_coding coding)
+    {
+        if (!pool_)
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!pending_.insert(variant_key(file->path, coding)).second)
+            {
+                return; // 已在压缩中
+            }
+        }
+
+        net::post(*pool_, [this, file = std::move(file), coding]
+                  { compress(file, coding); });
+    }
+
+    void Compressor::compress(cached_file_ptr const &file, content_coding coding)
+    {
+        auto entry = std::make_shared<cached_file>();
+        init_variant(*entry, *file, coding);
+
+        bool ok = coding == content_coding::br
+                      ? brotli_compress(file->content, entry->content, brotli_quality_)
+                      : gzip_compress(file->content, entry->content, gzip_level_);
+
+        if (ok && entry->content.size() < file->content.size())
+        {
+            entry->headers.set(http::field::content_length, std::to_string(entry->content.size()));
+        }
+        else
+        {
+            // 压缩无收益：缓存一个 identity 标记，之后直接返回原文件
+            if (!ok)
+            {
+                LOG(WARNING) << "Failed to compress " << file->path;
+            }
+            entry->coding = content_coding::identity;
+            entry->content.clear();
+        }
+
+        FileCache::getInstance().insert(std::move(entry));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.erase(variant_key(file->path, coding));
+    }
+
+} // namespace http_server
@@ -0,0 +1,53 @@
+#ifndef COMPRESSOR_HPP
+#define COMPRESSOR_HPP
+
+#include "file_cache.hpp"
+
+#include <boost/asio/thread_pool.hpp>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace http_server
+{
+    // 根据 Accept-Encoding 选择响应编码，q 值相同时优先 br
+    content_coding negotiate_encoding(beast::string_view accept_encoding);
+
+    // 静态文件压缩器：在独立线程池中压缩缓存中的文件，结果写回 FileCache，
+    // 压缩期间请求先以原文返回，避免压缩耗时阻塞 I/O 线程
+    class Compressor
+    {
+    public:
+        static Compressor &getInstance();
+
+        bool initialize(size_t threads, size_t min_size, int gzip_level, int brotli_quality);
+        void shutdown();
+
+        bool enabled() const { return pool_ != nullptr; }
+
+        // 文件是否值得压缩（类型可压缩且不小于 min_size）
+        bool should_compress(cached_file const &file) const;
+
+        // 提交后台压缩任务，同一文件同一编码同时只压缩一次
+        void submit(cached_file_ptr file, content_coding coding);
+
+    private:
+        Compressor() = default;
+        ~Compressor();
+
+        void compress(cached_file_ptr const &file, content_coding coding);
+
+        std::unique_ptr<net::thread_pool> pool_;
+        size_t min_size_{256};
+        int gzip_level_{6};
+        int brotli_quality_{5};
+
+        std::mutex mutex_;
+        std::unordered_set<std::string> pending_; // 正在压缩的 variant_key
+    };
+
+} // namespace http_server
+
+#endif // COMPRESSOR_HPP
@@ -0,0 +1,314 @@
+#include "conditional.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace http_server
+{
+    namespace
+    {
+        // 单个 Range 请求最多允许的范围数，超过则忽略 Range
+        constexpr std::size_t max_ranges = 16;
+
+        void skip_ows(beast::string_view &s)
+        {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+            {
+                s.remove_prefix(1);
+            }
+        }
+
+        // 解析十进制无符号整数，至少一位数字
+        bool parse_uint(beast::string_view &s, std::uint64_t &value)
+        {
+            value = 0;
+            std::size_t digits = 0;
+            while (!s.empty() && s.front() >= '0' && s.front() <= '9')
+            {
+                if (value > (UINT64_MAX - 9) / 10)
+                {
+                    return false;
+                }
+                value = value * 10 + static_cast<std::uint64_t>(s.front() - '0');
+                s.remove_prefix(1);
+                ++digits;
+            }
+            return digits > 0;
+        }
+
+        // 去掉弱标记 W/ 后的 opaque-tag
+        beast::string_view opaque_tag(beast::string_view tag)
+        {
+            if (tag.size() >= 2 && tag[0] == 'W' && tag[1] == '/')
+            {
+                tag.remove_prefix(2);
+            }
+            return tag;
+        }
+    } // namespace
+
+    std::string make_etag(struct stat const &st)
+    {
+        char buf[96];
+        std::snprintf(buf, sizeof(buf), "\"%llx-%llx-%llx.%lx\"",
+                      static_cast<unsigned long long>(st.st_ino),
+                      static_cast<unsigned long long>(st.st_size),
+                      static_cast<unsigned long long>(st.st_mtim.tv_sec),
+                      static_cast<unsigned long>(st.st_mtim.tv_nsec));
+        return buf;
+    }
+
+    std::string format_http_date(std::time_t t)
+    {
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        char buf[64];
+        std::size_t n = std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+        return std::string(buf, n);
+    }
+
+    bool parse_http_date(beast::string_view value, std::time_t &t)
+    {
+        // strptime 需要以 '\0' 结尾的字符串，日期很短，复制到栈上
+        char s[64];
+        if (value.size() >= sizeof(s))
+        {
+            return false;
+        }
+        std::memcpy(s, value.data(), value.size());
+        s[value.size()] = '\0';
+        struct tm tm;
+
+        // IMF-fixdate、RFC 850 与 asctime 三种格式
+        for (char const *format : {"%a, %d %b %Y %H:%M:%S GMT",
+                                   "%A, %d-%b-%y %H:%M:%S GMT",
+                                   "%a %b %e %H:%M:%S %Y"})
+        {
+            std::memset(&tm, 0, sizeof(tm));
+            char const *end = strptime(s, format, &tm);
+            if (end && *end == '\0')
+            {
+                t = timegm(&tm);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool is_not_modified(beast::string_view if_none_match,
+                         beast::string_view if_modified_since,
+                         beast::string_view etag,
+                         std::time_t last_modified)
+    {
+        // 有 If-None-Match 时忽略 If-Modified-Since，采用弱比较
+        if (!if_none_match.empty())
+        {
+            auto const ours = opaque_tag(etag);
+            auto s = if_none_match;
+            while (!s.empty())
+            {
+                skip_ows(s);
+                if (!s.empty() && s.front() == '*')
+                {
+                    return true;
+                }
+
+                auto const end = s.find(',');
+                auto tag = s.substr(0, end);
+                while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t'))
+                {
+                    tag.remove_suffix(1);
+                }
+                if (opaque_tag(tag) == ours)
+                {
+                    return true;
+                }
+
+                if (end == beast::string_view::npos)
+                {
+                    break;
+                }
+                s.remove_prefix(end + 1);
+            }
+            return false;
+        }
+
+        if (!if_modified_since.empty())
+        {
+            std::time_t since;
+            return parse_http_date(if_modified_since, since) && last_modified <= since;
+        }
+        return false;
+    }
+
+    bool if_range_matches(beast::string_view if_range,
+                          beast::string_view etag,
+                          std::time_t last_modified)
+    {
+        if (if_range.empty())
+        {
+            return true;
+        }
+
+        // 实体标签采用强比较，弱标签永远不匹配
+        if (if_range.front() == '"' || if_range.front() == 'W')
+        {
+            return if_range == etag;
+        }
+
+        std::time_t date;
+        return parse_http_date(if_range, date) && date == last_modified;
+    }
+
+    range_result parse_range(beast::string_view range,
+                             std::uint64_t size,
+                             std::vector<byte_range> &ranges)
+    {
+        ranges.clear();
+
+        if (range.size() < 6 || !beast::iequals(range.substr(0, 6), "bytes="))
+        {
+            return range_result::none;
+        }
+        range.remove_prefix(6);
+
+        bool any_spec = false;
+        while (!range.empty())
+        {
+            skip_ows(range);
+            if (!range.empty() && range.front() == ',')
+            {
+                range.remove_prefix(1);
+                continue;
+            }
+            if (range.empty())
+            {
+                break;
+            }
+
+            std::uint64_t first = 0, last = 0;
+            if (range.front() == '-')
+            {
+                // 后缀范围 "-n"：最后 n 个字节
+                range.remove_prefix(1);
+                std::uint64_t suffix;
+                if (!parse_uint(range, suffix))
+                {
+                    return range_result::none;
+                }
+                any_spec = true;
+                if (suffix == 0 || size == 0)
+                {
+                    continue;
+                }
+                first = suffix < size ? size - suffix : 0;
+                last = size - 1;
+            }
+            else
+            {
+                if (!parse_uint(range, first) || range.empty() || range.front() != '-')
+                {
+                    return range_result::none;
+                }
+                range.remove_prefix(1);
+
+                last = UINT64_MAX;
+                if (!range.empty() && range.front() >= '0' && range.front() <= '9')
+                {
+                    if (!parse_uint(range, last) || last < first)
+                    {
+                        return range_result::none;
+                    }
+                }
+                any_spec = true;
+                if (first >= size)
+                {
+                    continue;
+                }
+                last = std::min(last, size - 1);
+            }
+
+            ranges.push_back({first, last});
+            if (ranges.size() > max_ranges)
+            {
+                ranges.clear();
+                return range_result::none;
+            }
+
+            skip_ows(range);
+            if (!range.empty() && range.front() != ',')
+            {
+                ranges.clear();
+                return range_result::none;
+            }
+        }
+
+        if (!any_spec)
+        {
+            return range_result::none;
+        }
+        if (ranges.empty())
+        {
+            return range_result::unsatisfiable;
+        }
+
+        // 合并重叠或相邻的范围，防止以重复范围放大响应
+        std::vector<byte_range> sorted(ranges);
+        std::sort(sorted.begin(), sorted.end(),
+                  [](byte_range const &a, byte_range const &b)
+                  { return a.first < b.first; });
+        bool overlap = false;
+        for (std::size_t i = 1; i < sorted.size(); ++i)
+        {
+            if (sorted[i].first <= sorted[i - 1].last + 1)
+            {
+                overlap = true;
+                break;
+            }
+        }
+        if (overlap)
+        {
+            ranges.clear();
+            for (auto const &r : sorted)
+            {
+                if (!ranges.empty() && r.first <= ranges.back().last + 1)
+                {
+                    ranges.back().last = std::max(ranges.back().last, r.last);
+                }
+                else
+                {
+                    ranges.push_back(r);
+                }
+            }
+        }
+        return range_result::satisfiable;
+    }
+
+    beast::string_view multipart_boundary()
+    {
+        return "3d6b6a416f9b5c2e8f1a7d4c0b9e2f58";
+    }
+
+    std::string multipart_part_header(beast::string_view content_type,
+                                      byte_range const &range,
+                                      std::uint64_t size)
+    {
+        std::string header = "\r\n--";
+        header.append(multipart_boundary().data(), multipart_boundary().size());
+        header += "\r\nContent-Type: ";
+        header.append(content_type.data(), content_type.size());
+        header += "\r\nContent-Range: bytes " + std::to_string(range.first) + "-" +
+                  std::to_string(range.last) + "/" + std::to_string(size) + "\r\n\r\n";
+        return header;
+    }
+
+    std::string multipart_trailer()
+    {
+        std::string trailer = "\r\n--";
+        trailer.append(multipart_boundary().data(), multipart_boundary().size());
+        trailer += "--\r\n";
+        return trailer;
+    }
+
+} // namespace http_server
@@ -0,0 +1,71 @@
+#ifndef CONDITIONAL_HPP
+#define CONDITIONAL_HPP
+
+#include <boost/beast/core/string.hpp>
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace beast = boost::beast;
+
+namespace http_server
+{
+    // 条件请求（ETag / Last-Modified）与范围请求（Range）的辅助函数
+
+    // 闭区间 [first, last] 的字节范围
+    struct byte_range
+    {
+        std::uint64_t first;
+        std::uint64_t last;
+
+        std::uint64_t length() const { return last - first + 1; }
+    };
+
+    enum class range_result
+    {
+        none,         // 没有 Range 或格式无法识别，按完整响应处理
+        satisfiable,  // 至少有一个范围可满足
+        unsatisfiable // 所有范围都超出文件大小，返回 416
+    };
+
+    // 由 inode、大小与修改时间生成强 ETag（包含双引号）
+    std::string make_etag(struct stat const &st);
+
+    // HTTP 日期（IMF-fixdate）格式化与解析
+    std::string format_http_date(std::time_t t);
+    bool parse_http_date(beast::string_view value, std::time_t &t);
+
+    // 根据 If-None-Match / If-Modified-Since 判断资源是否未修改（应返回 304）
+    bool is_not_modified(beast::string_view if_none_match,
+                         beast::string_view if_modified_since,
+                         beast::string_view etag,
+                         std::time_t last_modified);
+
+    // If-Range 为空或与当前版本一致时返回 true，表示 Range 仍然有效
+    bool if_range_matches(beast::string_view if_range,
+                          beast::string_view etag,
+                          std::time_t last_modified);
+
+    // 解析 "bytes=..." 形式的 Range 头，重叠的范围会被合并
+    range_result parse_range(beast::string_view range,
+                             std::uint64_t size,
+                             std::vector<byte_range> &ranges);
+
+    // multipart/byteranges 响应使用的分隔符
+    beast::string_view multipart_boundary();
+
+    // multipart/byteranges 中每一部分的头部（含前导分隔符）
+    std::string multipart_part_header(beast::string_view content_type,
+                                      byte_range const &range,
+                                      std::uint64_t size);
+
+    // multipart/byteranges 的结束分隔符
+    std::string multipart_trailer();
+
+} // namespace http_server
+
+#endif // CONDITIONAL_HPP
@@ -0,0 +1,284 @@
+#include "coro_session.hpp"
+#include "access_log.hpp"
+#include "tracing.hpp"
+
+#include <boost/asio/detached.hpp>
+#include <boost/asio/this_coro.hpp>
+
+#include <chrono>
+
+namespace http_server
+{
+    namespace
+    {
+        // 会话发出的异步操作：中间状态从会话的 handler_memory 分配，错误通过 ec 返回而不是抛出异常
+        auto session_token(handler_memory &memory, beast::error_code &ec)
+        {
+            return net::bind_allocator(handler_allocator<void>(memory),
+                                       net::redirect_error(net::use_awaitable, ec));
+        }
+
+        // 写出响应头后用 sendfile(2) 发送正文，bytes 累加写出的字节数
+        net::awaitable<void> write_file(beast::tcp_stream &stream, http::response<sendfile_body> &res,
+                                        handler_memory &memory, beast::error_code &ec, std::uint64_t &bytes)
+        {
+            auto &metrics = Metrics::getInstance();
+            http::response_serializer<sendfile_body> sr{res};
+            auto const header = co_await http::async_write(stream, sr, session_token(memory, ec));
+            metrics.add_bytes_out(header);
+            bytes += header;
+            if (ec)
+            {
+                co_return;
+            }
+
+            auto &socket = stream.socket();
+            socket.native_non_blocking(true, ec);
+            if (ec)
+            {
+                co_return;
+            }
+
+            // 超时定时器的回调可能在本函数返回后才执行，waiting 失效后不再访问 socket
+            auto waiting = std::make_shared<bool>(true);
+            net::steady_timer timer(co_await net::this_coro::executor);
+            for (;;)
+            {
+                auto const remaining = res.body().remaining;
+                bool const done = sendfile_some(socket.native_handle(), res.body(), ec);
+                metrics.add_bytes_out(remaining - res.body().remaining);
+                bytes += remaining - res.body().remaining;
+                if (done)
+                {
+                    break;
+                }
+                if (ec)
+                {
+                    co_return;
+                }
+
+                // 等待 socket 可写后继续，同时给同一 io_context 上的其他 session 让出线程。
+                // 定时器的回调在 cancel 后仍会排队执行，可能晚于会话结束，不能使用会话的 handler_memory
+                timer.expires_after(std::chrono::seconds(20));
+                timer.async_wait(
+                    [&socket, alive = std::weak_ptr<bool>(waiting)](beast::error_code ec)
+                    {
+                        if (!ec && alive.lock())
+                        {
+                            socket.cancel();
+                        }
+                    });
+                co_await socket.async_wait(tcp::socket::wait_write, session_token(memory, ec));
+                timer.cancel();
+                if (ec)
+                {
+                    co_return;
+                }
+            }
+        }
+
+        // 一个连接的完整生命周期：读请求、处理、写响应，直到连接关闭
+        net::awaitable<void> run_session(tcp::socket socket, tcp::endpoint peer,
+                                         std::shared_ptr<std::string const> doc_root)
+        {
+            beast::error_code ec;
+            // 与回调版本相同，关闭 Nagle 算法，响应写出后不等待对端的延迟 ACK
+            socket.set_option(tcp::no_delay(true), ec);
+            if (ec)
+            {
+                fail(ec, "set_option TCP_NODELAY");
+            }
+            beast::tcp_stream stream(std::move(socket));
+            beast::flat_buffer buffer;
+            handler_memory memory;
+
+            auto &metrics = Metrics::getInstance();
+            metrics.session_opened();
+            // co_accept 接受连接前已占用连接名额，会话结束时归还
+            struct session_guard
+            {
+                Metrics &metrics;
+                ~session_guard()
+                {
+                    metrics.session_closed();
+                    Admission::getInstance().close_session();
+                }
+            } guard{metrics};
+            auto &access_log = AccessLog::getInstance();
+            access_log.connection_opened(peer);
+            auto &tracer = Tracer::getInstance();
+
+            // 整个会话复用同一个 send 状态
+            coro_send send{std::make_shared<coro_send::state>(stream.get_executor())};
+            auto &state = *send.state_;
+
+            for (;;)
+            {
+                http::request<http::string_body> req;
+                auto const read_tick = tracer.enabled() ? trace_clock() : 0;
+                stream.expires_after(std::chrono::seconds(20));
+                metrics.add_bytes_in(co_await http::async_read(stream, buffer, req, session_token(memory, ec)));
+                if (ec == http::error::end_of_stream)
+                {
+                    access_log.connection_closed(peer, true);
+                    break;
+                }
+                if (ec)
+                {
+                    fail(ec, "read");
+                    co_return;
+                }
+
+                bool const keep_alive = req.keep_alive();
+                boost::optional<http::message_generator> msg;
+
+                auto const start = std::chrono::steady_clock::now();
+                auto const method = req.method();
+                auto const route = route_index(method, req.target());
+                // 请求交给处理器前复制目标，供访问日志使用
+                char target_copy[access_record::max_target];
+                auto const target_size = access_log.enabled()
+                                             ? req.target().copy(target_copy, sizeof(target_copy))
+                                             : 0;
+                std::uint64_t bytes = 0;
+
+                // 协程在 co_await 处可能换到其他线程继续，只记录读取、处理与写出三个阶段；
+                // 同步执行的 handle_request 内部的阶段照常记录
+                auto trace = tracer.start(method, std::string_view(req.target().data(), req.target().size()));
+                std::uint64_t write_tick = 0;
+                if (trace)
+                {
+                    trace->add("read", read_tick, trace->start);
+                }
+                auto const begin_write = [&]
+                {
+                    if (trace)
+                    {
+                        write_tick = trace_clock();
+                        trace->add("handle", trace->start, write_tick);
+                    }
+                };
+
+                auto const record = [&](unsigned status)
+                {
+                    auto const elapsed = std::chrono::steady_clock::now() - start;
+                    metrics.record_request(method, status, route, elapsed);
+                    access_log.request(peer, method, std::string_view(target_copy, target_size), status, bytes,
+                                       elapsed);
+                    if (trace)
+                    {
+                        trace->add("write", write_tick, trace_clock());
+                        tracer.finish(std::move(trace), status);
+                    }
+                };
+
+                admission_ticket admission;
+                if (!admission.acquire(route_class(route)))
+                {
+                    // 该类请求已达并发上限，直接返回 503
+                    auto res = overloaded(req);
+                    state.status = res.result_int();
+                    msg.emplace(std::move(res));
+                }
+                else if (method == http::verb::post)
+                {
+                    auto res = co_await co_handle_post(req);
+                    state.status = res.result_int();
+                    msg.emplace(std::move(res));
+                }
+                else
+                {
+                    state.ready = false;
+                    state.event.expires_at(net::steady_timer::time_point::max());
+                    {
+                        trace_scope scope(trace.get());
+                        handle_request(*doc_root, std::move(req), coro_send(send));
+                    }
+                    if (!state.ready)
+                    {
+                        // 响应在后台生成，完成后 send 取消等待
+                        co_await state.event.async_wait(session_token(memory, ec));
+                    }
+
+                    if (state.file)
+                    {
+                        auto res = std::move(*state.file);
+                        state.file.reset();
+                        bool const file_keep_alive = res.keep_alive();
+                        begin_write();
+                        co_await write_file(stream, res, memory, ec, bytes);
+                        if (ec)
+                        {
+                            fail(ec, "sendfile");
+                            co_return;
+                        }
+                        record(state.status);
+                        if (!file_keep_alive)
+                        {
+                            break;
+                        }
+                        continue;
+                    }
+
+                    msg = std::move(state.msg);
+                    state.msg.reset();
+                }
+
+                bool const response_keep_alive = msg->keep_alive();
+                begin_write();
+                bytes = co_await beast::async_write(stream, std::move(*msg), session_token(memory, ec));
+                metrics.add_bytes_out(bytes);
+                if (ec)
+                {
+                    fail(ec, "write");
+                    co_return;
+                }
+                record(state.status);
+
+                if (!keep_alive || !response_keep_alive)
+                {
+                    access_log.connection_closed(peer, false);
+                    break;
+                }
+            }
+
+            stream.socket().shutdown(tcp::socket::shutdown_send, ec);
+            if (ec)
+            {
+                LOG(WARNING) << "Error during connection shutdown: " << ec.message();
+            }
+        }
+    } // namespace
+
+    net::awaitable<void> listener::co_accept()
+    {
+        beast::error_code ec;
+        net::steady_timer pause_timer(acceptor_.get_executor());
+        for (;;)
+        {
+            // 连接数已达上限时暂停 accept，定时重试
+            if (!Admission::getInstance().try_open_session())
+            {
+                LOG_EVERY_N(WARNING, 100) << "Session limit reached, pausing accept";
+                pause_timer.expires_after(std::chrono::milliseconds(10));
+                co_await pause_timer.async_wait(net::redirect_error(net::use_awaitable, ec));
+                continue;
+            }
+
+            // 每线程一个 io_context 时，会话留在接受它的线程上，不需要 strand
+            auto ex = reuse_port_ ? net::any_io_executor(ioc_.get_executor())
+                                  : net::any_io_executor(net::make_strand(ioc_));
+            auto socket = co_await acceptor_.async_accept(ex, peer_, net::redirect_error(net::use_awaitable, ec));
+            if (ec)
+            {
+                fail(ec, "accept");
+                Metrics::getInstance().accept_error();
+                Admission::getInstance().close_session();
+                continue;
+            }
+
+            net::co_spawn(ex, run_session(std::move(socket), peer_, doc_root_), net::detached);
+        }
+    }
+
+} // namespace http_server
@@ -0,0 +1,98 @@
+#ifndef CORO_SESSION_HPP
+#define CORO_SESSION_HPP
+
+// C++20 协程版本的 session/listener，使用 make CORO=1 编译（定义 HTTP_SERVER_COROUTINES）。
+// 每个连接一个协程，读请求、处理、写响应都在同一个循环里顺序完成
+
+#include "handler_memory.hpp"
+#include "http_server.hpp"
+#include "metrics.hpp"
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/bind_allocator.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+namespace http_server
+{
+    // 在 ex 上执行 work()，结果在调用方的执行器上交给 token。
+    // 协程中 co_await async_run(...) 会挂起直到 work 完成，然后回到会话的执行器上继续
+    template <class Executor, class Work, class CompletionToken>
+    auto async_run(Executor ex, Work &&work, CompletionToken &&token)
+    {
+        using result_type = decltype(work());
+        return net::async_initiate<CompletionToken, void(result_type)>(
+            [ex](auto handler, auto work) mutable
+            {
+                auto guard = net::make_work_guard(handler);
+                net::post(ex,
+                          [handler = std::move(handler), work = std::move(work), guard = std::move(guard)]() mutable
+                          {
+                              auto result = work();
+                              auto handler_ex = guard.get_executor();
+                              guard.reset();
+                              net::dispatch(handler_ex,
+                                            [handler = std::move(handler), result = std::move(result)]() mutable
+                                            {
+                                                std::move(handler)(std::move(result));
+                                            });
+                          });
+            },
+            token, std::forward<Work>(work));
+    }
+
+    // 协程会话交给 handle_request 的 send。
+    // 处理器可能直接调用，也可能稍后在会话的执行器上调用（如后台压缩完成时），
+    // 协程在 event 上等待，响应就绪时取消等待唤醒协程
+    struct coro_send
+    {
+        struct state
+        {
+            explicit state(net::any_io_executor ex) : executor(ex), event(ex) {}
+
+            net::any_io_executor executor;
+            net::steady_timer event;
+            boost::optional<http::message_generator> msg;
+            boost::optional<http::response<sendfile_body>> file;
+            unsigned status{0};
+            bool ready{false};
+        };
+
+        std::shared_ptr<state> state_;
+
+        template <bool isRequest, class Body, class Fields>
+        void operator()(http::message<isRequest, Body, Fields> &&msg) const
+        {
+            if constexpr (!isRequest)
+            {
+                state_->status = msg.result_int();
+            }
+            state_->msg.emplace(std::move(msg));
+            state_->ready = true;
+            state_->event.cancel();
+        }
+
+        void operator()(http::response<sendfile_body> &&msg) const
+        {
+            state_->status = msg.result_int();
+            state_->file.emplace(std::move(msg));
+            state_->ready = true;
+            state_->event.cancel();
+        }
+
+        net::any_io_executor get_executor() const
+        {
+            return state_->executor;
+        }
+    };
+
+    // 协程版本的 POST 处理：登录与注册直接 co_await 数据库线程池和密码哈希线程池
+    net::awaitable<http::response<http::string_body>> co_handle_post(http::request<http::string_body> &req);
+
+} // namespace http_server
+
+#endif // CORO_SESSION_HPP
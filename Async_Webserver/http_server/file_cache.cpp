@@ -0,0 +1,539 @@
+#include "file_cache.hpp"
+#include "conditional.hpp"
+#include "http_server.hpp"
+
+#include <glog/logging.h>
+#include <boost/beast/version.hpp>
+#include <filesystem>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace http_server
+{
+    namespace
+    {
+        // 需要监听的 inotify 事件
+        constexpr uint32_t watch_mask =
+            IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE |
+            IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+        // 仅缓存规范化的路径，保证缓存键与 inotify 上报的路径一致
+        bool is_normalized(std::string_view path)
+        {
+            return path.find("//") == std::string_view::npos &&
+                   path.find("/./") == std::string_view::npos;
+        }
+
+        std::string strip_trailing_slash(std::string dir)
+        {
+            while (dir.size() > 1 && dir.back() == '/')
+            {
+                dir.pop_back();
+            }
+            return dir;
+        }
+    } // namespace
+
+    FileCache &FileCache::getInstance()
+    {
+        static FileCache instance;
+        return instance;
+    }
+
+    bool FileCache::initialize(const std::string &doc_root,
+                               size_t max_bytes,
+                               size_t max_file_size,
+                               size_t shard_count)
+    {
+        if (enabled())
+        {
+            LOG(WARNING) << "File cache already initialized";
+            return false;
+        }
+
+        if (shard_count == 0)
+        {
+            shard_count = 1;
+        }
+
+        doc_root_ = strip_trailing_slash(doc_root);
+        max_file_size_ = max_file_size;
+        shard_budget_ = max_bytes / shard_count;
+        shards_.clear();
+        for (size_t i = 0; i < shard_count; ++i)
+        {
+            shards_.push_back(std::make_unique<shard>());
+        }
+
+        // 没有 inotify 就无法保证缓存与磁盘一致，此时直接禁用缓存
+        inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd_ < 0)
+        {
+            PLOG(WARNING) << "inotify_init1 failed, file cache disabled";
+            return false;
+        }
+        stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (stop_fd_ < 0)
+        {
+            PLOG(WARNING) << "eventfd failed, file cache disabled";
+            ::close(inotify_fd_);
+            inotify_fd_ = -1;
+            return false;
+        }
+
+        add_watch_recursive(doc_root_);
+        if (watches_.empty())
+        {
+            LOG(WARNING) << "Unable to watch " << doc_root_ << ", file cache disabled";
+            shutdown();
+            return false;
+        }
+
+        watcher_ = std::thread([this]
+                               { watch_loop(); });
+        enabled_.store(true, std::memory_order_release);
+
+        LOG(INFO) << "File cache initialized: " << shard_count << " shards, "
+                  << max_bytes << " bytes budget, max file size " << max_file_size;
+        return true;
+    }
+
+    void FileCache::shutdown()
+    {
+        enabled_.store(false, std::memory_order_release);
+
+        if (watcher_.joinable())
+        {
+            uint64_t one = 1;
+            if (::write(stop_fd_, &one, sizeof(one)) < 0)
+            {
+                PLOG(WARNING) << "Failed to signal file cache watcher";
+            }
+            watcher_.join();
+        }
+        if (inotify_fd_ >= 0)
+        {
+            ::close(inotify_fd_);
+            inotify_fd_ = -1;
+        }
+        if (stop_fd_ >= 0)
+        {
+            ::close(stop_fd_);
+            stop_fd_ = -1;
+        }
+        watches_.clear();
+        clear();
+    }
+
+    FileCache::~FileCache()
+    {
+        shutdown();
+    }
+
+    FileCache::shard &FileCache::shard_for(std::string_view path)
+    {
+        return *shards_[std::hash<std::string_view>{}(path) % shards_.size()];
+    }
+
+    cached_file_ptr FileCache::find(std::string_view path)
+    {
+        if (!enabled())
+        {
+            return nullptr;
+        }
+
+        auto &s = shard_for(path);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        auto it = s.index.find(path);
+        if (it == s.index.end())
+        {
+            return nullptr;
+        }
+
+        // 移到 LRU 表头
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        return *it->second;
+    }
+
+    void init_variant(cached_file &variant, cached_file const &base, content_coding coding)
+    {
+        auto const name = coding == content_coding::br ? "br" : "gzip";
+
+        variant.path = variant_key(base.path, coding);
+        variant.coding = coding;
+        variant.mtime = base.mtime;
+        variant.mime = base.mime;
+
+        // 不同编码是不同的表示，ETag 必须不同
+        variant.etag = base.etag;
+        variant.etag.insert(variant.etag.size() - 1, coding == content_coding::br ? "-br" : "-gz");
+
+        variant.headers = base.headers;
+        variant.headers.set(http::field::content_encoding, name);
+        variant.headers.set(http::field::etag, variant.etag);
+    }
+
+    bool FileCache::read_file(const std::string &path, cached_file &file, struct stat &st, beast::error_code &ec)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            ec.assign(errno, beast::generic_category());
+            return false;
+        }
+
+        if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+            static_cast<size_t>(st.st_size) > max_file_size_ ||
+            static_cast<size_t>(st.st_size) > shard_budget_)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        bool const ok = read_fd(fd, static_cast<size_t>(st.st_size), file, ec);
+        ::close(fd);
+        return ok;
+    }
+
+    bool FileCache::read_fd(int fd, size_t size, cached_file &file, beast::error_code &ec)
+    {
+        file.content.resize(size);
+
+        size_t offset = 0;
+        while (offset < file.content.size())
+        {
+            ssize_t n = ::read(fd, &file.content[offset], file.content.size() - offset);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n < 0)
+            {
+                ec.assign(errno, beast::generic_category());
+                return false;
+            }
+            if (n == 0)
+            {
+                break; // 文件在读取过程中被截断
+            }
+            offset += static_cast<size_t>(n);
+        }
+        file.content.resize(offset);
+        return true;
+    }
+
+    cached_file_ptr FileCache::load(const std::string &path, bool fill, opened_file &opened, beast::error_code &ec)
+    {
+        ec = {};
+        fill = fill && enabled() && is_normalized(path);
+
+        // 先取分片的代数再打开文件，打开之后发生的失效都能被发现
+        shard *s = fill ? &shard_for(path) : nullptr;
+        uint64_t generation = 0;
+        if (s)
+        {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            generation = s->generation;
+        }
+
+        opened.file.open(path.c_str(), beast::file_mode::scan, ec);
+        if (ec)
+        {
+            return nullptr;
+        }
+        auto &st = opened.st;
+        if (::fstat(opened.file.native_handle(), &st) != 0)
+        {
+            ec.assign(errno, beast::generic_category());
+            return nullptr;
+        }
+        if (!fill || !S_ISREG(st.st_mode) ||
+            static_cast<size_t>(st.st_size) > max_file_size_ ||
+            static_cast<size_t>(st.st_size) > shard_budget_)
+        {
+            return nullptr;
+        }
+
+        auto file = std::make_shared<cached_file>();
+        if (!read_fd(opened.file.native_handle(), static_cast<size_t>(st.st_size), *file, ec))
+        {
+            return nullptr;
+        }
+        file->path = path;
+        file->mtime = st.st_mtim;
+        file->etag = make_etag(st);
+
+        file->mime = &MimeTypes::getInstance().lookup(path);
+        if (file->mime->compressible)
+        {
+            struct stat sibling;
+            file->has_gzip_sibling = ::stat((path + ".gz").c_str(), &sibling) == 0 && S_ISREG(sibling.st_mode);
+            file->has_br_sibling = ::stat((path + ".br").c_str(), &sibling) == 0 && S_ISREG(sibling.st_mode);
+        }
+
+        file->headers.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        file->headers.set(http::field::content_type, file->mime->content_type);
+        file->headers.set(http::field::etag, file->etag);
+        file->headers.set(http::field::last_modified, format_http_date(st.st_mtim.tv_sec));
+        file->headers.set(http::field::cache_control, cache_control());
+        file->headers.set(http::field::accept_ranges, "bytes");
+        if (file->mime->compressible)
+        {
+            file->headers.set(http::field::vary, "Accept-Encoding");
+        }
+        file->headers.set(http::field::content_length, std::to_string(file->content.size()));
+
+        cached_file_ptr entry = std::move(file);
+
+        std::lock_guard<std::mutex> lock(s->mutex);
+        if (s->generation != generation || !enabled())
+        {
+            // 读取期间文件发生变化，本次结果仅用于当前请求
+            return entry;
+        }
+        insert(*s, entry);
+        return entry;
+    }
+
+    cached_file_ptr FileCache::load_sibling(cached_file const &base, content_coding coding, beast::error_code &ec)
+    {
+        ec = {};
+        if (!enabled())
+        {
+            return nullptr;
+        }
+
+        auto key = variant_key(base.path, coding);
+        auto &s = shard_for(key);
+        uint64_t generation;
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            generation = s.generation;
+        }
+
+        auto file = std::make_shared<cached_file>();
+        struct stat st;
+        if (!read_file(base.path + (coding == content_coding::br ? ".br" : ".gz"), *file, st, ec))
+        {
+            return nullptr;
+        }
+        init_variant(*file, base, coding);
+
+        // 预压缩文件可能单独重新生成，ETag 取自它自身的 stat
+        file->etag = make_etag(st);
+        file->etag.insert(file->etag.size() - 1, coding == content_coding::br ? "-br" : "-gz");
+        file->headers.set(http::field::etag, file->etag);
+        file->headers.set(http::field::content_length, std::to_string(file->content.size()));
+
+        cached_file_ptr entry = std::move(file);
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.generation != generation || !enabled())
+        {
+            return entry;
+        }
+        insert(s, entry);
+        return entry;
+    }
+
+    void FileCache::insert(cached_file_ptr entry)
+    {
+        if (!enabled())
+        {
+            return;
+        }
+
+        auto &s = shard_for(entry->path);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        insert(s, std::move(entry));
+    }
+
+    void FileCache::insert(shard &s, cached_file_ptr entry)
+    {
+        if (entry->content.size() + entry->path.size() > shard_budget_)
+        {
+            return;
+        }
+
+        auto it = s.index.find(entry->path);
+        if (it != s.index.end())
+        {
+            erase(s, it->second);
+        }
+
+        s.lru.push_front(std::move(entry));
+        s.index.emplace(s.lru.front()->path, s.lru.begin());
+        s.bytes += s.lru.front()->content.size() + s.lru.front()->path.size();
+        evict(s);
+    }
+
+    void FileCache::evict(shard &s)
+    {
+        while (s.bytes > shard_budget_ && !s.lru.empty())
+        {
+            erase(s, std::prev(s.lru.end()));
+        }
+    }
+
+    void FileCache::erase(shard &s, std::list<cached_file_ptr>::iterator it)
+    {
+        s.bytes -= (*it)->content.size() + (*it)->path.size();
+        s.index.erase((*it)->path);
+        s.lru.erase(it);
+    }
+
+    void FileCache::invalidate(std::string_view path)
+    {
+        if (shards_.empty())
+        {
+            return;
+        }
+
+        auto &s = shard_for(path);
+        std::lock_guard<std::mutex> lock(s.mutex);
+        ++s.generation;
+        auto it = s.index.find(path);
+        if (it != s.index.end())
+        {
+            erase(s, it->second);
+        }
+    }
+
+    void FileCache::clear()
+    {
+        for (auto &s : shards_)
+        {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            ++s->generation;
+            s->index.clear();
+            s->lru.clear();
+            s->bytes = 0;
+        }
+    }
+
+    void FileCache::add_watch_recursive(const std::string &dir)
+    {
+        int wd = ::inotify_add_watch(inotify_fd_, dir.c_str(), watch_mask);
+        if (wd < 0)
+        {
+            PLOG(WARNING) << "inotify_add_watch failed for " << dir;
+            return;
+        }
+        watches_[wd] = dir;
+
+        std::error_code ec;
+        for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+        {
+            if (it->is_directory(ec) && !it->is_symlink(ec))
+            {
+                add_watch_recursive(dir + "/" + it->path().filename().string());
+            }
+        }
+    }
+
+    void FileCache::watch_loop()
+    {
+        alignas(struct inotify_event) char buf[64 * 1024];
+
+        for (;;)
+        {
+            pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {stop_fd_, POLLIN, 0}};
+            if (::poll(fds, 2, -1) < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                PLOG(ERROR) << "File cache watcher poll failed, disabling cache";
+                enabled_.store(false, std::memory_order_release);
+                clear();
+                return;
+            }
+            if (fds[1].revents & POLLIN)
+            {
+                return;
+            }
+
+            ssize_t len = ::read(inotify_fd_, buf, sizeof(buf));
+            if (len <= 0)
+            {
+                continue;
+            }
+
+            for (char *p = buf; p < buf + len;)
+            {
+                auto const *ev = reinterpret_cast<struct inotify_event const *>(p);
+                p += sizeof(struct inotify_event) + ev->len;
+
+                if (ev->mask & IN_Q_OVERFLOW)
+                {
+                    // 事件丢失，无法确定哪些文件变化，只能整体清空
+                    LOG(WARNING) << "inotify queue overflow, clearing file cache";
+                    clear();
+                    continue;
+                }
+                if (ev->mask & IN_IGNORED)
+                {
+                    watches_.erase(ev->wd);
+                    continue;
+                }
+
+                auto dir = watches_.find(ev->wd);
+                if (dir == watches_.end())
+                {
+                    continue;
+                }
+
+                if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+                {
+                    clear();
+                    continue;
+                }
+                if (ev->len == 0)
+                {
+                    continue;
+                }
+
+                std::string path = dir->second + "/" + ev->name;
+                if (ev->mask & IN_ISDIR)
+                {
+                    if (ev->mask & (IN_CREATE | IN_MOVED_TO))
+                    {
+                        add_watch_recursive(path);
+                    }
+                    if (ev->mask & (IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO))
+                    {
+                        // 目录整体移动或删除，其下条目较难逐一定位，直接清空
+                        clear();
+                    }
+                    continue;
+                }
+
+                invalidate_file(path);
+            }
+        }
+    }
+
+    void FileCache::invalidate_file(const std::string &path)
+    {
+        // 原文件变化时其压缩版本一并失效
+        invalidate(path);
+        invalidate(variant_key(path, content_coding::gzip));
+        invalidate(variant_key(path, content_coding::br));
+
+        // 预压缩文件增删改时，原文件条目中记录的兄弟文件信息也随之失效
+        for (std::string_view suffix : {".gz", ".br"})
+        {
+            if (path.size() > suffix.size() &&
+                path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0)
+            {
+                invalidate_file(path.substr(0, path.size() - suffix.size()));
+            }
+        }
+    }
+
+} // namespace http_server
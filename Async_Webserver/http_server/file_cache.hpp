@@ -0,0 +1,205 @@
+#ifndef FILE_CACHE_HPP
+#define FILE_CACHE_HPP
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
+
+#include <ctime>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "mime_types.hpp"
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+
+namespace http_server
+{
+    // 内容编码（Content-Encoding）
+    enum class content_coding
+    {
+        identity,
+        gzip,
+        br
+    };
+
+    // 缓存条目：文件内容及预先生成的响应头，创建后不可变，可被多个请求共享
+    struct cached_file
+    {
+        std::string path;    // 缓存键：原文件为完整路径，压缩版本为 variant_key
+        std::string content; // 文件内容（压缩版本为压缩后的数据）
+        http::fields headers; // 预生成的响应头（Server、Content-Type、Content-Length 等）
+
+        content_coding coding{content_coding::identity}; // 压缩版本的编码，identity 表示压缩无收益
+        struct timespec mtime{};      // 源文件修改时间，压缩版本据此判断是否过期
+        std::string etag;             // 强 ETag，压缩版本带编码后缀
+        mime_type_info const *mime{nullptr}; // 解析好的类型、字符集与是否值得压缩，指向 MimeTypes 的表项
+        bool has_gzip_sibling{false}; // 是否存在预压缩的 .gz 文件
+        bool has_br_sibling{false};   // 是否存在预压缩的 .br 文件
+    };
+
+    using cached_file_ptr = std::shared_ptr<cached_file const>;
+
+    // 压缩版本的缓存键：路径 + '\0' + 编码名，不会与真实路径冲突。
+    // 处理请求时以请求的分配器构造，查找压缩版本不访问全局堆
+    template <class Allocator = std::allocator<char>>
+    std::basic_string<char, std::char_traits<char>, Allocator>
+    variant_key(std::string_view path, content_coding coding, Allocator const &alloc = Allocator())
+    {
+        std::basic_string<char, std::char_traits<char>, Allocator> key(alloc);
+        key.reserve(path.size() + 5);
+        key.append(path.data(), path.size());
+        key.push_back('\0');
+        key.append(coding == content_coding::br ? "br" : "gzip");
+        return key;
+    }
+
+    // 以原文件条目初始化其压缩版本的键、校验信息和响应头（Content-Length 除外）
+    void init_variant(cached_file &variant, cached_file const &base, content_coding coding);
+
+    // 直接引用缓存条目内容的响应体，写出时不复制数据
+    struct cached_body
+    {
+        struct value_type
+        {
+            cached_file_ptr file;  // 保持条目存活
+            std::string_view data; // 要发送的内容，范围请求时为内容的一段
+
+            value_type() = default;
+
+            value_type(cached_file_ptr f)
+                : file(std::move(f)), data(file ? std::string_view(file->content) : std::string_view())
+            {
+            }
+
+            value_type(cached_file_ptr f, std::uint64_t offset, std::uint64_t length)
+                : file(std::move(f)), data(std::string_view(file->content).substr(offset, length))
+            {
+            }
+        };
+
+        static std::uint64_t size(value_type const &body)
+        {
+            return body.data.size();
+        }
+
+        class writer
+        {
+            value_type const &body_;
+
+        public:
+            using const_buffers_type = net::const_buffer;
+
+            template <bool isRequest, class Fields>
+            writer(http::header<isRequest, Fields> const &, value_type const &body)
+                : body_(body)
+            {
+            }
+
+            void init(beast::error_code &ec)
+            {
+                ec = {};
+            }
+
+            boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code &ec)
+            {
+                ec = {};
+                return {{net::const_buffer(body_.data.data(), body_.data.size()), false}};
+            }
+        };
+    };
+
+    // FileCache::load 打开的文件，未进入缓存时交给调用方继续使用
+    struct opened_file
+    {
+        beast::file file;
+        struct stat st{};
+    };
+
+    // 静态文件缓存：按路径哈希分片，每个分片独立加锁并按 LRU 淘汰，
+    // 通过 inotify 监听 doc_root 目录树，文件变化时使对应条目失效
+    class FileCache
+    {
+    public:
+        static FileCache &getInstance();
+
+        // 初始化缓存并启动 inotify 监听线程
+        bool initialize(const std::string &doc_root,
+                        size_t max_bytes,
+                        size_t max_file_size,
+                        size_t shard_count);
+
+        // 停止监听线程并清空缓存
+        void shutdown();
+
+        bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+        // 查找缓存条目，未命中返回 nullptr，不产生任何文件系统调用
+        cached_file_ptr find(std::string_view path);
+
+        // 打开 path 并 fstat，文件与 stat 结果留在 opened 中。文件可缓存且 fill 为 true 时读入并放入缓存，
+        // 返回缓存条目；否则（不可缓存、缓存未启用或 HEAD 请求不需要内容）返回 nullptr 且 ec 为空，
+        // 调用方直接用 opened 响应，不再重复 open/stat。打开或 fstat 失败时设置 ec
+        cached_file_ptr load(const std::string &path, bool fill, opened_file &opened, beast::error_code &ec);
+
+        // 读取预压缩的兄弟文件（如 index.html.br），以 variant_key 存为 base 的压缩版本
+        cached_file_ptr load_sibling(cached_file const &base, content_coding coding, beast::error_code &ec);
+
+        // 放入一个已构造好的条目（用于后台压缩结果）
+        void insert(cached_file_ptr entry);
+
+        void invalidate(std::string_view path);
+        void clear();
+
+    private:
+        FileCache() = default;
+        ~FileCache();
+
+        struct shard
+        {
+            std::mutex mutex;
+            std::list<cached_file_ptr> lru; // 表头为最近使用
+            std::unordered_map<std::string_view, std::list<cached_file_ptr>::iterator> index;
+            size_t bytes{0};
+            uint64_t generation{0}; // 每次失效递增，用于丢弃与失效并发的加载结果
+        };
+
+        shard &shard_for(std::string_view path);
+        void evict(shard &s);
+        void erase(shard &s, std::list<cached_file_ptr>::iterator it);
+        void insert(shard &s, cached_file_ptr entry);
+        bool read_file(const std::string &path, cached_file &file, struct stat &st, beast::error_code &ec);
+        static bool read_fd(int fd, size_t size, cached_file &file, beast::error_code &ec);
+        void invalidate_file(const std::string &path);
+
+        // inotify 监听
+        void watch_loop();
+        void add_watch_recursive(const std::string &dir);
+
+        std::vector<std::unique_ptr<shard>> shards_;
+        size_t shard_budget_{0};   // 每个分片的字节预算
+        size_t max_file_size_{0};  // 可缓存的最大文件大小
+        std::string doc_root_;
+        std::atomic<bool> enabled_{false};
+
+        int inotify_fd_{-1};
+        int stop_fd_{-1}; // eventfd，用于唤醒并停止监听线程
+        std::unordered_map<int, std::string> watches_; // wd -> 目录路径，仅监听线程访问
+        std::thread watcher_;
+    };
+
+} // namespace http_server
+
+#endif // FILE_CACHE_HPP
@@ -0,0 +1,579 @@
+#include "form_parser.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace http_server
+{
+    namespace
+    {
+        // 十六进制字符的值，非十六进制字符为 -1
+        constexpr std::array<std::int8_t, 256> make_hex_table()
+        {
+            std::array<std::int8_t, 256> table{};
+            for (int c = 0; c < 256; ++c)
+            {
+                table[c] = c >= '0' && c <= '9'   ? static_cast<std::int8_t>(c - '0')
+                           : c >= 'a' && c <= 'f' ? static_cast<std::int8_t>(c - 'a' + 10)
+                           : c >= 'A' && c <= 'F' ? static_cast<std::int8_t>(c - 'A' + 10)
+                                                  : static_cast<std::int8_t>(-1);
+            }
+            return table;
+        }
+
+        constexpr auto hex_table = make_hex_table();
+
+        // urlencoded 中需要处理的字符：分隔符与转义
+        constexpr std::array<bool, 256> make_special_table()
+        {
+            std::array<bool, 256> table{};
+            table['&'] = table['='] = table['%'] = table['+'] = true;
+            return table;
+        }
+
+        constexpr auto special_table = make_special_table();
+
+        int hex_value(char c)
+        {
+            return hex_table[static_cast<unsigned char>(c)];
+        }
+
+        // 返回 [p, end) 中第一个 '&'、'='、'%' 或 '+' 的位置，没有时返回 end。
+        // 普通字符连续很长（如大段的值）时按 16 字节一组比较
+        char *find_special(char *p, char *end)
+        {
+#ifdef __SSE2__
+            __m128i const amp = _mm_set1_epi8('&');
+            __m128i const eq = _mm_set1_epi8('=');
+            __m128i const pct = _mm_set1_epi8('%');
+            __m128i const plus = _mm_set1_epi8('+');
+            while (end - p >= 16)
+            {
+                __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+                __m128i const hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, eq)),
+                                                 _mm_or_si128(_mm_cmpeq_epi8(v, pct), _mm_cmpeq_epi8(v, plus)));
+                int const mask = _mm_movemask_epi8(hit);
+                if (mask != 0)
+                {
+                    return p + __builtin_ctz(static_cast<unsigned>(mask));
+                }
+                p += 16;
+            }
+#endif
+            while (p < end && !special_table[static_cast<unsigned char>(*p)])
+            {
+                ++p;
+            }
+            return p;
+        }
+
+        // 解码 r 处的 %XX 写到 w，返回读取的字节数；转义不完整时原样复制 '%'
+        std::size_t decode_escape(char *r, char *end, char *&w)
+        {
+            if (end - r >= 3)
+            {
+                int const hi = hex_value(r[1]);
+                int const lo = hex_value(r[2]);
+                if (hi >= 0 && lo >= 0)
+                {
+                    *w++ = static_cast<char>(hi << 4 | lo);
+                    return 3;
+                }
+            }
+            *w++ = '%';
+            return 1;
+        }
+
+        char lower(char c)
+        {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        bool iequals(std::string_view a, std::string_view b)
+        {
+            if (a.size() != b.size())
+            {
+                return false;
+            }
+            for (std::size_t i = 0; i < a.size(); ++i)
+            {
+                if (lower(a[i]) != lower(b[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::string_view trim(std::string_view s)
+        {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+            {
+                s.remove_prefix(1);
+            }
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+            {
+                s.remove_suffix(1);
+            }
+            return s;
+        }
+
+        // 在 "key=value; key=value" 形式的参数列表中查找参数（名称不区分大小写，值去掉引号）
+        std::optional<std::string_view> find_param(std::string_view params, std::string_view key)
+        {
+            while (!params.empty())
+            {
+                auto const semi = params.find(';');
+                auto const item = trim(params.substr(0, semi));
+                auto const eq = item.find('=');
+                if (eq != std::string_view::npos && iequals(trim(item.substr(0, eq)), key))
+                {
+                    auto value = trim(item.substr(eq + 1));
+                    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+                    {
+                        value = value.substr(1, value.size() - 2);
+                    }
+                    return value;
+                }
+                if (semi == std::string_view::npos)
+                {
+                    break;
+                }
+                params.remove_prefix(semi + 1);
+            }
+            return std::nullopt;
+        }
+
+        // 查找位于行首的 "--boundary"，返回 "--" 的位置
+        std::size_t find_delimiter(std::string_view body, std::string_view boundary, std::size_t from)
+        {
+            while (true)
+            {
+                auto const pos = body.find("--", from);
+                if (pos == std::string_view::npos)
+                {
+                    return pos;
+                }
+                bool const line_start = pos == 0 || (pos >= 2 && body[pos - 2] == '\r' && body[pos - 1] == '\n');
+                if (line_start && body.substr(pos + 2, boundary.size()) == boundary)
+                {
+                    return pos;
+                }
+                from = pos + 1;
+            }
+        }
+
+        void skip_ws(char *&p, char *end)
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            {
+                ++p;
+            }
+        }
+
+        // 以 UTF-8 写出码点
+        void put_utf8(std::uint32_t cp, char *&w)
+        {
+            if (cp < 0x80)
+            {
+                *w++ = static_cast<char>(cp);
+            }
+            else if (cp < 0x800)
+            {
+                *w++ = static_cast<char>(0xc0 | cp >> 6);
+                *w++ = static_cast<char>(0x80 | (cp & 0x3f));
+            }
+            else if (cp < 0x10000)
+            {
+                *w++ = static_cast<char>(0xe0 | cp >> 12);
+                *w++ = static_cast<char>(0x80 | (cp >> 6 & 0x3f));
+                *w++ = static_cast<char>(0x80 | (cp & 0x3f));
+            }
+            else
+            {
+                *w++ = static_cast<char>(0xf0 | cp >> 18);
+                *w++ = static_cast<char>(0x80 | (cp >> 12 & 0x3f));
+                *w++ = static_cast<char>(0x80 | (cp >> 6 & 0x3f));
+                *w++ = static_cast<char>(0x80 | (cp & 0x3f));
+            }
+        }
+
+        bool read_hex4(char const *p, char const *end, std::uint32_t &value)
+        {
+            if (end - p < 4)
+            {
+                return false;
+            }
+            value = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                int const v = hex_value(p[i]);
+                if (v < 0)
+                {
+                    return false;
+                }
+                value = value << 4 | static_cast<std::uint32_t>(v);
+            }
+            return true;
+        }
+
+        // 解析 p 处（指向开头的引号）的 JSON 字符串并就地解码，p 移到结尾引号之后
+        bool parse_json_string(char *&p, char *end, std::string_view &out)
+        {
+            char *r = p + 1;
+            char *w = r;
+            char *const begin = r;
+            while (r < end)
+            {
+                char const c = *r;
+                if (c == '"')
+                {
+                    out = std::string_view(begin, static_cast<std::size_t>(w - begin));
+                    p = r + 1;
+                    return true;
+                }
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    return false;
+                }
+                if (c != '\\')
+                {
+                    *w++ = *r++;
+                    continue;
+                }
+
+                if (end - r < 2)
+                {
+                    return false;
+                }
+                switch (r[1])
+                {
+                case '"':
+                case '\\':
+                case '/':
+                    *w++ = r[1];
+                    break;
+                case 'b':
+                    *w++ = '\b';
+                    break;
+                case 'f':
+                    *w++ = '\f';
+                    break;
+                case 'n':
+                    *w++ = '\n';
+                    break;
+                case 'r':
+                    *w++ = '\r';
+                    break;
+                case 't':
+                    *w++ = '\t';
+                    break;
+                case 'u':
+                {
+                    std::uint32_t cp;
+                    if (!read_hex4(r + 2, end, cp))
+                    {
+                        return false;
+                    }
+                    r += 6;
+                    if (cp >= 0xd800 && cp < 0xdc00)
+                    {
+                        // 代理对：高位之后必须紧跟低位
+                        std::uint32_t low;
+                        if (end - r < 6 || r[0] != '\\' || r[1] != 'u' || !read_hex4(r + 2, end, low) ||
+                            low < 0xdc00 || low >= 0xe000)
+                        {
+                            return false;
+                        }
+                        cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                        r += 6;
+                    }
+                    else if (cp >= 0xdc00 && cp < 0xe000)
+                    {
+                        return false;
+                    }
+                    put_utf8(cp, w);
+                    continue;
+                }
+                default:
+                    return false;
+                }
+                r += 2;
+            }
+            return false;
+        }
+    } // namespace
+
+    std::size_t percent_decode(char *data, std::size_t size)
+    {
+        char *r = data;
+        char *const end = data + size;
+        char *w = data;
+        while (r < end)
+        {
+            if (*r == '%')
+            {
+                r += decode_escape(r, end, w);
+            }
+            else
+            {
+                *w++ = *r == '+' ? ' ' : *r;
+                ++r;
+            }
+        }
+        return static_cast<std::size_t>(w - data);
+    }
+
+    bool parse_urlencoded(char *data, std::size_t size, form_data &out)
+    {
+        char *r = data;
+        char *const end = data + size;
+        char *w = data; // 解码结果写到 w，w 不会超过 r
+
+        char *name = w;
+        char *value = nullptr; // 遇到 '=' 之前为空
+        bool ok = true;
+
+        while (true)
+        {
+            // 普通字符成段复制；还没有遇到转义时 w == r，无需移动
+            char *const next = find_special(r, end);
+            if (w != r)
+            {
+                std::memmove(w, r, static_cast<std::size_t>(next - r));
+            }
+            w += next - r;
+            r = next;
+
+            if (r == end || *r == '&')
+            {
+                if (value)
+                {
+                    ok = out.add(std::string_view(name, static_cast<std::size_t>(value - name)),
+                                 std::string_view(value, static_cast<std::size_t>(w - value))) &&
+                         ok;
+                }
+                if (r == end)
+                {
+                    return ok;
+                }
+                ++r;
+                name = w;
+                value = nullptr;
+                continue;
+            }
+
+            switch (*r)
+            {
+            case '=':
+                // 名称与值相邻存放：'=' 本身不写出
+                if (!value)
+                {
+                    value = w;
+                }
+                else
+                {
+                    *w++ = '=';
+                }
+                ++r;
+                break;
+            case '+':
+                *w++ = ' ';
+                ++r;
+                break;
+            default: // '%'
+                r += decode_escape(r, end, w);
+                break;
+            }
+        }
+    }
+
+    bool parse_multipart(std::string_view boundary, char *data, std::size_t size, form_data &out)
+    {
+        if (boundary.empty())
+        {
+            return false;
+        }
+
+        std::string_view const body(data, size);
+        auto pos = find_delimiter(body, boundary, 0);
+        if (pos == std::string_view::npos)
+        {
+            return false;
+        }
+
+        while (true)
+        {
+            pos += 2 + boundary.size();
+            if (body.substr(pos, 2) == "--")
+            {
+                return true; // 结束分隔符
+            }
+            if (body.substr(pos, 2) != "\r\n")
+            {
+                return false;
+            }
+            pos += 2;
+
+            auto const headers_end = body.find("\r\n\r\n", pos);
+            if (headers_end == std::string_view::npos)
+            {
+                return false;
+            }
+
+            // 部分的头部：只关心 Content-Disposition 的 name
+            std::optional<std::string_view> name;
+            auto headers = body.substr(pos, headers_end - pos);
+            while (!headers.empty())
+            {
+                auto const eol = headers.find("\r\n");
+                auto const line = headers.substr(0, eol);
+                auto const colon = line.find(':');
+                if (colon != std::string_view::npos && iequals(trim(line.substr(0, colon)), "content-disposition"))
+                {
+                    name = find_param(line.substr(colon + 1), "name");
+                }
+                if (eol == std::string_view::npos)
+                {
+                    break;
+                }
+                headers.remove_prefix(eol + 2);
+            }
+
+            auto const content = headers_end + 4;
+            auto const next = find_delimiter(body, boundary, content);
+            if (next == std::string_view::npos || next < content + 2)
+            {
+                return false;
+            }
+
+            // 内容与下一个分隔符之间的 CRLF 属于分隔符
+            if (name && !out.add(*name, body.substr(content, next - 2 - content)))
+            {
+                return false;
+            }
+            pos = next;
+        }
+    }
+
+    bool parse_json(char *data, std::size_t size, form_data &out)
+    {
+        char *p = data;
+        char *const end = data + size;
+
+        skip_ws(p, end);
+        if (p == end || *p != '{')
+        {
+            return false;
+        }
+        ++p;
+
+        skip_ws(p, end);
+        if (p < end && *p == '}')
+        {
+            ++p;
+            skip_ws(p, end);
+            return p == end;
+        }
+
+        while (true)
+        {
+            skip_ws(p, end);
+            std::string_view name;
+            if (p == end || *p != '"' || !parse_json_string(p, end, name))
+            {
+                return false;
+            }
+
+            skip_ws(p, end);
+            if (p == end || *p != ':')
+            {
+                return false;
+            }
+            ++p;
+            skip_ws(p, end);
+            if (p == end)
+            {
+                return false;
+            }
+
+            std::string_view value;
+            if (*p == '"')
+            {
+                if (!parse_json_string(p, end, value))
+                {
+                    return false;
+                }
+            }
+            else if (*p == '{' || *p == '[')
+            {
+                return false;
+            }
+            else
+            {
+                // 数字与字面量按原文作为值
+                char *const begin = p;
+                while (p < end && *p != ',' && *p != '}' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+                {
+                    ++p;
+                }
+                value = std::string_view(begin, static_cast<std::size_t>(p - begin));
+                if (value.empty())
+                {
+                    return false;
+                }
+            }
+
+            if (!out.add(name, value))
+            {
+                return false;
+            }
+
+            skip_ws(p, end);
+            if (p == end)
+            {
+                return false;
+            }
+            if (*p == '}')
+            {
+                ++p;
+                skip_ws(p, end);
+                return p == end;
+            }
+            if (*p != ',')
+            {
+                return false;
+            }
+            ++p;
+        }
+    }
+
+    std::string_view form_boundary(std::string_view content_type)
+    {
+        auto const semi = content_type.find(';');
+        if (semi == std::string_view::npos)
+        {
+            return {};
+        }
+        return find_param(content_type.substr(semi + 1), "boundary").value_or(std::string_view{});
+    }
+
+    bool parse_form(std::string_view content_type, char *data, std::size_t size, form_data &out)
+    {
+        auto const media_type = trim(content_type.substr(0, content_type.find(';')));
+        if (iequals(media_type, "multipart/form-data"))
+        {
+            return parse_multipart(form_boundary(content_type), data, size, out);
+        }
+        if (iequals(media_type, "application/json"))
+        {
+            return parse_json(data, size, out);
+        }
+        return parse_urlencoded(data, size, out);
+    }
+
+} // namespace http_server
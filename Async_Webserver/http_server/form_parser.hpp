@@ -0,0 +1,84 @@
+#ifndef FORM_PARSER_HPP
+#define FORM_PARSER_HPP
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace http_server
+{
+    // POST 请求体解析：单趟扫描，字段以 string_view 指向请求体本身，
+    // 转义就地解码（解码结果不长于原文），解析过程不分配内存
+
+    struct form_field
+    {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    // 解析结果，容量固定
+    class form_data
+    {
+    public:
+        static constexpr std::size_t max_fields = 32;
+
+        // 第一个同名字段的值
+        std::optional<std::string_view> get(std::string_view name) const
+        {
+            for (std::size_t i = 0; i < size_; ++i)
+            {
+                if (fields_[i].name == name)
+                {
+                    return fields_[i].value;
+                }
+            }
+            return std::nullopt;
+        }
+
+        // 字段已满时返回 false
+        bool add(std::string_view name, std::string_view value)
+        {
+            if (size_ == max_fields)
+            {
+                return false;
+            }
+            fields_[size_++] = {name, value};
+            return true;
+        }
+
+        void clear() { size_ = 0; }
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        form_field const *begin() const { return fields_.data(); }
+        form_field const *end() const { return fields_.data() + size_; }
+
+    private:
+        std::array<form_field, max_fields> fields_{};
+        std::size_t size_{0};
+    };
+
+    // 就地解码 %XX 与 '+'（空格），返回解码后的长度；不完整或非法的 % 转义原样保留
+    std::size_t percent_decode(char *data, std::size_t size);
+
+    // application/x-www-form-urlencoded：name=value&name=value，名称与值都会解码。
+    // 没有 '=' 的片段被忽略；字段超过容量时返回 false
+    bool parse_urlencoded(char *data, std::size_t size, form_data &out);
+
+    // multipart/form-data：按 Content-Disposition 的 name 参数取字段，内容不做解码
+    bool parse_multipart(std::string_view boundary, char *data, std::size_t size, form_data &out);
+
+    // 平坦的 JSON 对象：值为字符串、数字、true/false/null，字符串转义就地解码；
+    // 嵌套的对象或数组视为格式错误
+    bool parse_json(char *data, std::size_t size, form_data &out);
+
+    // 取 Content-Type 中的 boundary 参数，没有时返回空
+    std::string_view form_boundary(std::string_view content_type);
+
+    // 按 Content-Type 选择解析方式，其他类型按 urlencoded 处理。格式错误时返回 false
+    bool parse_form(std::string_view content_type, char *data, std::size_t size, form_data &out);
+
+} // namespace http_server
+
+#endif // FORM_PARSER_HPP
@@ -0,0 +1,97 @@
+#ifndef HANDLER_MEMORY_HPP
+#define HANDLER_MEMORY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace http_server
+{
+    // 会话的 handler 内存：异步操作的中间状态复用几块固定内存，稳定运行时不再分配堆内存。
+    // 协程版本的协程帧本身由 Asio 的线程局部缓存回收。
+    // 释放可能发生在其他 I/O 线程，占用标记是原子的，用 exchange 领取，不会有两个操作拿到同一块
+    class handler_memory
+    {
+    public:
+        handler_memory() = default;
+        handler_memory(handler_memory const &) = delete;
+        handler_memory &operator=(handler_memory const &) = delete;
+
+        void *allocate(std::size_t size)
+        {
+            if (size <= block_size)
+            {
+                for (auto &b : blocks_)
+                {
+                    if (!b.in_use.exchange(true, std::memory_order_acquire))
+                    {
+                        return b.storage;
+                    }
+                }
+            }
+            return ::operator new(size);
+        }
+
+        void deallocate(void *p)
+        {
+            for (auto &b : blocks_)
+            {
+                if (p == b.storage)
+                {
+                    b.in_use.store(false, std::memory_order_release);
+                    return;
+                }
+            }
+            ::operator delete(p);
+        }
+
+    private:
+        static constexpr std::size_t block_size = 1024;
+
+        struct block
+        {
+            alignas(std::max_align_t) unsigned char storage[block_size];
+            std::atomic<bool> in_use{false};
+        };
+
+        // 协程版本：读、写与 sendfile 等待（sendfile 的超时定时器不使用这里的内存）；
+        // 回调版本：写、sendfile 等待、两个定时器，以及完成回调经 strand 排队时的中间状态
+        block blocks_[4];
+    };
+
+    template <class T>
+    class handler_allocator
+    {
+    public:
+        using value_type = T;
+
+        explicit handler_allocator(handler_memory &memory) : memory_(&memory) {}
+
+        template <class U>
+        handler_allocator(handler_allocator<U> const &other) noexcept : memory_(other.memory_)
+        {
+        }
+
+        T *allocate(std::size_t n)
+        {
+            return static_cast<T *>(memory_->allocate(sizeof(T) * n));
+        }
+
+        void deallocate(T *p, std::size_t)
+        {
+            memory_->deallocate(p);
+        }
+
+        bool operator==(handler_allocator const &other) const noexcept { return memory_ == other.memory_; }
+        bool operator!=(handler_allocator const &other) const noexcept { return memory_ != other.memory_; }
+
+    private:
+        template <class>
+        friend class handler_allocator;
+
+        handler_memory *memory_;
+    };
+
+} // namespace http_server
+
+#endif // HANDLER_MEMORY_HPP
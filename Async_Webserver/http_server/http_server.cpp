@@ -1,20 +1,45 @@
 #include "http_server.hpp"
+#include "access_log.hpp"
+#include "admission.hpp"
+#include "tracing.hpp"
+#include "file_cache.hpp"
+#include "compressor.hpp"
+#include "conditional.hpp"
+#include "form_parser.hpp"
+#include "metrics.hpp"
+#include "mime_types.hpp"
+#include "router.hpp"
 #include "../database/db_pool.hpp"
+#include "../database/db_executor.hpp"
+#include "../database/user_cache.hpp"
+#include "../auth/password_hasher.hpp"
+#ifdef HTTP_SERVER_COROUTINES
+#include "coro_session.hpp"
+#include <boost/asio/detached.hpp>
+#endif
+#ifdef HTTP_SERVER_CAPTURE_SEND
+#include "../benchmarks/capture_send.hpp"
+#endif
 
 #include <boost/beast/core/string.hpp>
-#include <boost/algorithm/string.hpp>
-#include <sstream>
-#include <map>
 #include <mysql_connection.h>
 #include <cppconn/driver.h>
 #include <cppconn/exception.h>
 #include <cppconn/resultset.h>
 #include <cppconn/statement.h>
 #include <cppconn/prepared_statement.h>
+#include <boost/asio/bind_allocator.hpp>
+#include <boost/asio/bind_cancellation_slot.hpp>
 #include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/strand.hpp>
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <iostream>
 #include <string>
 #include <thread>
@@ -22,447 +47,1690 @@
 
 namespace http_server
 {
-    // 转换文件扩展名为 MIME 类型
-    beast::string_view mime_type(beast::string_view path)
+    // 缓存条目的内容一次即可全部取出，可以与后续响应合并写出
+    template <>
+    struct is_single_buffer_body<cached_body> : std::true_type
     {
-        using beast::iequals;
-        auto const ext = [&path]
+    };
+
+    namespace
+    {
+        std::uint64_t sendfile_threshold = 0; // 见 set_sendfile_threshold
+        std::string cache_control_value = "public, max-age=0, must-revalidate";
+
+        // 范围请求无法使用 sendfile 时，最多读入内存的字节数
+        constexpr std::uint64_t max_range_buffer = 16 * 1024 * 1024;
+
+        // 每次 sendfile 调用发送的最大字节数，发送完一块后让出 I/O 线程
+        constexpr std::size_t sendfile_chunk = 1024 * 1024;
+
+        // 连接数达到上限时暂停 accept，每隔这么久检查一次是否有连接关闭
+        constexpr auto accept_pause = std::chrono::milliseconds(10);
+    } // namespace
+
+    void set_sendfile_threshold(std::uint64_t bytes)
+    {
+        sendfile_threshold = bytes;
+    }
+
+    void set_cache_control(std::string value)
+    {
+        cache_control_value = std::move(value);
+    }
+
+    beast::string_view cache_control()
+    {
+        return cache_control_value;
+    }
+
+    // 将路径连接到基础路径
+    std::string path_cat(beast::string_view base, beast::string_view path)
+    {
+        return path_cat(base, path, std::allocator<char>());
+    }
+
+    // 空的字符串响应，响应头与响应体使用请求的分配器
+    template <class Body, class Allocator>
+    string_response<Allocator> make_string_response(http::request<Body, http::basic_fields<Allocator>> &req, http::status status)
+    {
+        auto const alloc = req.get_allocator();
+        string_response<Allocator> res{status, req.version(), alloc, alloc};
+        res.keep_alive(req.keep_alive());
+        return res;
+    }
+
+    template <class Body, class Allocator>
+    string_response<Allocator> bad_request(http::request<Body, http::basic_fields<Allocator>> &req, beast::string_view why)
+    {
+        LOG(WARNING) << "Bad request: " << why;
+        auto res = make_string_response(req, http::status::bad_request);
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "text/html");
+        res.body().assign(why.data(), why.size());
+        res.prepare_payload();
+        return res;
+    }
+
+    template <class Body, class Allocator>
+    string_response<Allocator> not_found(http::request<Body, http::basic_fields<Allocator>> &req, beast::string_view target)
+    {
+        LOG(WARNING) << "Resource not found: " << target;
+        auto res = make_string_response(req, http::status::not_found);
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "text/html");
+        res.body().append("The resource '").append(target.data(), target.size()).append("' was not found.");
+        res.prepare_payload();
+        return res;
+    }
+
+    template <class Body, class Allocator>
+    string_response<Allocator> server_error(http::request<Body, http::basic_fields<Allocator>> &req, beast::string_view what)
+    {
+        LOG(ERROR) << "Server error: " << what;
+        auto res = make_string_response(req, http::status::internal_server_error);
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "text/html");
+        res.body().append("An error occurred: '").append(what.data(), what.size()).append("'");
+        res.prepare_payload();
+        return res;
+    }
+
+    template <class Body, class Allocator>
+    string_response<Allocator> overloaded(http::request<Body, http::basic_fields<Allocator>> &req)
+    {
+        auto res = make_string_response(req, http::status::service_unavailable);
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "text/html");
+        res.set(http::field::retry_after, Admission::getInstance().retry_after());
+        res.body().assign("Service temporarily unavailable");
+        res.prepare_payload();
+        return res;
+    }
+
+    // 请求目标的路径部分（去掉查询参数），用于路由匹配
+    std::string_view target_path(beast::string_view target)
+    {
+        auto const path = target.substr(0, target.find('?'));
+        return std::string_view(path.data(), path.size());
+    }
+
+    // 处理请求目标，解决根路径和查询参数问题；返回值引用 target，不复制
+    beast::string_view process_target(beast::string_view target)
+    {
+        // 如果有查询参数，只取路径部分
+        auto const path = target.substr(0, target.find('?'));
+        // 如果是根路径，返回index.html
+        if (path == "/")
+        {
+            return "/index.html";
+        }
+        return path;
+    }
+
+    // 从静态文件缓存获取文件，未命中时打开文件，fill 为 true 时读入缓存；
+    // 返回 nullptr 且 ec 为空时，opened 中是已打开的文件及其 stat
+    cached_file_ptr find_cached(std::string_view path, bool fill, opened_file &opened, beast::error_code &ec)
+    {
+        auto &cache = FileCache::getInstance();
+        if (auto file = cache.find(path))
+        {
+            return file;
+        }
+        return cache.load(std::string(path), fill, opened, ec);
+    }
+
+    // 按 Accept-Encoding 选择要返回的版本：已缓存的压缩结果、预压缩文件或原文件。
+    // 需要现场压缩时提交后台任务，本次先返回原文件
+    template <class Allocator>
+    cached_file_ptr select_variant(cached_file_ptr const &file, beast::string_view accept_encoding, bool compress_on_miss,
+                                   Allocator const &alloc)
+    {
+        if (!file->mime->compressible || accept_encoding.empty())
+        {
+            return file;
+        }
+
+        auto const coding = negotiate_encoding(accept_encoding);
+        if (coding == content_coding::identity)
+        {
+            return file;
+        }
+
+        auto &cache = FileCache::getInstance();
+        auto variant = cache.find(variant_key(file->path, coding, alloc));
+        if (variant && variant->mtime.tv_sec == file->mtime.tv_sec &&
+            variant->mtime.tv_nsec == file->mtime.tv_nsec)
+        {
+            return variant->coding == content_coding::identity ? file : variant;
+        }
+
+        bool const has_sibling = coding == content_coding::br ? file->has_br_sibling : file->has_gzip_sibling;
+        if (has_sibling)
+        {
+            beast::error_code ec;
+            auto sibling = cache.load_sibling(*file, coding, ec);
+            return sibling ? sibling : file;
+        }
+
+        auto &compressor = Compressor::getInstance();
+        if (compress_on_miss && compressor.enabled() && compressor.should_compress(*file))
+        {
+            compressor.submit(file, coding);
+        }
+        return file;
+    }
+
+    // 以请求的分配器复制预生成的响应头
+    template <class Allocator>
+    http::basic_fields<Allocator> response_fields(http::fields const &headers, Allocator const &alloc)
+    {
+        return http::basic_fields<Allocator>(headers, alloc);
+    }
+
+    // 304 Not Modified：沿用 200 响应中的校验头和缓存头，不带正文
+    template <class Body, class Allocator>
+    response_for<http::empty_body, Allocator> not_modified(http::request<Body, http::basic_fields<Allocator>> &req, http::fields const &headers)
+    {
+        response_for<http::empty_body, Allocator> res{http::status::not_modified, req.version(), http::empty_body::value_type{},
+                                                      response_fields(headers, req.get_allocator())};
+        res.erase(http::field::content_length);
+        res.erase(http::field::content_type);
+        res.keep_alive(req.keep_alive());
+        return res;
+    }
+
+    template <class Body, class Allocator>
+    string_response<Allocator> range_not_satisfiable(http::request<Body, http::basic_fields<Allocator>> &req, std::uint64_t size)
+    {
+        auto res = make_string_response(req, http::status::range_not_satisfiable);
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_range, "bytes */" + std::to_string(size));
+        res.prepare_payload();
+        return res;
+    }
+
+    std::string content_range(byte_range const &range, std::uint64_t size)
+    {
+        return "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" + std::to_string(size);
+    }
+
+    // 解析请求中的 Range；仅对 GET 生效，If-Range 不匹配时忽略
+    template <class Body, class Allocator>
+    range_result request_ranges(http::request<Body, http::basic_fields<Allocator>> &req,
+                                beast::string_view etag, std::time_t last_modified,
+                                std::uint64_t size, std::vector<byte_range> &ranges)
+    {
+        auto const range = req[http::field::range];
+        if (req.method() != http::verb::get || range.empty() ||
+            !if_range_matches(req[http::field::if_range], etag, last_modified))
+        {
+            return range_result::none;
+        }
+        return parse_range(range, size, ranges);
+    }
+
+    // 从文件读取一个范围追加到 out
+    bool read_range(beast::file &file, byte_range const &range, std::string &out, beast::error_code &ec)
+    {
+        file.seek(range.first, ec);
+        if (ec)
+        {
+            return false;
+        }
+
+        auto const offset = out.size();
+        out.resize(offset + range.length());
+        std::size_t done = 0;
+        while (done < range.length())
+        {
+            auto n = file.read(&out[offset + done], range.length() - done, ec);
+            if (ec)
+            {
+                return false;
+            }
+            if (n == 0)
+            {
+                ec = beast::error_code(beast::errc::io_error, beast::generic_category());
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+    // 用缓存条目响应 GET/HEAD，处理条件请求与范围请求，全程不访问文件系统
+    template <class Body, class Allocator, class Send>
+    void send_cached(http::request<Body, http::basic_fields<Allocator>> &req, cached_file_ptr const &file, Send &&send)
+    {
+        if (is_not_modified(req[http::field::if_none_match], req[http::field::if_modified_since],
+                            file->etag, file->mtime.tv_sec))
+        {
+            return send(not_modified(req, file->headers));
+        }
+
+        if (req.method() == http::verb::head)
+        {
+            response_for<http::empty_body, Allocator> res{http::status::ok, req.version(), http::empty_body::value_type{},
+                                                          response_fields(file->headers, req.get_allocator())};
+            res.keep_alive(req.keep_alive());
+            return send(std::move(res));
+        }
+
+        auto const size = file->content.size();
+        std::vector<byte_range> ranges;
+        auto const result = request_ranges(req, file->etag, file->mtime.tv_sec, size, ranges);
+
+        if (result == range_result::unsatisfiable)
+        {
+            return send(range_not_satisfiable(req, size));
+        }
+
+        if (result == range_result::satisfiable && ranges.size() == 1)
+        {
+            auto const &range = ranges.front();
+            response_for<cached_body, Allocator> res{http::status::partial_content, req.version(),
+                                                     cached_body::value_type{file, range.first, range.length()},
+                                                     response_fields(file->headers, req.get_allocator())};
+            res.set(http::field::content_range, content_range(range, size));
+            res.content_length(range.length());
+            res.keep_alive(req.keep_alive());
+            return send(std::move(res));
+        }
+
+        if (result == range_result::satisfiable)
+        {
+            auto const type = file->headers[http::field::content_type];
+            std::string body;
+            for (auto const &range : ranges)
+            {
+                body += multipart_part_header(type, range, size);
+                body.append(file->content, range.first, range.length());
+            }
+            body += multipart_trailer();
+
+            http::response<http::string_body> res{http::status::partial_content, req.version(), std::move(body), file->headers};
+            res.set(http::field::content_type, "multipart/byteranges; boundary=" + std::string(multipart_boundary()));
+            res.content_length(res.body().size());
+            res.keep_alive(req.keep_alive());
+            return send(std::move(res));
+        }
+
+        // 缓存命中：响应体直接引用共享的缓存内容
+        response_for<cached_body, Allocator> res{http::status::ok, req.version(), file,
+                                                 response_fields(file->headers, req.get_allocator())};
+        res.keep_alive(req.keep_alive());
+        return send(std::move(res));
+    }
+
+    // 响应未进入缓存的文件（过大、缓存未启用或 HEAD 请求），使用 FileCache::load 已打开的文件与 stat
+    template <class Body, class Allocator, class Send>
+    void send_uncached(http::request<Body, http::basic_fields<Allocator>> &req, std::string const &path,
+                       opened_file &opened, Send &&send)
+    {
+        auto const &st = opened.st;
+        if (!S_ISREG(st.st_mode))
+        {
+            return send(not_found(req, req.target()));
+        }
+
+        auto const size = static_cast<std::uint64_t>(st.st_size);
+        auto const etag = make_etag(st);
+
+        http::fields headers;
+        headers.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        headers.set(http::field::content_type, MimeTypes::getInstance().lookup(path).content_type);
+        headers.set(http::field::etag, etag);
+        headers.set(http::field::last_modified, format_http_date(st.st_mtim.tv_sec));
+        headers.set(http::field::cache_control, cache_control());
+        headers.set(http::field::accept_ranges, "bytes");
+
+        // 条件请求在读取内容之前判断。此时文件已由 FileCache::load 打开：缓存未命中只做一次 open+fstat，
+        // 而不是先 stat 判断校验器再 open+fstat，代价是未缓存文件的 304 响应也多一次 open/close
+        if (is_not_modified(req[http::field::if_none_match], req[http::field::if_modified_since],
+                            etag, st.st_mtim.tv_sec))
+        {
+            return send(not_modified(req, headers));
+        }
+
+        if (req.method() == http::verb::head)
+        {
+            http::response<http::empty_body> res{http::status::ok, req.version(), http::empty_body::value_type{}, std::move(headers)};
+            res.content_length(size);
+            res.keep_alive(req.keep_alive());
+            return send(std::move(res));
+        }
+
+        std::vector<byte_range> ranges;
+        auto result = request_ranges(req, etag, st.st_mtim.tv_sec, size, ranges);
+        if (result == range_result::unsatisfiable)
+        {
+            return send(range_not_satisfiable(req, size));
+        }
+
+        beast::error_code ec;
+        auto &file = opened.file;
+
+        if (result == range_result::satisfiable && ranges.size() == 1 && sendfile_threshold != 0)
+        {
+            auto const &range = ranges.front();
+            http::response<sendfile_body> res{http::status::partial_content, req.version(),
+                                              sendfile_body::value_type{std::move(file), range.first, range.length()},
+                                              std::move(headers)};
+            res.set(http::field::content_range, content_range(range, size));
+            res.content_length(range.length());
+            res.keep_alive(req.keep_alive());
+            return send(std::move(res));
+        }
+
+        if (result == range_result::satisfiable)
         {
-            auto const pos = path.rfind(".");
-            if (pos == beast::string_view::npos)
+            std::uint64_t total = 0;
+            for (auto const &range : ranges)
             {
-                return beast::string_view{};
+                total += range.length();
+            }
+
+            // 需要读入内存的范围过大时忽略 Range，返回完整内容
+            if (total <= max_range_buffer)
+            {
+                std::string body;
+                bool const multipart = ranges.size() > 1;
+                auto const type = headers[http::field::content_type];
+                for (auto const &range : ranges)
+                {
+                    if (multipart)
+                    {
+                        body += multipart_part_header(type, range, size);
+                    }
+                    if (!read_range(file, range, body, ec))
+                    {
+                        return send(server_error(req, ec.message()));
+                    }
+                }
+
+                http::response<http::string_body> res{http::status::partial_content, req.version(), std::move(body), std::move(headers)};
+                if (multipart)
+                {
+                    res.body() += multipart_trailer();
+                    res.set(http::field::content_type, "multipart/byteranges; boundary=" + std::string(multipart_boundary()));
+                }
+                else
+                {
+                    res.set(http::field::content_range, content_range(ranges.front(), size));
+                }
+                res.content_length(res.body().size());
+                res.keep_alive(req.keep_alive());
+                return send(std::move(res));
             }
-            return path.substr(pos);
+        }
+
+        // 大文件交给内核通过 sendfile(2) 发送
+        if (sendfile_threshold != 0 && size >= sendfile_threshold)
+        {
+            http::response<sendfile_body> res{http::status::ok, req.version(),
+                                              sendfile_body::value_type{std::move(file), 0, size},
+                                              std::move(headers)};
+            res.content_length(size);
+            res.keep_alive(req.keep_alive());
+            return send(std::move(res));
+        }
+
+        http::file_body::value_type body;
+        body.reset(std::move(file), ec);
+        if (ec)
+        {
+            return send(server_error(req, ec.message()));
+        }
+
+        http::response<http::file_body> res{http::status::ok, req.version(), std::move(body), std::move(headers)};
+        res.content_length(size);
+        res.keep_alive(req.keep_alive());
+        return send(std::move(res));
+    }
+
+    // GET 与 HEAD 共用的静态文件处理
+    template <class Body, class Allocator, class Send>
+    void serve_static(beast::string_view doc_root, http::request<Body, http::basic_fields<Allocator>> &req, Send &&send)
+    {
+        auto const path = path_cat(doc_root, process_target(req.target()), req.get_allocator());
+        auto const path_view = std::string_view(path.data(), path.size());
+
+        // HEAD 不需要内容，未命中时不读入缓存，只用 fstat 的结果生成响应头
+        beast::error_code ec;
+        opened_file opened;
+        if (auto file = find_cached(path_view, req.method() == http::verb::get, opened, ec))
+        {
+            // 范围请求始终基于原文件，避免对压缩内容分段
+            if (req[http::field::range].empty())
+            {
+                file = select_variant(file, req[http::field::accept_encoding], req.method() == http::verb::get,
+                                      req.get_allocator());
+            }
+            return send_cached(req, file, std::forward<Send>(send));
+        }
+        if (ec == beast::errc::no_such_file_or_directory || ec == beast::errc::not_a_directory)
+        {
+            return send(not_found(req, req.target()));
+        }
+        if (ec)
+        {
+            return send(server_error(req, ec.message()));
+        }
+
+        return send_uncached(req, std::string(path_view), opened, std::forward<Send>(send));
+    }
+
+    template <class Body, class Allocator, class Send>
+    void handle_get(beast::string_view doc_root, http::request<Body, http::basic_fields<Allocator>> &req, Send &&send)
+    {
+        // LOG(INFO) << "Processing GET request for: " << req.target();
+        serve_static(doc_root, req, std::forward<Send>(send));
+    }
+
+    template <class Body, class Allocator, class Send>
+    void handle_head(beast::string_view doc_root, http::request<Body, http::basic_fields<Allocator>> &req, Send &&send)
+    {
+        // LOG(INFO) << "Processing HEAD request for: " << req.target();
+        serve_static(doc_root, req, std::forward<Send>(send));
+    }
+
+    // 解析 POST 请求体，字段指向请求体本身（转义就地解码）。格式错误时按没有字段处理
+    template <class Body, class Fields>
+    form_data parse_body(http::request<Body, Fields> &req)
+    {
+        trace_phase phase("parse_body");
+        form_data form;
+        auto const type = req[http::field::content_type];
+        auto &body = req.body();
+        if (!parse_form(std::string_view(type.data(), type.size()), body.data(), body.size(), form))
+        {
+            form.clear();
+        }
+        return form;
+    }
+
+    // 用户相关的 SQL，作为各连接预处理语句缓存的键
+    const std::string SQL_FIND_USER = "SELECT password, phone FROM users WHERE username = ?";
+    const std::string SQL_UPGRADE_PASSWORD = "UPDATE users SET password = ? WHERE username = ? AND password = ?";
+
+    bool findUserCached(const std::string &username, std::optional<db::UserRecord> &user)
+    {
+        trace_phase phase("user_cache");
+        db::UserRecord record;
+        switch (db::UserCache::getInstance().find(username, record))
+        {
+        case db::UserCache::lookup_result::found:
+            user = std::move(record);
+            return true;
+        case db::UserCache::lookup_result::not_found:
+            user.reset();
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    std::optional<db::UserRecord> findUser(const std::string &username)
+    {
+        // 其他请求可能已在排队期间把记录放入缓存
+        std::optional<db::UserRecord> user;
+        if (findUserCached(username, user))
+        {
+            return user;
+        }
+
+        auto &pool = db::ConnectionPool::getInstance();
+        auto conn = [&pool]
+        {
+            trace_phase phase("db_acquire");
+            return pool.getConnection();
+        }();
+        if (!conn)
+        {
+            LOG(ERROR) << "Failed to get database connection for user validation";
+            return std::nullopt;
+        }
+
+        trace_phase phase("db_query");
+        try
+        {
+            // 按用户名查询记录并放入缓存。查询前记下分片的版本，
+            // 并发注册在查询之后放入的记录不会被这次的空结果覆盖
+            auto const generation = db::UserCache::getInstance().generation(username);
+            auto *stmt = conn->prepare(SQL_FIND_USER);
+            stmt->setString(1, username);
+
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+            if (!res->next())
+            {
+                db::UserCache::getInstance().putMissing(username, generation);
+                return std::nullopt;
+            }
+
+            user = db::UserRecord{username, res->getString("password"), res->getString("phone")};
+            db::UserCache::getInstance().put(*user);
+            return user;
+        }
+        catch (const sql::SQLException &e)
+        {
+            LOG(ERROR) << "SQL Error validating user: " << e.what()
+                       << " (MySQL error code: " << e.getErrorCode()
+                       << ", SQLState: " << e.getSQLState() << ")";
+            conn->checkError(e);
+            return std::nullopt;
+        }
+    }
+
+    // 把明文或旧参数的密码替换为当前参数的哈希，在数据库线程池中执行，不影响本次登录
+    void upgradePasswordHash(db::UserRecord user, std::string hash)
+    {
+        net::post(db::Executor::getInstance().get_executor(),
+                  [user = std::move(user), hash = std::move(hash)]() mutable
+                  {
+                      auto conn = db::ConnectionPool::getInstance().getConnection();
+                      if (!conn)
+                      {
+                          return;
+                      }
+
+                      try
+                      {
+                          // 条件中带上旧值，避免覆盖并发修改过的密码
+                          auto *stmt = conn->prepare(SQL_UPGRADE_PASSWORD);
+                          stmt->setString(1, hash);
+                          stmt->setString(2, user.username);
+                          stmt->setString(3, user.password);
+                          if (stmt->executeUpdate() > 0)
+                          {
+                              user.password = std::move(hash);
+                              db::UserCache::getInstance().put(std::move(user));
+                          }
+                      }
+                      catch (const sql::SQLException &e)
+                      {
+                          LOG(ERROR) << "SQL Error upgrading password hash: " << e.what()
+                                     << " (MySQL error code: " << e.getErrorCode() << ")";
+                          conn->checkError(e);
+                      }
+                  });
+    }
+
+    bool validateUser(const db::UserRecord &user, const std::string &password)
+    {
+        auto &hasher = auth::PasswordHasher::getInstance();
+        bool needs_rehash = false;
+        {
+            trace_phase phase("password_verify");
+            if (!hasher.verify(password, user.password, needs_rehash))
+            {
+                return false;
+            }
+        }
+
+        if (needs_rehash)
+        {
+            trace_phase phase("password_rehash");
+            upgradePasswordHash(user, hasher.hash(password));
+        }
+        return true;
+    }
+
+    db::RegisterResult registerUser(const std::string &username, const std::string &password, const std::string &phone)
+    {
+        auto &pool = db::ConnectionPool::getInstance();
+        auto conn = [&pool]
+        {
+            trace_phase phase("db_acquire");
+            return pool.getConnection();
         }();
+        if (!conn)
+        {
+            LOG(ERROR) << "Failed to get database connection for user registration";
+            return db::RegisterResult::failed;
+        }
+
+        // 单条 INSERT，用户名或手机号冲突由唯一约束报告；password 已是哈希
+        trace_phase phase("db_insert");
+        return db::insertUser(*conn, {username, password, phone});
+    }
+
+    // 303 重定向响应
+    http::response<http::string_body> redirect(beast::string_view location, unsigned version, bool keep_alive)
+    {
+        http::response<http::string_body> res{http::status::see_other, version};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::location, location);
+        res.keep_alive(keep_alive);
+        res.prepare_payload();
+        return res;
+    }
+
+    // 注册结果对应的重定向，冲突的字段通过 error 参数告诉页面
+    http::response<http::string_body> registration_redirect(db::RegisterResult result, unsigned version, bool keep_alive)
+    {
+        switch (result)
+        {
+        case db::RegisterResult::ok:
+            return redirect("/?success=registration", version, keep_alive);
+        case db::RegisterResult::username_taken:
+            return redirect("/?error=username_taken", version, keep_alive);
+        case db::RegisterResult::phone_taken:
+            return redirect("/?error=phone_taken", version, keep_alive);
+        default:
+            return redirect("/?error=registration_failed", version, keep_alive);
+        }
+    }
+
+    // 503 响应，Retry-After 提示客户端稍后重试
+    http::response<http::string_body> service_unavailable(unsigned version, bool keep_alive)
+    {
+        http::response<http::string_body> res{http::status::service_unavailable, version};
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "text/html");
+        res.set(http::field::retry_after, Admission::getInstance().retry_after());
+        res.keep_alive(keep_alive);
+        res.body() = "Service temporarily unavailable";
+        res.prepare_payload();
+        return res;
+    }
+
+    // 在 send 所属的 strand 上发送响应，供后台线程完成请求时使用
+    template <class Send, class Response>
+    void send_on_strand(Send &&send, Response &&res)
+    {
+        auto ex = send.get_executor();
+        net::post(ex,
+                  [send = std::forward<Send>(send), res = std::forward<Response>(res),
+                   handoff = trace_handoff("strand_queue")]() mutable
+                  {
+                      auto const scope = handoff.resume();
+                      send(std::move(res));
+                  });
+    }
+
+    // 在数据库线程池中执行 work，完成后回到 session 的 strand 上，用 done(result) 生成响应并发送
+    template <class Send, class Work, class Done>
+    void post_db_work(Send &&send, Work &&work, Done &&done)
+    {
+        net::post(db::Executor::getInstance().get_executor(),
+                  [send = std::forward<Send>(send),
+                   work = std::forward<Work>(work),
+                   done = std::forward<Done>(done),
+                   handoff = trace_handoff("db_queue"), sample = db_latency_sample()]() mutable
+                  {
+                      auto const scope = handoff.resume();
+                      auto result = work();
+                      sample.done();
+                      send_on_strand(std::move(send), done(std::move(result)));
+                  });
+    }
+
+    // 占用密码哈希线程池的排队名额，队列已满时返回 false
+    bool reserve_hash_slot()
+    {
+        if (!auth::PasswordHasher::getInstance().tryReserve())
+        {
+            LOG(WARNING) << "Password hasher overloaded, rejecting request";
+            return false;
+        }
+        return true;
+    }
+
+    // 在密码哈希线程池中执行 work(send)，由 work 负责发送响应；队列已满时返回 503
+    template <class Send, class Work>
+    void post_hash_work(Send &&send, Work &&work, unsigned version, bool keep_alive)
+    {
+        if (!reserve_hash_slot())
+        {
+            return send_on_strand(std::forward<Send>(send), service_unavailable(version, keep_alive));
+        }
+
+        auth::PasswordHasher::getInstance().post([send = std::forward<Send>(send), work = std::forward<Work>(work),
+                                                  handoff = trace_handoff("hash_queue")]() mutable
+                    {
+                        auto const scope = handoff.resume();
+                        work(std::move(send));
+                    });
+    }
+
+    // 在哈希线程池中校验密码，完成后回到 session 的 strand 上发送登录结果
+    template <class Send>
+    void verify_login(Send &&send, db::UserRecord user, std::string password, unsigned version, bool keep_alive)
+    {
+        post_hash_work(
+            std::forward<Send>(send),
+            [user = std::move(user), password = std::move(password), version, keep_alive](auto &&send)
+            {
+                bool valid = false;
+                try
+                {
+                    valid = validateUser(user, password);
+                }
+                catch (const std::exception &e)
+                {
+                    LOG(ERROR) << "Error validating user: " << e.what();
+                }
+                send_on_strand(std::move(send),
+                               redirect(valid ? "/welcome.html" : "/?error=login_failed", version, keep_alive));
+            },
+            version, keep_alive);
+    }
+
+    // 写入已哈希密码的用户：批量模式下交给批处理器，否则在数据库线程池中单条插入
+    template <class Send>
+    void submit_registration(Send &&send, db::UserRecord user, unsigned version, bool keep_alive)
+    {
+        auto &batcher = db::RegistrationBatcher::getInstance();
+        if (batcher.enabled())
+        {
+            return batcher.submit(
+                std::move(user),
+                [send = std::forward<Send>(send), version, keep_alive,
+                 handoff = trace_handoff("registration_batch"),
+                 sample = db_latency_sample()](db::RegisterResult result) mutable
+                {
+                    auto const scope = handoff.resume();
+                    sample.done();
+                    send_on_strand(std::move(send), registration_redirect(result, version, keep_alive));
+                });
+        }
+
+        post_db_work(
+            std::forward<Send>(send),
+            [user = std::move(user)]
+            {
+                return registerUser(user.username, user.password, user.phone);
+            },
+            [version, keep_alive](db::RegisterResult result)
+            {
+                return registration_redirect(result, version, keep_alive);
+            });
+    }
+
+    // POST /login：数据库操作在 DB 线程池中执行
+    template <class Body, class Allocator, class Send>
+    void handle_login(http::request<Body, http::basic_fields<Allocator>> &req, Send &&send)
+    {
+        auto const form = parse_body(req);   // 解析表单数据
+        auto const version = req.version();
+        auto const keep_alive = req.keep_alive();
+
+        auto const username_field = form.get("username");
+        auto const password_field = form.get("password");
+
+        if (username_field && password_field)
+        {
+            // 后续在其他线程中使用，复制出请求体
+            auto username = std::string(*username_field);
+            auto password = std::string(*password_field);
+
+            // 缓存命中时不占用数据库线程和连接，直接转到哈希线程池校验
+            std::optional<db::UserRecord> user;
+            if (findUserCached(username, user))
+            {
+                if (!user)
+                {
+                    return send(redirect("/?error=login_failed", version, keep_alive));
+                }
+                return verify_login(std::forward<Send>(send), std::move(*user), std::move(password),
+                                    version, keep_alive);
+            }
+
+            // 先在数据库线程池中按用户名查询记录，再转到哈希线程池校验
+            return net::post(
+                db::Executor::getInstance().get_executor(),
+                [send = std::forward<Send>(send), username = std::move(username),
+                 password = std::move(password), version, keep_alive,
+                 handoff = trace_handoff("db_queue"), sample = db_latency_sample()]() mutable
+                {
+                    auto const scope = handoff.resume();
+                    auto user = findUser(username);
+                    sample.done();
+                    if (!user)
+                    {
+                        return send_on_strand(std::move(send),
+                                              redirect("/?error=login_failed", version, keep_alive));
+                    }
+                    verify_login(std::move(send), std::move(*user), std::move(password), version, keep_alive);
+                });
+        }
+        // Login failed
+        return send(redirect("/?error=login_failed", version, keep_alive));
+    }
+
+    // POST /register
+    template <class Body, class Allocator, class Send>
+    void handle_register(http::request<Body, http::basic_fields<Allocator>> &req, Send &&send)
+    {
+        auto const form = parse_body(req);
+        auto const version = req.version();
+        auto const keep_alive = req.keep_alive();
+
+        auto const username_field = form.get("username");
+        auto const password_field = form.get("password");
+        auto const phone_field = form.get("phone");
+
+        if (username_field && password_field && phone_field)
+        {
+            db::UserRecord user{std::string(*username_field),
+                                std::string(*password_field),
+                                std::string(*phone_field)};
+
+            // 先在哈希线程池中计算密码哈希，再写入数据库
+            return post_hash_work(
+                std::forward<Send>(send),
+                [user = std::move(user), version, keep_alive](auto &&send) mutable
+                {
+                    try
+                    {
+                        trace_phase phase("password_hash");
+                        user.password = auth::PasswordHasher::getInstance().hash(user.password);
+                    }
+                    catch (const std::exception &e)
+                    {
+                        LOG(ERROR) << "Error hashing password: " << e.what();
+                        return send_on_strand(std::move(send),
+                                              registration_redirect(db::RegisterResult::failed, version, keep_alive));
+                    }
+                    submit_registration(std::move(send), std::move(user), version, keep_alive);
+                },
+                version, keep_alive);
+        }
+        // Registration failed
+        return send(redirect("/?error=registration_failed", version, keep_alive));
+    }
+
+    // 除静态文件外的路由，处理器以 (params, req, send) 调用
+    constexpr auto routes = make_router(
+        route{http::verb::post, "/login",
+              [](route_params const &, auto &req, auto &&send)
+              { handle_login(req, std::forward<decltype(send)>(send)); }},
+        route{http::verb::post, "/register",
+              [](route_params const &, auto &req, auto &&send)
+              { handle_register(req, std::forward<decltype(send)>(send)); }},
+        route{http::verb::get, "/metrics",
+              [](route_params const &, auto &req, auto &&send)
+              { handle_metrics(req, std::forward<decltype(send)>(send)); }});
+
+    // 路由表之外的两个统计分组：静态文件与其他（未知端点或方法）
+    constexpr std::size_t static_route = routes.route_count;
+    constexpr std::size_t other_route = routes.route_count + 1;
+
+    std::size_t route_index(http::verb method, beast::string_view target)
+    {
+        route_params params;
+        if (auto const matched = routes.match(method, target_path(target), params))
+        {
+            return *matched;
+        }
+        return method == http::verb::get || method == http::verb::head ? static_route : other_route;
+    }
+
+    // POST 路由（登录、注册）需要数据库与密码哈希线程池，其余请求在 I/O 线程上即可完成
+    request_class route_class(std::size_t route)
+    {
+        return route < routes.route_count && routes.method(route) == http::verb::post ? request_class::database
+                                                                                      : request_class::light;
+    }
+
+    // 各路由序号对应的 route 标签
+    std::vector<std::string_view> route_names()
+    {
+        std::vector<std::string_view> names;
+        for (std::size_t i = 0; i < routes.route_count; ++i)
+        {
+            names.push_back(routes.pattern(i));
+        }
+        names.push_back("static");
+        names.push_back("other");
+        return names;
+    }
+
+    template <class Body, class Allocator, class Send>
+    void handle_metrics(http::request<Body, http::basic_fields<Allocator>> &req, Send &&send)
+    {
+        auto const body = Metrics::getInstance().scrape(route_names());
+
+        auto res = make_string_response(req, http::status::ok);
+        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        res.set(http::field::content_type, "text/plain; version=0.0.4; charset=utf-8");
+        res.set(http::field::cache_control, "no-store");
+        res.body().assign(body.data(), body.size());
+        res.prepare_payload();
+        send(std::move(res));
+    }
+
+#ifdef HTTP_SERVER_COROUTINES
+    // 在哈希线程池中执行 work()，调用前须已通过 reserve_hash_slot 占用名额；work 抛出异常时返回空
+    template <class Work>
+    net::awaitable<std::optional<decltype(std::declval<Work>()())>> co_hash_work(Work work)
+    {
+        auto &hasher = auth::PasswordHasher::getInstance();
+        co_return co_await async_run(
+            hasher.get_executor(),
+            [&work, &hasher]() -> std::optional<decltype(work())>
+            {
+                std::optional<decltype(work())> result;
+                try
+                {
+                    result = work();
+                }
+                catch (const std::exception &e)
+                {
+                    LOG(ERROR) << "Password hashing task failed: " << e.what();
+                }
+                hasher.release();
+                return result;
+            },
+            net::use_awaitable);
+    }
+
+    // 写入已哈希密码的用户，批量模式下等待批处理器给出结果
+    net::awaitable<db::RegisterResult> co_register(db::UserRecord &user)
+    {
+        auto &batcher = db::RegistrationBatcher::getInstance();
+        db_latency_sample const sample;
+        if (!batcher.enabled())
+        {
+            auto const result = co_await async_run(
+                db::Executor::getInstance().get_executor(),
+                [&user]
+                {
+                    return registerUser(user.username, user.password, user.phone);
+                },
+                net::use_awaitable);
+            sample.done();
+            co_return result;
+        }
+
+        auto const registered = co_await net::async_initiate<decltype(net::use_awaitable), void(db::RegisterResult)>(
+            [&batcher, &user](auto handler)
+            {
+                // 批处理器的回调须可复制
+                auto h = std::make_shared<decltype(handler)>(std::move(handler));
+                batcher.submit(std::move(user),
+                               [h](db::RegisterResult result)
+                               {
+                                   auto ex = net::get_associated_executor(*h);
+                                   net::dispatch(ex, [h, result]
+                                                 { std::move(*h)(result); });
+                               });
+            },
+            net::use_awaitable);
+        sample.done();
+        co_return registered;
+    }
+
+    // 协程挂起期间请求体与局部变量保持有效，后台线程直接引用，不需要复制
+    net::awaitable<http::response<http::string_body>> co_login(http::request<http::string_body> &req)
+    {
+        auto const form = parse_body(req);
+        auto const version = req.version();
+        auto const keep_alive = req.keep_alive();
+
+        auto const username_field = form.get("username");
+        auto const password_field = form.get("password");
+        if (!username_field || !password_field)
+        {
+            co_return redirect("/?error=login_failed", version, keep_alive);
+        }
+
+        auto const username = std::string(*username_field);
+        auto const password = std::string(*password_field);
+
+        std::optional<db::UserRecord> user;
+        if (!findUserCached(username, user))
+        {
+            db_latency_sample const sample;
+            user = co_await async_run(
+                db::Executor::getInstance().get_executor(),
+                [&username]
+                {
+                    return findUser(username);
+                },
+                net::use_awaitable);
+            sample.done();
+        }
+        if (!user)
+        {
+            co_return redirect("/?error=login_failed", version, keep_alive);
+        }
+
+        if (!reserve_hash_slot())
+        {
+            co_return service_unavailable(version, keep_alive);
+        }
+        auto valid = co_await co_hash_work([&]
+                                           { return validateUser(*user, password); });
+        co_return redirect(valid && *valid ? "/welcome.html" : "/?error=login_failed", version, keep_alive);
+    }
+
+    net::awaitable<http::response<http::string_body>> co_register_user(http::request<http::string_body> &req)
+    {
+        auto const form = parse_body(req);
+        auto const version = req.version();
+        auto const keep_alive = req.keep_alive();
+
+        auto const username_field = form.get("username");
+        auto const password_field = form.get("password");
+        auto const phone_field = form.get("phone");
+        if (!username_field || !password_field || !phone_field)
+        {
+            co_return redirect("/?error=registration_failed", version, keep_alive);
+        }
+
+        db::UserRecord user{std::string(*username_field),
+                            std::string(*password_field),
+                            std::string(*phone_field)};
+
+        // 先在哈希线程池中计算密码哈希，再写入数据库
+        if (!reserve_hash_slot())
+        {
+            co_return service_unavailable(version, keep_alive);
+        }
+        auto hash = co_await co_hash_work([&user]
+                                          { return auth::PasswordHasher::getInstance().hash(user.password); });
+        if (!hash)
+        {
+            co_return registration_redirect(db::RegisterResult::failed, version, keep_alive);
+        }
+
+        user.password = std::move(*hash);
+        co_return registration_redirect(co_await co_register(user), version, keep_alive);
+    }
+
+    // 协程版本的 POST 路由，处理器返回 awaitable
+    constexpr auto co_routes = make_router(
+        route{http::verb::post, "/login",
+              [](route_params const &, http::request<http::string_body> &req)
+              { return co_login(req); }},
+        route{http::verb::post, "/register",
+              [](route_params const &, http::request<http::string_body> &req)
+              { return co_register_user(req); }});
+
+    net::awaitable<http::response<http::string_body>> co_handle_post(http::request<http::string_body> &req)
+    {
+        route_params params;
+        auto const matched = co_routes.match(req.method(), target_path(req.target()), params);
+        if (!matched)
+        {
+            co_return bad_request(req, "Unknown endpoint");
+        }
+        co_return co_await co_routes.invoke(*matched, params, req);
+    }
+#endif
+
+    template <class Body, class Allocator, class Send>
+    void handle_request(beast::string_view doc_root,
+                        http::request<Body, http::basic_fields<Allocator>> &&req,
+                        Send &&send)
+    {
+        if (req.target().empty() || req.target()[0] != '/' || req.target().find("..") != beast::string_view::npos)
+        {
+            return send(bad_request(req, "Illegal request-target"));
+        }
+
+        // 先查路由表，未命中的 GET/HEAD 按静态文件处理
+        route_params params;
+        if (auto const matched = routes.match(req.method(), target_path(req.target()), params))
+        {
+            return routes.invoke(*matched, params, req, std::forward<Send>(send));
+        }
+
+        switch (req.method())
+        {
+        case http::verb::get:
+            return handle_get(doc_root, req, std::forward<Send>(send));
+        case http::verb::head:
+            return handle_head(doc_root, req, std::forward<Send>(send));
+        case http::verb::post:
+            return send(bad_request(req, "Unknown endpoint"));
+        default:
+            return send(bad_request(req, "Unknown HTTP-method"));
+        }
+    }
 
-        if (iequals(ext, ".htm"))
-            return "text/html";
-        if (iequals(ext, ".html"))
-            return "text/html";
-        return "application/text";
+    void fail(beast::error_code ec, char const *what)
+    {
+        LOG(ERROR) << what << ": " << ec.message();
     }
 
-    // 将路径连接到基础路径
-    std::string path_cat(beast::string_view base, beast::string_view path)
+    bool sendfile_some(int socket, sendfile_body::value_type &body, beast::error_code &ec)
     {
-        if (base.empty())
+        ec = {};
+        while (body.remaining > 0)
         {
-            return std::string(path);
+            off_t offset = static_cast<off_t>(body.offset);
+            ssize_t n = ::sendfile(socket, body.file.native_handle(), &offset,
+                                   static_cast<std::size_t>(std::min<std::uint64_t>(body.remaining, sendfile_chunk)));
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n > 0)
+            {
+                body.offset += static_cast<std::uint64_t>(n);
+                body.remaining -= static_cast<std::uint64_t>(n);
+                continue;
+            }
+            if (n == 0 || errno != EAGAIN)
+            {
+                // n == 0 表示文件在发送过程中被截断，已承诺的 Content-Length 无法满足
+                ec = n == 0
+                         ? beast::error_code(beast::errc::io_error, beast::generic_category())
+                         : beast::error_code(errno, beast::generic_category());
+            }
+            return false;
         }
-        std::string result(base);
+        return true;
+    }
 
-        char constexpr path_separator = '/';
-        if (result.back() == path_separator)
+    session::session(session_socket &&socket, tcp::endpoint const &peer,
+                     std::shared_ptr<std::string const> const &doc_root)
+        : stream_(std::move(socket)), peer_(peer), doc_root_(doc_root), file_timer_(stream_.get_executor()),
+          deadline_timer_(stream_.get_executor())
+    {
+        // 管线化的响应就绪即写出，关闭 Nagle 算法，否则连续的小响应要等对端的延迟 ACK
+        beast::error_code ec;
+        stream_.socket().set_option(tcp::no_delay(true), ec);
+        if (ec)
         {
-            result.resize(result.size() - 1);
+            fail(ec, "set_option TCP_NODELAY");
         }
-
-        result.append(path.data(), path.size());
-        return result;
+        Metrics::getInstance().session_opened();
+        AccessLog::getInstance().connection_opened(peer_);
     }
 
-    template <class Body, class Allocator>
-    http::response<http::string_body> bad_request(http::request<Body, http::basic_fields<Allocator>> &req, std::string why)
+    // listener 接受连接前已占用连接名额，会话结束时归还
+    session::~session()
     {
-        LOG(WARNING) << "Bad request: " << why;
-        http::response<http::string_body> res{http::status::bad_request, req.version()};
-        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res.set(http::field::content_type, "text/html");
-        res.keep_alive(req.keep_alive());
-        res.body() = std::string(why);
-        res.prepare_payload();
-        return res;
+        Metrics::getInstance().session_closed();
+        Admission::getInstance().close_session();
     }
 
-    template <class Body, class Allocator>
-    http::response<http::string_body> not_found(http::request<Body, http::basic_fields<Allocator>> &req, beast::string_view target)
+    void session::run()
     {
-        LOG(WARNING) << "Resource not found: " << target;
-        http::response<http::string_body> res{http::status::not_found, req.version()};
-        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res.set(http::field::content_type, "text/html");
-        res.keep_alive(req.keep_alive());
-        res.body() = "The resource '" + std::string(target) + "' was not found.";
-        res.prepare_payload();
-        return res;
+        net::dispatch(stream_.get_executor(),
+                      beast::bind_front_handler(&session::do_read, shared_from_this()));
     }
 
-    template <class Body, class Allocator>
-    http::response<http::string_body> server_error(http::request<Body, http::basic_fields<Allocator>> &req, beast::string_view what)
+    void session::do_read()
     {
-        LOG(ERROR) << "Server error: " << what;
-        http::response<http::string_body> res{http::status::internal_server_error, req.version()};
-        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res.set(http::field::content_type, "text/html");
-        res.keep_alive(req.keep_alive());
-        res.body() = "An error occurred: '" + std::string(what) + "'";
-        res.prepare_payload();
-        return res;
-    }
+        // 复用已回收的 arena，只有连接刚建立或管线化加深时才新建
+        if (!read_arena_)
+        {
+            if (spare_arenas_.empty())
+            {
+                read_arena_ = std::make_unique<request_arena>();
+            }
+            else
+            {
+                read_arena_ = std::move(spare_arenas_.back());
+                spare_arenas_.pop_back();
+            }
+        }
 
-    // 处理请求目标，解决根路径和查询参数问题
-    std::string process_target(beast::string_view target)
-    {
-        std::string target_str(target);
-        // 找到查询参数的起始位置
-        size_t query_pos = target_str.find('?');
-        // 如果有查询参数，只取路径部分
-        std::string path = (query_pos != std::string::npos) ? target_str.substr(0, query_pos) : target_str;
-        // 如果是根路径，返回index.html
-        if (path == "/")
+        if (Tracer::getInstance().enabled())
         {
-            return "/index.html";
+            read_tick_ = trace_clock();
         }
-        return path;
+
+        auto const alloc = read_arena_->allocator();
+        req_.emplace(std::piecewise_construct, std::make_tuple(alloc), std::make_tuple(alloc));
+        reading_ = true;
+
+        // 读取只在没有响应待写出时计时：管线化时读取与响应的写出同时进行，
+        // 下载大文件的客户端在写出期间不会发送任何数据
+        if (queued() == 0)
+        {
+            arm_deadline("read");
+        }
+
+        // 读操作的中间状态（解析器等）同样从 arena 分配
+        http::async_read(stream_, buffer_, *req_,
+                         net::bind_allocator(alloc, beast::bind_front_handler(&session::on_read, shared_from_this())));
     }
 
-    template <class Body, class Allocator>
-    http::message_generator handle_get(beast::string_view doc_root, http::request<Body, http::basic_fields<Allocator>> &req)
+    void session::on_read(beast::error_code ec, std::size_t bytes_transferred)
     {
-        // LOG(INFO) << "Processing GET request for: " << req.target();
-        std::string path = path_cat(doc_root, process_target(req.target()));
+        reading_ = false;
+        cancel_deadline();
+        Metrics::getInstance().add_bytes_in(bytes_transferred);
 
-        beast::error_code ec;
-        http::file_body::value_type body;
-        body.open(path.c_str(), beast::file_mode::scan, ec);
+        if (closed_)
+        {
+            return;
+        }
 
-        if (ec == beast::errc::no_such_file_or_directory)
+        if (ec == http::error::end_of_stream)
         {
-            return not_found(req, req.target());
+            AccessLog::getInstance().connection_closed(peer_, true);
+            read_closed_ = true;
+            return after_write();
         }
+
         if (ec)
         {
-            return server_error(req, ec.message());
+            read_closed_ = true;
+            fail(ec, "read");
+            return abort();
         }
 
-        http::response<http::file_body> res{
-            std::piecewise_construct,
-            std::make_tuple(std::move(body)),
-            std::make_tuple(http::status::ok, req.version())};
-        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res.set(http::field::content_type, mime_type(path));
-        res.keep_alive(req.keep_alive());
-        res.content_length(body.size());
-        return res;
-    }
-
-    template <class Body, class Allocator>
-    http::message_generator handle_head(beast::string_view doc_root, http::request<Body, http::basic_fields<Allocator>> &req)
-    {
-        // LOG(INFO) << "Processing HEAD request for: " << req.target();
-        std::string path = path_cat(doc_root, process_target(req.target()));
+        // 不保持连接的请求之后不再读取，后续请求由对端在新连接上重发
+        if (!req_->keep_alive())
+        {
+            read_closed_ = true;
+        }
 
-        beast::error_code ec;
-        http::file_body::value_type body;
-        body.open(path.c_str(), beast::file_mode::scan, ec);
+        // 请求的 arena 交给响应槽，响应写出后才回收
+        auto const seq = next_seq_++;
+        auto &slot = this->slot(seq);
+        slot.arena = std::move(read_arena_);
+        slot.start = std::chrono::steady_clock::now();
+        slot.method = req_->method();
+        slot.route = route_index(req_->method(), req_->target());
+        if (AccessLog::getInstance().enabled())
+        {
+            // 请求本身交给处理器，目标复制一份留到响应写出时记录
+            auto const target = req_->target().substr(0, access_record::max_target);
+            auto *copy = static_cast<char *>(slot.arena->resource()->allocate(target.size(), 1));
+            std::memcpy(copy, target.data(), target.size());
+            slot.target = std::string_view(copy, target.size());
+        }
 
-        if (ec == beast::errc::no_such_file_or_directory)
+        // 被采样时，处理器及其投递到其他线程的工作都记录到 slot.trace
+        auto const target = req_->target();
+        slot.trace = Tracer::getInstance().start(req_->method(), std::string_view(target.data(), target.size()));
+        if (slot.trace)
         {
-            return not_found(req, req.target());
+            // 保持连接时包含等待下一个请求的空闲时间
+            slot.trace->add("read", read_tick_, slot.trace->start);
         }
-        if (ec)
+        if (!slot.admission.acquire(route_class(slot.route)))
+        {
+            // 该类请求已达并发上限：不进入处理器，直接返回 503
+            send_lambda{shared_from_this(), seq}(overloaded(*req_));
+        }
+        else
         {
-            return server_error(req, ec.message());
+            trace_scope scope(slot.trace.get());
+            trace_phase phase("handle");
+            handle_request(*doc_root_, std::move(*req_), send_lambda{shared_from_this(), seq});
         }
+        req_.reset();
 
-        http::response<http::empty_body> res{http::status::ok, req.version()};
-        res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-        res.set(http::field::content_type, mime_type(path));
-        res.content_length(body.size());
-        res.keep_alive(req.keep_alive());
-        return res;
+        maybe_read();
     }
 
-    // 解析表单数据
-    std::map<std::string, std::string> parse_form_data(const std::string &body)
+    void session::maybe_read()
     {
-        std::map<std::string, std::string> data;
-        std::vector<std::string> pairs;
-        boost::split(pairs, body, boost::is_any_of("&"));
-
-        for (const auto &pair : pairs)
+        // 排队的请求达到上限时暂停读取，队首响应写出后恢复
+        if (reading_ || read_closed_ || closed_ || queued() >= queue_limit)
         {
-            std::vector<std::string> kv;
-            boost::split(kv, pair, boost::is_any_of("="));
-            if (kv.size() == 2)
+            return;
+        }
+        do_read();
+    }
+
+    void session::arm_deadline(char const *what)
+    {
+        deadline_timer_.expires_after(std::chrono::seconds(20));
+        deadline_timer_.async_wait(net::bind_allocator(
+            handler_allocator<void>(memory_),
+            [self = shared_from_this(), what](beast::error_code ec)
             {
-                std::string key = kv[0];
-                std::string value = kv[1];
-                // URL decode
-                std::string decoded;
-                for (size_t i = 0; i < value.length(); ++i)
+                // 取消时到期时间被推到最远，已经排队的回调据此忽略
+                if (ec || self->closed_ || self->deadline_timer_.expiry() > std::chrono::steady_clock::now())
                 {
-                    if (value[i] == '%' && i + 2 < value.length())
-                    {
-                        int hex_val;
-                        std::stringstream ss;
-                        ss << std::hex << value.substr(i + 1, 2);
-                        ss >> hex_val;
-                        decoded += static_cast<char>(hex_val);
-                        i += 2;
-                    }
-                    else if (value[i] == '+')
-                    {
-                        decoded += ' ';
-                    }
-                    else
-                    {
-                        decoded += value[i];
-                    }
+                    return;
                 }
-                data[key] = decoded;
-            }
-        }
-        return data;
+                fail(beast::error::timeout, what);
+                self->abort();
+            }));
     }
 
-    bool validateUser(const std::string &username, const std::string &password)
+    void session::cancel_deadline()
     {
-        auto &pool = db::ConnectionPool::getInstance();
-        auto conn = pool.getConnection();
-        if (!conn)
+        deadline_timer_.expires_at(session_timer::time_point::max());
+    }
+
+    void session::release_slot(response_slot &slot)
+    {
+        // 先销毁响应，再回收它们所在的 arena
+        slot.msg.reset();
+        slot.file.reset();
+        slot.ready = false;
+        slot.keep_alive = true;
+        slot.single_buffer = false;
+        slot.target = {};
+        slot.status = 0;
+        slot.bytes = 0;
+        slot.admission.reset();
+        slot.trace.reset();
+        slot.ready_tick = 0;
+        slot.write_tick = 0;
+        if (slot.arena)
         {
-            LOG(ERROR) << "Failed to get database connection for user validation";
-            return false;
+            slot.arena->reset();
+            spare_arenas_.push_back(std::move(slot.arena));
         }
+    }
 
-        try
+    void session::send_response(response_slot &slot, bool single_buffer)
+    {
+        slot.keep_alive = slot.msg->keep_alive();
+        slot.single_buffer = single_buffer;
+        slot.ready = true;
+        if (slot.trace)
         {
-            // 创建一个预处理语句，用于查询用户
-            std::unique_ptr<sql::PreparedStatement> stmt(
-                conn->prepareStatement("SELECT * FROM users WHERE username = ? AND password = ?"));
-            stmt->setString(1, username);
-            stmt->setString(2, password);
+            slot.ready_tick = trace_clock();
+        }
 
-            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
-            bool valid = res->next(); // 如果有结果，则用户验证成功
+        do_write();
+    }
 
-            pool.releaseConnection(conn);
-            return valid;
+    void session::send_file(std::uint64_t seq, http::response<sendfile_body> &&res)
+    {
+        if (closed_)
+        {
+            return;
         }
-        catch (const sql::SQLException &e)
+
+        auto &slot = this->slot(seq);
+        slot.keep_alive = res.keep_alive();
+        slot.status = res.result_int();
+        slot.file.emplace(std::move(res));
+        slot.ready = true;
+        if (slot.trace)
         {
-            LOG(ERROR) << "SQL Error validating user: " << e.what()
-                       << " (MySQL error code: " << e.getErrorCode()
-                       << ", SQLState: " << e.getSQLState() << ")";
-            pool.releaseConnection(conn);
-            return false;
+            slot.ready_tick = trace_clock();
         }
+
+        do_write();
     }
 
-    bool registerUser(const std::string &username, const std::string &password, const std::string &phone)
+    void session::do_write()
     {
-        auto &pool = db::ConnectionPool::getInstance();
-        auto conn = pool.getConnection();
-        if (!conn)
+        if (writing_ || closed_ || queued() == 0 || !slot(front_seq_).ready)
         {
-            LOG(ERROR) << "Failed to get database connection for user registration";
-            return false;
+            return;
         }
 
-        try
+        if (slot(front_seq_).file)
         {
-            //  检查用户名和电话号码是否已经存在
-            std::unique_ptr<sql::PreparedStatement> check_stmt(
-                conn->prepareStatement("SELECT username, phone FROM users WHERE username = ? OR phone = ?"));
-            check_stmt->setString(1, username);
-            check_stmt->setString(2, phone);
-            std::unique_ptr<sql::ResultSet> check_res(check_stmt->executeQuery());
+            return write_file();
+        }
 
-            if (check_res->next())
+        // 合并队首起连续已就绪的响应，一次写出。
+        // 只有前一个响应已在本次缓冲区中完整序列化时才能追加下一个
+        write_buffers_.clear();
+        write_sizes_.clear();
+        for (auto seq = front_seq_; seq != next_seq_; ++seq)
+        {
+            auto &slot = this->slot(seq);
+            if (!slot.ready || slot.file)
             {
-                if (check_res->getString("username") == username)
-                {
-                    LOG(WARNING) << "Username already exists: " << username;
-                }
-                else
-                {
-                    LOG(WARNING) << "Phone number already exists: " << phone;
-                }
-                pool.releaseConnection(conn);
-                return false;
+                break;
             }
 
-            // 创建一个预处理语句，用于插入新用户
-            std::unique_ptr<sql::PreparedStatement> stmt(
-                conn->prepareStatement(
-                    "INSERT INTO users (username, password, phone) VALUES (?, ?, ?)"));
-            stmt->setString(1, username);
-            stmt->setString(2, password); // 注意：实际应用中应该使用哈希密码
-            stmt->setString(3, phone);
+            beast::error_code ec;
+            auto const buffers = slot.msg->prepare(ec);
+            if (ec)
+            {
+                fail(ec, "write");
+                return abort();
+            }
 
-            stmt->execute();
-            pool.releaseConnection(conn);
-            return true;
-        }
-        catch (const sql::SQLException &e)
-        {
-            LOG(ERROR) << "SQL Error registering user: " << e.what()
-                       << " (MySQL error code: " << e.getErrorCode()
-                       << ", SQLState: " << e.getSQLState() << ")";
-            pool.releaseConnection(conn);
-            return false;
+            std::size_t size = 0;
+            for (auto const &buffer : buffers)
+            {
+                write_buffers_.push_back(buffer);
+                size += buffer.size();
+            }
+            write_sizes_.push_back(size);
+            start_write_trace(slot);
+
+            if (!slot.single_buffer || !slot.keep_alive)
+            {
+                break;
+            }
         }
+
+        writing_ = true;
+        arm_deadline("write");
+        // 以 span 传入，写操作不复制缓冲区数组
+        net::async_write(stream_, beast::span<net::const_buffer const>(write_buffers_.data(), write_buffers_.size()),
+                         net::bind_allocator(handler_allocator<void>(memory_),
+                                             beast::bind_front_handler(&session::on_write, shared_from_this())));
     }
 
-    template <class Body, class Allocator>
-    http::message_generator handle_post(beast::string_view doc_root, http::request<Body, http::basic_fields<Allocator>> &req)
+    void session::on_write(beast::error_code ec, std::size_t bytes_transferred)
     {
-        LOG(INFO) << "Processing POST request for: " << req.target();
+        writing_ = false;
+        cancel_deadline();
+        Metrics::getInstance().add_bytes_out(bytes_transferred);
 
-        auto const target = std::string(req.target());
-        auto form_data = parse_form_data(req.body());   // 解析表单数据
+        if (closed_)
+        {
+            return;
+        }
 
-        // 处理登录和注册请求
-        if (target == "/login") 
+        if (ec)
         {
-            auto username_it = form_data.find("username");
-            auto password_it = form_data.find("password");
+            fail(ec, "write");
+            return abort();
+        }
 
-            if (username_it != form_data.end() && password_it != form_data.end())
+        for (std::size_t i = 0; i < write_sizes_.size(); ++i)
+        {
+            auto &front = slot(front_seq_);
+            auto &msg = *front.msg;
+            msg.consume(write_sizes_[i]);
+            front.bytes += write_sizes_[i];
+            if (!msg.is_done())
             {
-                if (validateUser(username_it->second, password_it->second))
+                // 只有最后一个响应可能还有剩余内容，继续写出
+                if (i + 1 != write_sizes_.size())
                 {
-                    http::response<http::string_body> res{http::status::see_other, req.version()};
-                    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-                    res.set(http::field::location, "/welcome.html");
-                    res.keep_alive(req.keep_alive());
-                    return res;
+                    LOG(ERROR) << "Coalesced response was not fully serialized";
+                    return abort();
                 }
+                break;
             }
-            // Login failed
-            http::response<http::string_body> res{http::status::see_other, req.version()};
-            res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-            res.set(http::field::location, "/?error=login_failed");
-            res.keep_alive(req.keep_alive());
-            return res;
-        }
-        else if (target == "/register")
-        {
-            auto username_it = form_data.find("username");
-            auto password_it = form_data.find("password");
-            auto phone_it = form_data.find("phone");
-
-            if (username_it != form_data.end() &&
-                password_it != form_data.end() &&
-                phone_it != form_data.end())
+            if (!pop_response())
             {
-                if (registerUser(username_it->second, password_it->second, phone_it->second))
-                {
-                    http::response<http::string_body> res{http::status::see_other, req.version()};
-                    res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-                    res.set(http::field::location, "/?success=registration");
-                    res.keep_alive(req.keep_alive());
-                    return res;
-                }
+                return;
             }
-            // Registration failed
-            http::response<http::string_body> res{http::status::see_other, req.version()};
-            res.set(http::field::server, BOOST_BEAST_VERSION_STRING);
-            res.set(http::field::location, "/?error=registration_failed");
-            res.keep_alive(req.keep_alive());
-            return res;
         }
 
-        return bad_request(req, "Unknown endpoint");
+        after_write();
     }
 
-    template <class Body, class Allocator>
-    http::message_generator handle_request(beast::string_view doc_root,
-                                           http::request<Body, http::basic_fields<Allocator>> &&req)
+    void session::write_file()
     {
-        if (req.target().empty() || req.target()[0] != '/' || req.target().find("..") != beast::string_view::npos)
+        auto &slot = this->slot(front_seq_);
+        start_write_trace(slot);
+        file_res_.emplace(std::move(*slot.file));
+        file_sr_.emplace(*file_res_);
+        slot.file.reset();
+        writing_ = true;
+
+        // 先写出响应头，正文在 on_file_header 之后通过 sendfile 发送
+        arm_deadline("write");
+        http::async_write(stream_, *file_sr_,
+                          net::bind_allocator(handler_allocator<void>(memory_),
+                                              beast::bind_front_handler(&session::on_file_header, shared_from_this())));
+    }
+
+    void session::on_file_header(beast::error_code ec, std::size_t bytes_transferred)
+    {
+        cancel_deadline();
+        Metrics::getInstance().add_bytes_out(bytes_transferred);
+        slot(front_seq_).bytes += bytes_transferred;
+
+        if (closed_)
         {
-            return bad_request(req, "Illegal request-target");
+            return;
         }
 
-        // 处理请求
-        switch (req.method())
+        if (ec)
         {
-        case http::verb::get:
-            return handle_get(doc_root, req);
-        case http::verb::head:
-            return handle_head(doc_root, req);
-        case http::verb::post:
-            return handle_post(doc_root, req);
-        default:
-            return bad_request(req, "Unknown HTTP-method");
+            fail(ec, "write");
+            return abort();
         }
-    }
 
-    void fail(beast::error_code ec, char const *what)
-    {
-        LOG(ERROR) << what << ": " << ec.message();
+        stream_.socket().native_non_blocking(true, ec);
+        if (ec)
+        {
+            fail(ec, "sendfile");
+            return abort();
+        }
+
+        do_sendfile();
     }
 
-    session::session(tcp::socket &&socket, std::shared_ptr<std::string const> const &doc_root)
-        : stream_(std::move(socket)), doc_root_(doc_root)
+    void session::do_sendfile()
     {
-        LOG(INFO) << "New session created from " << stream_.socket().remote_endpoint();
+        auto &socket = stream_.socket();
+
+        beast::error_code ec;
+        auto const remaining = file_res_->body().remaining;
+        bool const done = sendfile_some(socket.native_handle(), file_res_->body(), ec);
+        Metrics::getInstance().add_bytes_out(remaining - file_res_->body().remaining);
+        slot(front_seq_).bytes += remaining - file_res_->body().remaining;
+        if (!done)
+        {
+            if (ec)
+            {
+                fail(ec, "sendfile");
+                return abort();
+            }
+
+            // 等待 socket 可写后继续，同时给同一 io_context 上的其他 session 让出线程。
+            // 超时只取消这次等待，socket.cancel() 会连同管线化的读取一起取消
+            file_timer_.expires_after(std::chrono::seconds(20));
+            file_timer_.async_wait(net::bind_allocator(
+                handler_allocator<void>(memory_),
+                [self = shared_from_this()](beast::error_code ec)
+                {
+                    if (!ec)
+                    {
+                        self->file_cancel_.emit(net::cancellation_type::terminal);
+                    }
+                }));
+            socket.async_wait(tcp::socket::wait_write,
+                              net::bind_cancellation_slot(
+                                  file_cancel_.slot(),
+                                  net::bind_allocator(
+                                      handler_allocator<void>(memory_),
+                                      [self = shared_from_this()](beast::error_code ec)
+                                      {
+                                          if (self->closed_)
+                                          {
+                                              return;
+                                          }
+                                          if (ec)
+                                          {
+                                              fail(ec == net::error::operation_aborted ? beast::error::timeout : ec,
+                                                   "sendfile");
+                                              return self->abort();
+                                          }
+                                          self->do_sendfile();
+                                      })));
+            return;
+        }
+
+        finish_file();
+        writing_ = false;
+        if (pop_response())
+        {
+            after_write();
+        }
     }
 
-    void session::run()
+    void session::finish_file()
     {
-        net::dispatch(stream_.get_executor(),
-                      beast::bind_front_handler(&session::do_read, shared_from_this()));
+        file_timer_.cancel();
+        file_sr_.reset();
+        file_res_.reset();
     }
 
-    void session::do_read()
+    void session::start_write_trace(response_slot &slot)
     {
-        req_ = {};
-        stream_.expires_after(std::chrono::seconds(20));
-
-        http::async_read(stream_, buffer_, req_,
-                         beast::bind_front_handler(&session::on_read, shared_from_this()));
+        // 就绪到开始写出之间在等待前面的响应（管线化的队头阻塞）
+        if (slot.trace && slot.write_tick == 0)
+        {
+            slot.write_tick = trace_clock();
+            slot.trace->add("queued", slot.ready_tick, slot.write_tick);
+        }
     }
 
-    void session::on_read(beast::error_code ec, std::size_t bytes_transferred)
+    bool session::pop_response()
     {
-        boost::ignore_unused(bytes_transferred);
-
-        if (ec == http::error::end_of_stream)
+        auto &front = slot(front_seq_);
+        bool const keep_alive = front.keep_alive;
+        auto const elapsed = std::chrono::steady_clock::now() - front.start;
+        Metrics::getInstance().record_request(front.method, front.status, front.route, elapsed);
+        AccessLog::getInstance().request(peer_, front.method, front.target, front.status, front.bytes, elapsed);
+        if (front.trace)
         {
-            LOG(INFO) << "Connection closed by client: " << stream_.socket().remote_endpoint();
-            return do_close();
+            front.trace->add("write", front.write_tick, trace_clock());
+            Tracer::getInstance().finish(std::move(front.trace), front.status);
         }
+        release_slot(front);
+        ++front_seq_;
 
-        if (ec)
+        if (!keep_alive)
         {
-            return fail(ec, "read");
+            AccessLog::getInstance().connection_closed(peer_, false);
+            do_close();
+            return false;
         }
-
-        send_response(handle_request(*doc_root_, std::move(req_)));
+        return true;
     }
 
-    void session::send_response(http::message_generator &&msg)
+    void session::after_write()
     {
-        bool keep_alive = msg.keep_alive();
-
-        beast::async_write(stream_, std::move(msg),
-                           beast::bind_front_handler(&session::on_write, shared_from_this(), keep_alive));
-    }
-
-    void session::on_write(bool keep_alive, beast::error_code ec, std::size_t bytes_transferred)
-    {
-        boost::ignore_unused(bytes_transferred);
+        // 对端已停止发送且所有响应都已写出
+        if (read_closed_ && !reading_ && queued() == 0)
+        {
+            return do_close();
+        }
 
-        if (ec)
+        // 排队的响应都已写出，之前发起的读取从现在开始计算空闲时间
+        if (reading_ && queued() == 0)
         {
-            return fail(ec, "write");
+            arm_deadline("read");
         }
+        maybe_read();
+        do_write();
+    }
 
-        if (!keep_alive)
+    void session::abort()
+    {
+        // 连接出错，丢弃排队的响应；仍在异步处理中的请求完成后 send 直接返回
+        finish_file();
+        cancel_deadline();
+        writing_ = false;
+        for (; front_seq_ != next_seq_; ++front_seq_)
         {
-            LOG(INFO) << "Closing connection (no keep-alive): " << stream_.socket().remote_endpoint();
-            return do_close();
+            release_slot(slot(front_seq_));
         }
+        closed_ = true;
 
-        do_read();
+        beast::error_code ec;
+        stream_.socket().close(ec);
     }
 
     void session::do_close()
     {
+        if (closed_)
+        {
+            return;
+        }
+        closed_ = true;
+        cancel_deadline();
+
         beast::error_code ec;
         stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
         if (ec)
@@ -473,8 +1741,10 @@ namespace http_server
 
     // Listener
     listener::listener(net::io_context &ioc, tcp::endpoint endpoint,
-                       std::shared_ptr<std::string const> const &doc_root)
-        : ioc_(ioc), acceptor_(net::make_strand(ioc)), doc_root_(doc_root)
+                       std::shared_ptr<std::string const> const &doc_root,
+                       bool reuse_port)
+        : ioc_(ioc), acceptor_(net::make_strand(ioc)), doc_root_(doc_root), reuse_port_(reuse_port),
+          accept_timer_(acceptor_.get_executor())
     {
         beast::error_code ec;
 
@@ -495,6 +1765,17 @@ namespace http_server
             return;
         }
 
+        // 多个监听套接字绑定同一端口，由内核按连接哈希分配到各线程
+        if (reuse_port_)
+        {
+            int one = 1;
+            if (::setsockopt(acceptor_.native_handle(), SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0)
+            {
+                fail(beast::error_code(errno, beast::system_category()), "set_option SO_REUSEPORT");
+                return;
+            }
+        }
+
         acceptor_.bind(endpoint, ec);
         if (ec)
         {
@@ -514,32 +1795,85 @@ namespace http_server
 
     void listener::run()
     {
+#ifdef HTTP_SERVER_COROUTINES
+        net::co_spawn(acceptor_.get_executor(),
+                      [self = shared_from_this()]
+                      { return self->co_accept(); },
+                      net::detached);
+#else
         do_accept();
+#endif
     }
 
     void listener::do_accept()
     {
+        // 连接数已达上限时不再 accept，新连接留在内核的监听队列中，队列满后由客户端重试
+        if (!Admission::getInstance().try_open_session())
+        {
+            return pause_accept();
+        }
+
+        // 两种模式都使用 strand，会话的执行器类型固定为 session_executor。
+        // 每线程一个 io_context 时，会话留在接受它的线程上，strand 没有竞争
         acceptor_.async_accept(
             net::make_strand(ioc_),
+            peer_,
             beast::bind_front_handler(&listener::on_accept, shared_from_this()));
     }
 
-    void listener::on_accept(beast::error_code ec, tcp::socket socket)
+    void listener::on_accept(beast::error_code ec, session_socket socket)
     {
         if (ec)
         {
             fail(ec, "accept");
+            Metrics::getInstance().accept_error();
+            Admission::getInstance().close_session();
         }
         else
         {
-            LOG(INFO) << "Accepted connection from " << socket.remote_endpoint();
-            std::make_shared<session>(std::move(socket), doc_root_)->run();
+            std::make_shared<session>(std::move(socket), peer_, doc_root_)->run();
         }
 
         do_accept();
     }
 
+    void listener::pause_accept()
+    {
+        LOG_EVERY_N(WARNING, 100) << "Session limit reached, pausing accept";
+        accept_timer_.expires_after(accept_pause);
+        accept_timer_.async_wait(
+            [self = shared_from_this()](beast::error_code ec)
+            {
+                if (!ec)
+                {
+                    self->do_accept();
+                }
+            });
+    }
+
     // 明确实例化模板
-    template http::message_generator handle_request<http::string_body, std::allocator<char>>(
-        beast::string_view, http::request<http::string_body, http::basic_fields<std::allocator<char>>> &&req);
+    template void handle_request<arena_request::body_type, arena_allocator<char>, session::send_lambda>(
+        beast::string_view, arena_request &&req, session::send_lambda &&send);
+
+#ifdef HTTP_SERVER_CAPTURE_SEND
+    // 微基准与测试在内存中调用的处理器，只编译进它们链接的 http_server_capture.o
+    template void handle_request<arena_request::body_type, arena_allocator<char>, capture_send>(
+        beast::string_view, arena_request &&req, capture_send &&send);
+    template form_data parse_body<arena_request::body_type, arena_request::fields_type>(arena_request &req);
+    template string_response<arena_allocator<char>> bad_request<arena_request::body_type, arena_allocator<char>>(
+        arena_request &req, beast::string_view why);
+    template string_response<arena_allocator<char>> not_found<arena_request::body_type, arena_allocator<char>>(
+        arena_request &req, beast::string_view target);
+    template string_response<std::allocator<char>> bad_request<http::string_body, std::allocator<char>>(
+        http::request<http::string_body> &req, beast::string_view why);
+    template string_response<std::allocator<char>> not_found<http::string_body, std::allocator<char>>(
+        http::request<http::string_body> &req, beast::string_view target);
+#endif
+#ifdef HTTP_SERVER_COROUTINES
+    template void handle_request<http::string_body, std::allocator<char>, coro_send>(
+        beast::string_view, http::request<http::string_body, http::basic_fields<std::allocator<char>>> &&req,
+        coro_send &&send);
+    template string_response<std::allocator<char>> overloaded<http::string_body, std::allocator<char>>(
+        http::request<http::string_body, http::basic_fields<std::allocator<char>>> &req);
+#endif
 } // namespace http_server
@@ -14,9 +14,31 @@
 #include <boost/asio/strand.hpp>
 #include <boost/config.hpp>
 #include <boost/beast/core/flat_buffer.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/cancellation_signal.hpp>
+#include <boost/optional.hpp>
+#ifdef HTTP_SERVER_COROUTINES
+#include <boost/asio/awaitable.hpp>
+#endif
 
+#include "sendfile_body.hpp"
+#include "handler_memory.hpp"
+#include "admission.hpp"
+#include "form_parser.hpp"
+#include "request_arena.hpp"
+#include "tracing.hpp"
+#include "../database/registration.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <type_traits>
+#include <vector>
 #include <glog/logging.h>
 
 namespace beast = boost::beast;
@@ -28,58 +50,265 @@ namespace http_server
 {
 
     // 辅助函数
-    beast::string_view mime_type(beast::string_view path);
     std::string path_cat(beast::string_view base, beast::string_view path);
+
+    // 同上，结果字符串使用指定的分配器（如请求的 arena）
+    template <class Allocator>
+    std::basic_string<char, std::char_traits<char>, Allocator>
+    path_cat(beast::string_view base, beast::string_view path, Allocator const &alloc)
+    {
+        std::basic_string<char, std::char_traits<char>, Allocator> result(alloc);
+        result.reserve(base.size() + path.size());
+        result.append(base.data(), base.size());
+
+        char constexpr path_separator = '/';
+        if (!result.empty() && result.back() == path_separator)
+        {
+            result.pop_back();
+        }
+
+        result.append(path.data(), path.size());
+        return result;
+    }
     void fail(beast::error_code ec, char const *what);
 
-    // HTTP 响应生成器
+    // 处理请求目标，根路径映射为 /index.html 并去掉查询参数；返回值引用 target
+    beast::string_view process_target(beast::string_view target);
+
+    // 在非阻塞 socket（原生描述符）上用 sendfile(2) 发送 body 的剩余内容。
+    // 全部发送完返回 true；socket 暂不可写或出错时返回 false，出错时设置 ec
+    bool sendfile_some(int socket, sendfile_body::value_type &body, beast::error_code &ec);
+
+    // 静态文件不小于该大小时通过 sendfile(2) 发送，0 表示禁用
+    void set_sendfile_threshold(std::uint64_t bytes);
+
+    // 静态文件响应的 Cache-Control 值
+    void set_cache_control(std::string value);
+    beast::string_view cache_control();
+
+    // 与请求使用同一分配器的响应：session 的请求从 arena 分配，
+    // 处理器生成的响应头和字符串响应体也随之从 arena 分配，随请求一起释放
     template <class Body, class Allocator>
-    http::response<http::string_body> bad_request(http::request<Body, http::basic_fields<Allocator>> &req, std::string why);
+    using response_for = http::response<Body, http::basic_fields<Allocator>>;
+
+    template <class Allocator>
+    using string_response = response_for<http::basic_string_body<char, std::char_traits<char>, Allocator>, Allocator>;
 
+    // HTTP 响应生成器
     template <class Body, class Allocator>
-    http::response<http::string_body> not_found(http::request<Body, http::basic_fields<Allocator>> &req, beast::string_view target);
+    string_response<Allocator> bad_request(http::request<Body, http::basic_fields<Allocator>> &req, beast::string_view why);
 
     template <class Body, class Allocator>
-    http::response<http::string_body> server_error(http::request<Body, http::basic_fields<Allocator>> &req, beast::string_view what);
+    string_response<Allocator> not_found(http::request<Body, http::basic_fields<Allocator>> &req, beast::string_view target);
 
-    // HTTP 请求处理器
     template <class Body, class Allocator>
-    http::message_generator handle_get(beast::string_view doc_root, http::request<Body, http::basic_fields<Allocator>> &req);
+    string_response<Allocator> server_error(http::request<Body, http::basic_fields<Allocator>> &req, beast::string_view what);
 
+    // 过载时的 503，带 Retry-After
     template <class Body, class Allocator>
-    http::message_generator handle_head(beast::string_view doc_root, http::request<Body, http::basic_fields<Allocator>> &req);
+    string_response<Allocator> overloaded(http::request<Body, http::basic_fields<Allocator>> &req);
+
+    // HTTP 请求处理器
+    // 处理器通过 send 回调交出生成的响应，由 session 决定如何写出
+    template <class Body, class Allocator, class Send>
+    void handle_get(beast::string_view doc_root, http::request<Body, http::basic_fields<Allocator>> &req, Send &&send);
+
+    template <class Body, class Allocator, class Send>
+    void handle_head(beast::string_view doc_root, http::request<Body, http::basic_fields<Allocator>> &req, Send &&send);
+
+    // 按用户名查询用户记录（先查缓存），用户不存在或出错时返回空
+    std::optional<db::UserRecord> findUser(const std::string &username);
+
+    // 仅查询用户缓存，不访问数据库；缓存能给出结论时返回 true 并设置 user
+    bool findUserCached(const std::string &username, std::optional<db::UserRecord> &user);
 
-    // 用户验证函数
-    bool validateUser(const std::string &username, const std::string &password);
+    // 用户验证函数：校验密码哈希（耗时，须在哈希线程池中调用），必要时升级旧的存储格式
+    bool validateUser(const db::UserRecord &user, const std::string &password);
 
     // 用户注册函数
-    bool registerUser(const std::string &username, const std::string &password, const std::string &phone);
+    db::RegisterResult registerUser(const std::string &username, const std::string &password, const std::string &phone);
 
-    template <class Body, class Allocator>
-    http::message_generator handle_post(beast::string_view doc_root, http::request<Body, http::basic_fields<Allocator>> &req);
+    // POST /login 与 POST /register，由 handle_request 经路由表调用
+    template <class Body, class Allocator, class Send>
+    void handle_login(http::request<Body, http::basic_fields<Allocator>> &req, Send &&send);
+
+    template <class Body, class Allocator, class Send>
+    void handle_register(http::request<Body, http::basic_fields<Allocator>> &req, Send &&send);
+
+    // GET /metrics：Prometheus 文本格式的运行指标
+    template <class Body, class Allocator, class Send>
+    void handle_metrics(http::request<Body, http::basic_fields<Allocator>> &req, Send &&send);
+
+    // 解析 POST 请求体，字段指向请求体本身（转义就地解码）。格式错误时按没有字段处理
+    template <class Body, class Fields>
+    form_data parse_body(http::request<Body, Fields> &req);
+
+    // 请求所属路由的序号，用于按路由统计延迟
+    std::size_t route_index(http::verb method, beast::string_view target);
+
+    // 路由序号对应的准入类别
+    request_class route_class(std::size_t route);
 
     // 请求处理函数
-    template <class Body, class Allocator>
-    http::message_generator handle_request(beast::string_view doc_root,
-                                           http::request<Body, http::basic_fields<Allocator>> &&req);
+    template <class Body, class Allocator, class Send>
+    void handle_request(beast::string_view doc_root,
+                        http::request<Body, http::basic_fields<Allocator>> &&req,
+                        Send &&send);
+
+    // 一次 prepare 即可序列化出完整消息（头部与全部正文）的 Body。
+    // 这类响应写完当前缓冲区即结束，可以与后面的响应合并为一次写操作
+    template <class Body>
+    struct is_single_buffer_body : std::false_type
+    {
+    };
+
+    template <class CharT, class Traits, class Allocator>
+    struct is_single_buffer_body<http::basic_string_body<CharT, Traits, Allocator>> : std::true_type
+    {
+    };
+
+    template <>
+    struct is_single_buffer_body<http::empty_body> : std::true_type
+    {
+    };
+
+    // 会话使用的执行器。用具体的 strand 类型而不是 any_io_executor：strand 放不进 any_io_executor 的
+    // 内联存储，每个异步操作登记 outstanding work 时都会在堆上复制一份，完成回调也要经类型擦除再分配一次
+    using session_executor = net::strand<net::io_context::executor_type>;
+    using session_socket = tcp::socket::rebind_executor<session_executor>::other;
+    using session_stream = beast::basic_stream<tcp, session_executor>;
+    using session_timer = net::basic_waitable_timer<std::chrono::steady_clock,
+                                                    net::wait_traits<std::chrono::steady_clock>, session_executor>;
 
-    // Session 类，用于处理 HTTP 请求
+    // Session 类，用于处理 HTTP 请求。
+    // 支持 HTTP/1.1 管线化：写响应的同时继续读取后续请求，响应按请求顺序写出
     class session : public std::enable_shared_from_this<session>
     {
-        beast::tcp_stream stream_;
+        // 处理器生成响应后调用此对象，把响应交给 session 写出。
+        // 持有 session 的 shared_ptr，异步处理（如数据库请求）期间 session 保持存活；
+        // seq_ 为请求序号，响应可以乱序完成，但按序号写出
+        struct send_lambda
+        {
+            std::shared_ptr<session> self_;
+            std::uint64_t seq_;
+
+            // 响应在 session 的 strand 上交给 send，类型擦除后的对象从该请求的 arena 分配
+            template <bool isRequest, class Body, class Fields>
+            void operator()(http::message<isRequest, Body, Fields> &&msg) const
+            {
+                if (self_->closed_)
+                {
+                    return;
+                }
+                auto &slot = self_->slot(seq_);
+                if constexpr (!isRequest)
+                {
+                    slot.status = msg.result_int();
+                }
+                slot.msg.emplace(std::move(msg), slot.arena->resource());
+                self_->send_response(slot, is_single_buffer_body<Body>::value);
+            }
+
+            void operator()(http::response<sendfile_body> &&msg) const
+            {
+                self_->send_file(seq_, std::move(msg));
+            }
+
+            // session 的 strand，异步处理完成后需回到这里调用 send
+            session_executor get_executor() const
+            {
+                return self_->stream_.get_executor();
+            }
+        };
+
+        // 等待写出的响应，按请求序号在环形队列中定位
+        struct response_slot
+        {
+            std::unique_ptr<request_arena> arena; // 请求及其响应使用的内存，响应写出后回收
+            boost::optional<response_generator> msg;
+            boost::optional<http::response<sendfile_body>> file;
+            bool ready{false};
+            bool keep_alive{true};
+            bool single_buffer{false};
+
+            // 指标与访问日志：请求读完的时间、方法、路由序号、请求目标（复制在 arena 中）、
+            // 响应状态码与已写出的字节数
+            std::chrono::steady_clock::time_point start;
+            http::verb method{http::verb::unknown};
+            std::size_t route{0};
+            std::string_view target;
+            unsigned status{0};
+            std::uint64_t bytes{0};
+
+            admission_ticket admission; // 请求占用的准入名额，响应写出后归还
+
+            // 被采样的请求：响应就绪与开始写出的时间戳
+            trace_ptr trace;
+            std::uint64_t ready_tick{0};
+            std::uint64_t write_tick{0};
+        };
+
+        // 每个连接最多同时排队的请求数，达到后暂停读取
+        static constexpr std::size_t queue_limit = 16;
+
+        session_stream stream_;
+        handler_memory memory_; // 写操作、sendfile 等待与定时器的中间状态（读操作使用请求的 arena）
+        tcp::endpoint peer_; // 接受连接时取得的对端地址
         beast::flat_buffer buffer_;
         std::shared_ptr<std::string const> doc_root_;
-        http::request<http::string_body> req_;
+        boost::optional<arena_request> req_;
+        std::unique_ptr<request_arena> read_arena_;                // 正在读取的请求使用的 arena
+        std::uint64_t read_tick_{0};                               // 开始读取的时间戳（启用跟踪时）
+        std::vector<std::unique_ptr<request_arena>> spare_arenas_; // 已回收、可复用的 arena
+
+        std::array<response_slot, queue_limit> responses_; // [front_seq_, next_seq_) 为排队中的请求
+        std::uint64_t next_seq_{0};                         // 下一个请求的序号
+        std::uint64_t front_seq_{0};                        // 队首响应的序号
+        bool reading_{false};
+        bool writing_{false};
+        bool read_closed_{false}; // 不再读取新请求（对端关闭、读取出错或请求不保持连接）
+        bool closed_{false};
+
+        // 合并写出时各响应的缓冲区及字节数
+        std::vector<net::const_buffer> write_buffers_;
+        std::vector<std::size_t> write_sizes_;
+
+        // sendfile 发送中的响应及其序列化器（只负责写出响应头）
+        boost::optional<http::response<sendfile_body>> file_res_;
+        boost::optional<http::response_serializer<sendfile_body>> file_sr_;
+        session_timer file_timer_;             // sendfile 等待 socket 可写的超时
+        net::cancellation_signal file_cancel_; // 超时只取消等待可写，不影响管线化的读取
+
+        // 等待新请求（空闲）或写出响应的超时，两者不会同时计时。
+        // 不使用 tcp_stream 自带的超时：它的定时器每次写出都要复制执行器并分配处理器的中间状态
+        session_timer deadline_timer_;
 
     public:
-        session(tcp::socket &&socket, std::shared_ptr<std::string const> const &doc_root);
+        session(session_socket &&socket, tcp::endpoint const &peer, std::shared_ptr<std::string const> const &doc_root);
+        ~session();
         void run();
 
     private:
         void do_read();
         void on_read(beast::error_code ec, std::size_t bytes_transferred);
-        void send_response(http::message_generator &&msg);
-        void on_write(bool keep_alive, beast::error_code ec, std::size_t bytes_transferred);
+        void maybe_read();
+        void arm_deadline(char const *what);
+        void cancel_deadline();
+        response_slot &slot(std::uint64_t seq) { return responses_[seq % queue_limit]; }
+        std::size_t queued() const { return static_cast<std::size_t>(next_seq_ - front_seq_); }
+        void release_slot(response_slot &slot);
+        void send_response(response_slot &slot, bool single_buffer);
+        void send_file(std::uint64_t seq, http::response<sendfile_body> &&res);
+        void do_write();
+        void on_write(beast::error_code ec, std::size_t bytes_transferred);
+        void write_file();
+        void on_file_header(beast::error_code ec, std::size_t bytes_transferred);
+        void do_sendfile();
+        void finish_file();
+        void start_write_trace(response_slot &slot);
+        bool pop_response();
+        void after_write();
+        void abort();
         void do_close();
     };
 
@@ -88,16 +317,24 @@ namespace http_server
     {
         net::io_context &ioc_;
         tcp::acceptor acceptor_;
+        tcp::endpoint peer_; // accept 同时返回对端地址，不再另外调用 getpeername
         std::shared_ptr<std::string const> doc_root_;
+        bool reuse_port_; // 每个线程独立的 io_context 与监听套接字（SO_REUSEPORT）
+        net::steady_timer accept_timer_; // 连接数达到上限时暂停 accept，定时重试
 
     public:
         listener(net::io_context &ioc, tcp::endpoint endpoint,
-                 std::shared_ptr<std::string const> const &doc_root);
+                 std::shared_ptr<std::string const> const &doc_root,
+                 bool reuse_port = false);
         void run();
 
     private:
         void do_accept();
-        void on_accept(beast::error_code ec, tcp::socket socket);
+        void on_accept(beast::error_code ec, session_socket socket);
+        void pause_accept();
+#ifdef HTTP_SERVER_COROUTINES
+        net::awaitable<void> co_accept(); // 协程版本的接受循环，见 coro_session.cpp
+#endif
     };
 
 } // namespace http_server
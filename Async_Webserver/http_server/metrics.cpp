@@ -0,0 +1,241 @@
+#include "metrics.hpp"
+#include "access_log.hpp"
+#include "admission.hpp"
+#include "tracing.hpp"
+#include "../database/db_pool.hpp"
+#include "../auth/password_hasher.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <utility>
+
+namespace http_server
+{
+    namespace
+    {
+        constexpr std::string_view method_names[] = {"GET", "HEAD", "POST", "other"};
+
+        // 单独统计的状态码，其余计入最后一项 "other"
+        constexpr unsigned status_codes[] = {200, 204, 206, 301, 302, 303, 304, 400,
+                                             403, 404, 405, 413, 416, 500, 503};
+
+        std::size_t method_index(http::verb method)
+        {
+            switch (method)
+            {
+            case http::verb::get:
+                return 0;
+            case http::verb::head:
+                return 1;
+            case http::verb::post:
+                return 2;
+            default:
+                return 3;
+            }
+        }
+
+        std::size_t status_index(unsigned status)
+        {
+            std::size_t i = 0;
+            for (; i < std::size(status_codes); ++i)
+            {
+                if (status_codes[i] == status)
+                {
+                    break;
+                }
+            }
+            return i;
+        }
+
+        // 直方图上界换算为纳秒，记录时只做整数比较
+        constexpr auto bucket_bounds_ns = []
+        {
+            std::array<std::uint64_t, Metrics::latency_buckets.size()> bounds{};
+            for (std::size_t i = 0; i < bounds.size(); ++i)
+            {
+                bounds[i] = static_cast<std::uint64_t>(Metrics::latency_buckets[i] * 1e9 + 0.5);
+            }
+            return bounds;
+        }();
+
+        void write_header(std::ostringstream &out, char const *name, char const *type, char const *help)
+        {
+            out << "# HELP " << name << ' ' << help << '\n'
+                << "# TYPE " << name << ' ' << type << '\n';
+        }
+
+        template <class T>
+        void write_metric(std::ostringstream &out, char const *name, char const *type, char const *help, T value)
+        {
+            write_header(out, name, type, help);
+            out << name << ' ' << value << '\n';
+        }
+    } // namespace
+
+    Metrics &Metrics::getInstance()
+    {
+        static Metrics instance;
+        return instance;
+    }
+
+    Metrics::thread_counters *Metrics::register_thread()
+    {
+        auto counters = std::make_unique<thread_counters>();
+        auto *p = counters.get();
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads_.push_back(std::move(counters));
+        return p;
+    }
+
+    void Metrics::record_request(http::verb method, unsigned status, std::size_t route,
+                                 std::chrono::steady_clock::duration latency)
+    {
+        auto &c = local();
+        c.requests[method_index(method)][status_index(status)].add(1);
+
+        auto const ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+        route = std::min(route, max_routes - 1);
+        std::size_t bucket = 0;
+        while (bucket < bucket_bounds_ns.size() && ns > bucket_bounds_ns[bucket])
+        {
+            ++bucket;
+        }
+        c.latency[route][bucket].add(1);
+        c.latency_sum_ns[route].add(ns);
+    }
+
+    std::string Metrics::scrape(std::vector<std::string_view> const &route_names)
+    {
+        // 先汇总，抓取期间新登记的线程下次再计入
+        std::uint64_t requests[method_count][status_count] = {};
+        std::uint64_t latency[max_routes][bucket_count] = {};
+        std::uint64_t latency_sum_ns[max_routes] = {};
+        std::uint64_t bytes_in = 0, bytes_out = 0, opened = 0, closed = 0, accept_errors = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto const &t : threads_)
+            {
+                for (std::size_t m = 0; m < method_count; ++m)
+                    for (std::size_t s = 0; s < status_count; ++s)
+                        requests[m][s] += t->requests[m][s].get();
+                for (std::size_t r = 0; r < max_routes; ++r)
+                {
+                    for (std::size_t b = 0; b < bucket_count; ++b)
+                        latency[r][b] += t->latency[r][b].get();
+                    latency_sum_ns[r] += t->latency_sum_ns[r].get();
+                }
+                bytes_in += t->bytes_in.get();
+                bytes_out += t->bytes_out.get();
+                opened += t->sessions_opened.get();
+                closed += t->sessions_closed.get();
+                accept_errors += t->accept_errors.get();
+            }
+        }
+
+        std::ostringstream out;
+        out.precision(9);
+
+        write_header(out, "http_requests_total", "counter", "HTTP requests by method and status.");
+        for (std::size_t m = 0; m < method_count; ++m)
+        {
+            for (std::size_t s = 0; s < status_count; ++s)
+            {
+                if (requests[m][s] == 0)
+                {
+                    continue;
+                }
+                out << "http_requests_total{method=\"" << method_names[m] << "\",status=\"";
+                if (s < std::size(status_codes))
+                    out << status_codes[s];
+                else
+                    out << "other";
+                out << "\"} " << requests[m][s] << '\n';
+            }
+        }
+
+        write_header(out, "http_request_duration_seconds", "histogram",
+                     "Time from reading a request to writing its response, by route.");
+        auto const routes = std::min(route_names.size(), max_routes);
+        for (std::size_t r = 0; r < routes; ++r)
+        {
+            std::uint64_t cumulative = 0;
+            for (std::size_t b = 0; b < bucket_count; ++b)
+            {
+                cumulative += latency[r][b];
+                out << "http_request_duration_seconds_bucket{route=\"" << route_names[r] << "\",le=\"";
+                if (b < latency_buckets.size())
+                    out << latency_buckets[b];
+                else
+                    out << "+Inf";
+                out << "\"} " << cumulative << '\n';
+            }
+            out << "http_request_duration_seconds_sum{route=\"" << route_names[r] << "\"} "
+                << static_cast<double>(latency_sum_ns[r]) / 1e9 << '\n'
+                << "http_request_duration_seconds_count{route=\"" << route_names[r] << "\"} " << cumulative << '\n';
+        }
+
+        write_metric(out, "http_received_bytes_total", "counter", "Bytes of HTTP requests read.", bytes_in);
+        write_metric(out, "http_sent_bytes_total", "counter", "Bytes of HTTP responses written.", bytes_out);
+        write_metric(out, "http_sessions_active", "gauge", "Open client connections.",
+                     static_cast<std::int64_t>(opened - closed));
+        write_metric(out, "http_sessions_total", "counter", "Accepted client connections.", opened);
+        write_metric(out, "http_accept_errors_total", "counter", "Failed accept calls.", accept_errors);
+
+        auto &admission = Admission::getInstance();
+        write_metric(out, "admission_sessions", "gauge", "Open connections counted against the session limit.",
+                     admission.sessions());
+        write_metric(out, "admission_accept_pauses_total", "counter",
+                     "Accept attempts deferred because the session limit was reached.", admission.accept_pauses());
+        constexpr std::pair<request_class, char const *> classes[] = {{request_class::light, "light"},
+                                                                      {request_class::database, "database"}};
+        write_header(out, "admission_inflight_requests", "gauge", "Requests being handled, by admission class.");
+        for (auto const &[c, name] : classes)
+            out << "admission_inflight_requests{class=\"" << name << "\"} " << admission.inflight(c) << '\n';
+        write_header(out, "admission_limit", "gauge", "Concurrent request limit by admission class, 0 for none.");
+        for (auto const &[c, name] : classes)
+            out << "admission_limit{class=\"" << name << "\"} " << admission.limit(c) << '\n';
+        write_header(out, "admission_rejected_total", "counter", "Requests answered with 503 by admission control.");
+        for (auto const &[c, name] : classes)
+            out << "admission_rejected_total{class=\"" << name << "\"} " << admission.rejected(c) << '\n';
+
+        auto &access_log = AccessLog::getInstance();
+        write_metric(out, "access_log_records_total", "counter", "Access log records written.", access_log.written());
+        write_metric(out, "access_log_dropped_total", "counter", "Access log records dropped because a queue was full.",
+                     access_log.dropped());
+        write_metric(out, "traces_dropped_total", "counter", "Sampled request traces dropped before export.",
+                     Tracer::getInstance().dropped());
+
+        auto const pool = db::ConnectionPool::getInstance().stats();
+        write_metric(out, "db_pool_connections", "gauge", "Database connections, idle and borrowed.", pool.total);
+        write_metric(out, "db_pool_idle_connections", "gauge", "Idle database connections.", pool.idle);
+        write_metric(out, "db_pool_waiters", "gauge", "Requests waiting for a database connection.", pool.waiting);
+        write_metric(out, "db_pool_acquired_total", "counter", "Database connections handed out.", pool.acquired);
+        write_header(out, "db_pool_acquire_wait_seconds", "summary",
+                     "Time spent waiting for a database connection when none was idle.");
+        out << "db_pool_acquire_wait_seconds_sum " << static_cast<double>(pool.wait_time_us) / 1e6 << '\n'
+            << "db_pool_acquire_wait_seconds_count " << pool.waited << '\n';
+        write_metric(out, "db_pool_acquire_wait_max_seconds", "gauge", "Longest wait for a database connection.",
+                     static_cast<double>(pool.max_wait_us) / 1e6);
+        write_metric(out, "db_pool_hold_seconds_total", "counter", "Total time connections were borrowed.",
+                     static_cast<double>(pool.hold_time_us) / 1e6);
+        write_metric(out, "db_pool_exhausted_total", "counter", "Acquires that found the pool at its limit.",
+                     pool.exhausted);
+        write_metric(out, "db_pool_timeouts_total", "counter", "Acquires that timed out.", pool.timeouts);
+        write_metric(out, "db_pool_created_total", "counter", "Database connections created.", pool.created);
+        write_metric(out, "db_pool_validation_failures_total", "counter", "Failed health check pings.",
+                     pool.validation_failures);
+        write_metric(out, "db_pool_dropped_broken_total", "counter", "Broken connections dropped on release.",
+                     pool.dropped_broken);
+
+        auto &hasher = auth::PasswordHasher::getInstance();
+        write_metric(out, "password_hash_queued", "gauge", "Password hashing tasks queued or running.",
+                     hasher.queued());
+        write_metric(out, "password_hash_rejected_total", "counter", "Password hashing tasks rejected as overloaded.",
+                     hasher.rejected());
+
+        return out.str();
+    }
+
+} // namespace http_server
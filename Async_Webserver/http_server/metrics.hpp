@@ -0,0 +1,103 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <boost/beast/http/verb.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace http = boost::beast::http;
+
+namespace http_server
+{
+    // 服务器运行指标，以 Prometheus 文本格式从 /metrics 导出。
+    // 每个线程写自己的一组计数器（按缓存行对齐，互不共享），记录时只有普通的读写，
+    // 没有跨线程的原子读-改-写；抓取时才把各线程的计数器相加
+    class Metrics
+    {
+    public:
+        static constexpr std::size_t max_routes = 8; // 超出的路由序号计入最后一个
+
+        // 请求延迟直方图的上界（秒），最后还有一个 +Inf
+        static constexpr std::array<double, 14> latency_buckets = {
+            0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 5};
+
+        static Metrics &getInstance();
+
+        // 一个请求的响应已写出：route 为路由序号，latency 为读完请求到写完响应的时间
+        void record_request(http::verb method, unsigned status, std::size_t route,
+                            std::chrono::steady_clock::duration latency);
+
+        void add_bytes_in(std::uint64_t n) { local().bytes_in.add(n); }
+        void add_bytes_out(std::uint64_t n) { local().bytes_out.add(n); }
+        void session_opened() { local().sessions_opened.add(1); }
+        void session_closed() { local().sessions_closed.add(1); }
+        void accept_error() { local().accept_errors.add(1); }
+
+        // 汇总所有线程的计数器，连同数据库连接池与密码哈希线程池的状态输出为 Prometheus 文本。
+        // route_names 按路由序号给出 route 标签的值
+        std::string scrape(std::vector<std::string_view> const &route_names);
+
+    private:
+        Metrics() = default;
+        Metrics(const Metrics &) = delete;
+        Metrics &operator=(const Metrics &) = delete;
+
+        // 只由所属线程写入；抓取线程并发读取，因此用 relaxed 原子的 load/store 而不是 fetch_add
+        struct counter
+        {
+            std::atomic<std::uint64_t> value{0};
+
+            void add(std::uint64_t n)
+            {
+                value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }
+
+            std::uint64_t get() const { return value.load(std::memory_order_relaxed); }
+        };
+
+        static constexpr std::size_t method_count = 4;  // GET、HEAD、POST、其他
+        static constexpr std::size_t status_count = 16; // 常见状态码各一项，其余归入 other
+        static constexpr std::size_t bucket_count = latency_buckets.size() + 1;
+
+        struct alignas(64) thread_counters
+        {
+            counter requests[method_count][status_count];
+            counter latency[max_routes][bucket_count];
+            counter latency_sum_ns[max_routes];
+            counter bytes_in;
+            counter bytes_out;
+            counter sessions_opened;
+            counter sessions_closed;
+            counter accept_errors;
+        };
+
+        // 当前线程的计数器，第一次使用时创建并登记
+        thread_counters &local()
+        {
+            thread_local thread_counters *counters = nullptr;
+            if (!counters)
+            {
+                counters = register_thread();
+            }
+            return *counters;
+        }
+
+        thread_counters *register_thread();
+
+        // 线程退出后其计数器保留，累计值不会丢失
+        std::mutex mutex_;
+        std::vector<std::unique_ptr<thread_counters>> threads_;
+    };
+
+} // namespace http_server
+
+#endif // METRICS_HPP
@@ -0,0 +1,300 @@
+#include "mime_types.hpp"
+
+#include <glog/logging.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace http_server
+{
+    namespace
+    {
+        struct builtin_type
+        {
+            std::string_view extension;
+            std::string_view type;
+        };
+
+        // 内置的常用 Web 类型，没有 mime.types 文件时也能正确返回 CSS/JS/wasm/字体/图片
+        constexpr builtin_type builtin_types[] = {
+            {"html", "text/html"},
+            {"htm", "text/html"},
+            {"css", "text/css"},
+            {"js", "text/javascript"},
+            {"mjs", "text/javascript"},
+            {"json", "application/json"},
+            {"map", "application/json"},
+            {"webmanifest", "application/manifest+json"},
+            {"xml", "application/xml"},
+            {"txt", "text/plain"},
+            {"md", "text/markdown"},
+            {"csv", "text/csv"},
+            {"wasm", "application/wasm"},
+            {"pdf", "application/pdf"},
+            {"zip", "application/zip"},
+            {"gz", "application/gzip"},
+            {"tar", "application/x-tar"},
+            {"png", "image/png"},
+            {"jpg", "image/jpeg"},
+            {"jpeg", "image/jpeg"},
+            {"gif", "image/gif"},
+            {"webp", "image/webp"},
+            {"avif", "image/avif"},
+            {"svg", "image/svg+xml"},
+            {"ico", "image/vnd.microsoft.icon"},
+            {"bmp", "image/bmp"},
+            {"woff", "font/woff"},
+            {"woff2", "font/woff2"},
+            {"ttf", "font/ttf"},
+            {"otf", "font/otf"},
+            {"eot", "application/vnd.ms-fontobject"},
+            {"mp3", "audio/mpeg"},
+            {"ogg", "audio/ogg"},
+            {"wav", "audio/wav"},
+            {"mp4", "video/mp4"},
+            {"webm", "video/webm"},
+        };
+
+        bool is_text(std::string_view type)
+        {
+            auto const ends_with = [type](std::string_view suffix)
+            {
+                return type.size() >= suffix.size() && type.substr(type.size() - suffix.size()) == suffix;
+            };
+            return type.substr(0, 5) == "text/" ||
+                   type == "application/javascript" ||
+                   type == "application/json" ||
+                   type == "application/xml" ||
+                   ends_with("+json") || ends_with("+xml");
+        }
+
+        // 文本类型之外，未压缩的二进制格式压缩也有收益
+        bool is_compressible(std::string_view type)
+        {
+            return is_text(type) ||
+                   type == "application/wasm" ||
+                   type == "font/ttf" ||
+                   type == "font/otf" ||
+                   type == "application/vnd.ms-fontobject" ||
+                   type == "image/vnd.microsoft.icon" ||
+                   type == "image/bmp";
+        }
+
+        // FNV-1a，种子不同时得到相互独立的哈希
+        std::uint32_t hash(std::string_view s, std::uint32_t seed)
+        {
+            std::uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+            for (char c : s)
+            {
+                h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+            }
+            return h;
+        }
+
+        std::size_t round_up_pow2(std::size_t n)
+        {
+            std::size_t p = 1;
+            while (p < n)
+            {
+                p *= 2;
+            }
+            return p;
+        }
+
+        char lower(char c)
+        {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+    } // namespace
+
+    MimeTypes &MimeTypes::getInstance()
+    {
+        static MimeTypes instance;
+        return instance;
+    }
+
+    MimeTypes::MimeTypes()
+    {
+        unknown_ = intern("application/octet-stream");
+        for (auto const &t : builtin_types)
+        {
+            add(t.type, t.extension);
+        }
+        build();
+    }
+
+    bool MimeTypes::load(const std::string &path)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            LOG(WARNING) << "Cannot open MIME types file " << path << ", using built-in table";
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(in, line))
+        {
+            line.erase(std::find(line.begin(), line.end(), '#'), line.end());
+            std::istringstream fields(line);
+            std::string type;
+            if (!(fields >> type))
+            {
+                continue;
+            }
+            std::string extension;
+            while (fields >> extension)
+            {
+                add(type, extension);
+            }
+        }
+
+        build();
+        LOG(INFO) << "Loaded " << entries_.size() << " MIME type extensions from " << path;
+        return true;
+    }
+
+    mime_type_info const &MimeTypes::lookup(std::string_view path) const
+    {
+        auto const dot = path.rfind('.');
+        if (dot == std::string_view::npos || path.find('/', dot) != std::string_view::npos)
+        {
+            return *unknown_;
+        }
+
+        auto const ext = path.substr(dot + 1);
+        if (ext.empty() || ext.size() > max_extension)
+        {
+            return *unknown_;
+        }
+
+        char buffer[max_extension];
+        std::transform(ext.begin(), ext.end(), buffer, lower);
+        auto const i = find(std::string_view(buffer, ext.size()));
+        return i == empty_slot ? *unknown_ : *entries_[static_cast<std::size_t>(i)].info;
+    }
+
+    void MimeTypes::add(std::string_view type, std::string_view extension)
+    {
+        if (extension.empty() || extension.size() > max_extension)
+        {
+            return;
+        }
+
+        std::string ext(extension);
+        std::transform(ext.begin(), ext.end(), ext.begin(), lower);
+        auto const *info = intern(type);
+
+        // 后加入的覆盖先前的（文件覆盖内置表）
+        auto it = std::find_if(entries_.begin(), entries_.end(),
+                               [&ext](entry const &e)
+                               { return e.extension == ext; });
+        if (it != entries_.end())
+        {
+            it->info = info;
+            return;
+        }
+        entries_.push_back({std::move(ext), info});
+    }
+
+    mime_type_info const *MimeTypes::intern(std::string_view type)
+    {
+        for (auto const &t : types_)
+        {
+            if (t.type == type)
+            {
+                return &t;
+            }
+        }
+
+        mime_type_info info;
+        info.type.assign(type);
+        std::transform(info.type.begin(), info.type.end(), info.type.begin(), lower);
+        if (is_text(info.type))
+        {
+            info.charset = "utf-8";
+        }
+        info.content_type = info.charset.empty() ? info.type : info.type + "; charset=" + info.charset;
+        info.compressible = is_compressible(info.type);
+        types_.push_back(std::move(info));
+        return &types_.back();
+    }
+
+    void MimeTypes::build()
+    {
+        auto const bucket_count = round_up_pow2(std::max<std::size_t>(entries_.size() / 4, 1));
+        auto const slot_count = round_up_pow2(std::max<std::size_t>(entries_.size() * 2, 1));
+
+        std::vector<std::vector<std::size_t>> buckets(bucket_count);
+        for (std::size_t i = 0; i < entries_.size(); ++i)
+        {
+            buckets[hash(entries_[i].extension, 0) & (bucket_count - 1)].push_back(i);
+        }
+
+        // 先放大的桶，冲突越晚出现越容易找到位移
+        std::vector<std::size_t> order(bucket_count);
+        for (std::size_t b = 0; b < bucket_count; ++b)
+        {
+            order[b] = b;
+        }
+        std::sort(order.begin(), order.end(),
+                  [&buckets](std::size_t a, std::size_t b)
+                  { return buckets[a].size() > buckets[b].size(); });
+
+        displacement_.assign(bucket_count, 0);
+        slots_.assign(slot_count, empty_slot);
+
+        std::vector<std::size_t> positions;
+        for (auto const b : order)
+        {
+            auto const &bucket = buckets[b];
+            if (bucket.empty())
+            {
+                break;
+            }
+
+            for (std::uint32_t d = 1;; ++d)
+            {
+                positions.clear();
+                bool ok = true;
+                for (auto const i : bucket)
+                {
+                    auto const pos = hash(entries_[i].extension, d) & (slot_count - 1);
+                    if (slots_[pos] != empty_slot ||
+                        std::find(positions.begin(), positions.end(), pos) != positions.end())
+                    {
+                        ok = false;
+                        break;
+                    }
+                    positions.push_back(pos);
+                }
+                if (ok)
+                {
+                    displacement_[b] = d;
+                    for (std::size_t k = 0; k < bucket.size(); ++k)
+                    {
+                        slots_[positions[k]] = static_cast<std::int32_t>(bucket[k]);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    std::int32_t MimeTypes::find(std::string_view extension) const
+    {
+        auto const d = displacement_[hash(extension, 0) & (displacement_.size() - 1)];
+        if (d == 0)
+        {
+            return empty_slot;
+        }
+        auto const i = slots_[hash(extension, d) & (slots_.size() - 1)];
+        if (i == empty_slot || entries_[static_cast<std::size_t>(i)].extension != extension)
+        {
+            return empty_slot;
+        }
+        return i;
+    }
+
+} // namespace http_server
@@ -0,0 +1,70 @@
+#ifndef MIME_TYPES_HPP
+#define MIME_TYPES_HPP
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace http_server
+{
+    // 一个 MIME 类型及其派生信息，启动后不再变化，缓存条目直接保存指向它的指针
+    struct mime_type_info
+    {
+        std::string type;         // 如 "text/html"
+        std::string charset;      // 文本类型为 "utf-8"，其他为空
+        std::string content_type; // 完整的 Content-Type 值，如 "text/html; charset=utf-8"
+        bool compressible{false}; // 是否值得 gzip/brotli 压缩
+    };
+
+    // 扩展名到 MIME 类型的映射。内置一份常用 Web 类型的表，
+    // 启动时再读取 mime.types 格式的文件补充或覆盖，随后建成最小完美哈希表（hash and displace），
+    // 查找为两次哈希加一次比较。
+    // load 须在开始处理请求前调用，之后只读，可在多个线程中并发查找
+    class MimeTypes
+    {
+    public:
+        static MimeTypes &getInstance();
+
+        // 读取 mime.types 格式的文件（"type ext1 ext2 ..."，'#' 开始注释）；
+        // 文件不存在或无法读取时只使用内置表并返回 false
+        bool load(const std::string &path);
+
+        // 按路径的扩展名查找（不区分大小写），未知扩展名返回 application/octet-stream
+        mime_type_info const &lookup(std::string_view path) const;
+
+        std::size_t size() const { return entries_.size(); }
+
+    private:
+        MimeTypes();
+        MimeTypes(const MimeTypes &) = delete;
+        MimeTypes &operator=(const MimeTypes &) = delete;
+
+        struct entry
+        {
+            std::string extension; // 小写，不含 '.'
+            mime_type_info const *info;
+        };
+
+        static constexpr std::int32_t empty_slot = -1;
+        static constexpr std::size_t max_extension = 16;
+
+        void add(std::string_view type, std::string_view extension);
+        mime_type_info const *intern(std::string_view type);
+        void build();
+        std::int32_t find(std::string_view extension) const;
+
+        std::deque<mime_type_info> types_; // deque：追加时已有元素的地址不变
+        mime_type_info const *unknown_;
+        std::vector<entry> entries_;
+
+        // 第一级按 hash(ext, 0) 分桶，桶的位移 d 使桶内所有扩展名的 hash(ext, d) 落在互不相同的空槽；
+        // d 为 0 表示空桶
+        std::vector<std::uint32_t> displacement_;
+        std::vector<std::int32_t> slots_;
+    };
+
+} // namespace http_server
+
+#endif // MIME_TYPES_HPP
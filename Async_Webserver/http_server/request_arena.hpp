@@ -0,0 +1,222 @@
+#ifndef REQUEST_ARENA_HPP
+#define REQUEST_ARENA_HPP
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <type_traits>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+
+namespace http_server
+{
+    // 从 memory_resource 分配的分配器。与 std::pmr::polymorphic_allocator 不同，它可以赋值，
+    // 满足 Beast basic_fields 对分配器的要求（移动赋值时随容器传递）
+    template <class T>
+    class arena_allocator
+    {
+    public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::true_type;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        arena_allocator() noexcept : resource_(std::pmr::get_default_resource()) {}
+        arena_allocator(std::pmr::memory_resource *resource) noexcept : resource_(resource) {}
+
+        template <class U>
+        arena_allocator(arena_allocator<U> const &other) noexcept : resource_(other.resource())
+        {
+        }
+
+        T *allocate(std::size_t n)
+        {
+            return static_cast<T *>(resource_->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *p, std::size_t n) noexcept
+        {
+            resource_->deallocate(p, n * sizeof(T), alignof(T));
+        }
+
+        std::pmr::memory_resource *resource() const noexcept { return resource_; }
+
+        template <class U>
+        bool operator==(arena_allocator<U> const &other) const noexcept { return resource_ == other.resource(); }
+
+        template <class U>
+        bool operator!=(arena_allocator<U> const &other) const noexcept { return resource_ != other.resource(); }
+
+    private:
+        std::pmr::memory_resource *resource_;
+    };
+
+    // 从 arena 分配请求头与请求体的请求类型
+    using arena_request = http::request<http::basic_string_body<char, std::char_traits<char>, arena_allocator<char>>,
+                                        http::basic_fields<arena_allocator<char>>>;
+
+    // 单个请求的内存：请求头、请求体以及处理过程中生成的路径、响应头、响应体都从这里顺序分配，
+    // 响应写出后整体释放。内置缓冲区能容纳常见请求，只有超出的部分才向全局堆申请
+    class request_arena
+    {
+    public:
+        static constexpr std::size_t inline_size = 8 * 1024;
+
+        request_arena() : resource_(buffer_, sizeof(buffer_)) {}
+        request_arena(request_arena const &) = delete;
+        request_arena &operator=(request_arena const &) = delete;
+
+        std::pmr::memory_resource *resource() { return &resource_; }
+        arena_allocator<char> allocator() { return arena_allocator<char>(&resource_); }
+
+        // 释放全部分配，之后重新从内置缓冲区开始分配
+        void reset() { resource_.release(); }
+
+    private:
+        alignas(std::max_align_t) unsigned char buffer_[inline_size];
+        std::pmr::monotonic_buffer_resource resource_;
+    };
+
+    // 与 http::message_generator 接口相同的类型擦除响应，
+    // 消息与序列化器从指定的 memory_resource 分配，而不是每个响应一次全局堆分配
+    class response_generator
+    {
+    public:
+        using const_buffers_type = beast::span<net::const_buffer const>;
+
+        template <bool isRequest, class Body, class Fields>
+        response_generator(http::message<isRequest, Body, Fields> &&msg, std::pmr::memory_resource *resource)
+        {
+            using impl_type = impl<isRequest, Body, Fields>;
+            void *p = resource->allocate(sizeof(impl_type), alignof(impl_type));
+            try
+            {
+                impl_ = ::new (p) impl_type(std::move(msg), resource);
+            }
+            catch (...)
+            {
+                resource->deallocate(p, sizeof(impl_type), alignof(impl_type));
+                throw;
+            }
+        }
+
+        response_generator(response_generator &&other) noexcept : impl_(other.impl_)
+        {
+            other.impl_ = nullptr;
+        }
+
+        response_generator(response_generator const &) = delete;
+        response_generator &operator=(response_generator const &) = delete;
+        response_generator &operator=(response_generator &&) = delete;
+
+        ~response_generator()
+        {
+            if (impl_)
+            {
+                impl_->destroy();
+            }
+        }
+
+        bool keep_alive() const { return impl_->keep_alive(); }
+        bool is_done() { return impl_->is_done(); }
+
+        // 返回序列化器下一段待写出的全部缓冲区，写出后调用 consume
+        const_buffers_type prepare(beast::error_code &ec) { return impl_->prepare(ec); }
+        void consume(std::size_t n) { impl_->consume(n); }
+
+    private:
+        struct impl_base
+        {
+            virtual void destroy() = 0;
+            virtual bool keep_alive() const = 0;
+            virtual bool is_done() = 0;
+            virtual const_buffers_type prepare(beast::error_code &ec) = 0;
+            virtual void consume(std::size_t n) = 0;
+
+        protected:
+            ~impl_base() = default;
+        };
+
+        template <bool isRequest, class Body, class Fields>
+        struct impl final : impl_base
+        {
+            // 序列化器每个头字段输出一个缓冲区，字段多时改用从 resource 分配的数组
+            static constexpr std::size_t inline_buffers = 16;
+
+            http::message<isRequest, Body, Fields> msg;
+            http::serializer<isRequest, Body, Fields> sr{msg};
+            std::pmr::memory_resource *resource;
+            net::const_buffer inline_storage[inline_buffers];
+            net::const_buffer *buffers{inline_storage};
+            std::size_t capacity{inline_buffers};
+            std::size_t count{0};
+
+            impl(http::message<isRequest, Body, Fields> &&m, std::pmr::memory_resource *r)
+                : msg(std::move(m)), resource(r)
+            {
+            }
+
+            void destroy() override
+            {
+                auto *r = resource;
+                if (buffers != inline_storage)
+                {
+                    r->deallocate(buffers, capacity * sizeof(net::const_buffer), alignof(net::const_buffer));
+                }
+                this->~impl();
+                r->deallocate(this, sizeof(impl), alignof(impl));
+            }
+
+            bool keep_alive() const override { return msg.keep_alive(); }
+            bool is_done() override { return sr.is_done(); }
+
+            const_buffers_type prepare(beast::error_code &ec) override
+            {
+                count = 0;
+                if (sr.is_done())
+                {
+                    return {buffers, 0};
+                }
+                sr.next(ec, [this](beast::error_code &, auto const &sequence)
+                        {
+                            auto const begin = net::buffer_sequence_begin(sequence);
+                            auto const end = net::buffer_sequence_end(sequence);
+                            reserve(static_cast<std::size_t>(std::distance(begin, end)));
+                            count = static_cast<std::size_t>(std::copy(begin, end, buffers) - buffers);
+                        });
+                return {buffers, count};
+            }
+
+            void reserve(std::size_t n)
+            {
+                if (n <= capacity)
+                {
+                    return;
+                }
+                auto *p = static_cast<net::const_buffer *>(
+                    resource->allocate(n * sizeof(net::const_buffer), alignof(net::const_buffer)));
+                if (buffers != inline_storage)
+                {
+                    resource->deallocate(buffers, capacity * sizeof(net::const_buffer), alignof(net::const_buffer));
+                }
+                buffers = p;
+                capacity = n;
+            }
+
+            void consume(std::size_t n) override { sr.consume(n); }
+        };
+
+        impl_base *impl_{nullptr};
+    };
+
+} // namespace http_server
+
+#endif // REQUEST_ARENA_HPP
@@ -0,0 +1,298 @@
+#ifndef ROUTER_HPP
+#define ROUTER_HPP
+
+#include <boost/beast/http/verb.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace http = boost::beast::http;
+
+namespace http_server
+{
+    // 路由表：路径在编译期建好，请求按 (方法, 路径) 匹配，全程使用 string_view，不复制请求目标。
+    // 静态路径放入编译期生成的完美哈希表，一次哈希和一次比较即可命中；
+    // 含参数的路径（如 "/users/:name"）逐段比较，参数值指向请求目标本身。
+    // 处理器是函数对象，命中后通过按下标生成的跳转表直接调用，不经过 if/else 链
+    //
+    //   constexpr auto routes = make_router(
+    //       route{http::verb::post, "/login", [](route_params const &, auto &req, auto &&send) { ... }},
+    //       route{http::verb::get, "/users/:name", ...});
+    //
+    //   route_params params;
+    //   if (auto i = routes.match(req.method(), path, params))
+    //       return routes.invoke(*i, params, req, send);
+
+    // 路径参数，名称与值都指向路由模式和请求目标
+    class route_params
+    {
+    public:
+        static constexpr std::size_t max_params = 4;
+
+        constexpr std::optional<std::string_view> get(std::string_view name) const
+        {
+            for (std::size_t i = 0; i < size_; ++i)
+            {
+                if (params_[i].name == name)
+                {
+                    return params_[i].value;
+                }
+            }
+            return std::nullopt;
+        }
+
+        constexpr std::size_t size() const { return size_; }
+        constexpr void clear() { size_ = 0; }
+
+        constexpr bool add(std::string_view name, std::string_view value)
+        {
+            if (size_ == max_params)
+            {
+                return false;
+            }
+            params_[size_].name = name;
+            params_[size_].value = value;
+            ++size_;
+            return true;
+        }
+
+    private:
+        struct param
+        {
+            std::string_view name;
+            std::string_view value;
+        };
+
+        std::array<param, max_params> params_{};
+        std::size_t size_{0};
+    };
+
+    template <class Handler>
+    struct route
+    {
+        constexpr route(http::verb m, std::string_view p, Handler h) : method(m), pattern(p), handler(h) {}
+
+        http::verb method;
+        std::string_view pattern;
+        Handler handler;
+    };
+
+    template <class... Handlers>
+    class router
+    {
+    public:
+        static constexpr std::size_t route_count = sizeof...(Handlers);
+
+        constexpr router(route<Handlers>... routes)
+            : entries_{entry{routes.method, routes.pattern, has_params(routes.pattern)}...},
+              handlers_(routes.handler...)
+        {
+            for (std::size_t i = 0; i < route_count; ++i)
+            {
+                if (entries_[i].pattern.empty() || entries_[i].pattern.front() != '/')
+                {
+                    throw std::logic_error("route pattern must start with '/'");
+                }
+                for (std::size_t j = 0; j < i; ++j)
+                {
+                    if (entries_[i].method == entries_[j].method && entries_[i].pattern == entries_[j].pattern)
+                    {
+                        throw std::logic_error("duplicate route");
+                    }
+                }
+                if (entries_[i].parameterized)
+                {
+                    param_routes_[param_count_++] = i;
+                }
+            }
+            build_table();
+        }
+
+        // 查找匹配的路由，返回其下标；带参数的路由同时填写 params。
+        // path 不含查询参数
+        constexpr std::optional<std::size_t> match(http::verb method, std::string_view path,
+                                                   route_params &params) const
+        {
+            auto const &s = slots_[hash(seed_, method, path) & (table_size - 1)];
+            if (s.index != empty_slot && entries_[s.index].method == method && entries_[s.index].pattern == path)
+            {
+                return s.index;
+            }
+
+            for (std::size_t k = 0; k < param_count_; ++k)
+            {
+                auto const i = param_routes_[k];
+                if (entries_[i].method == method)
+                {
+                    params.clear();
+                    if (match_params(entries_[i].pattern, path, params))
+                    {
+                        return i;
+                    }
+                }
+            }
+            params.clear();
+            return std::nullopt;
+        }
+
+        constexpr http::verb method(std::size_t index) const { return entries_[index].method; }
+        constexpr std::string_view pattern(std::size_t index) const { return entries_[index].pattern; }
+
+        // 调用下标为 index 的处理器：handler(params, args...)。各处理器对同样的参数须返回同一类型
+        template <class... Args>
+        decltype(auto) invoke(std::size_t index, route_params const &params, Args &&...args) const
+        {
+            return invoke_impl(std::index_sequence_for<Handlers...>{}, index, params, std::forward<Args>(args)...);
+        }
+
+    private:
+        struct entry
+        {
+            http::verb method;
+            std::string_view pattern;
+            bool parameterized;
+        };
+
+        struct slot
+        {
+            std::size_t index;
+        };
+
+        static constexpr std::size_t empty_slot = route_count;
+
+        // 哈希表大小取不小于路由数两倍的 2 的幂，便于找到无冲突的种子
+        static constexpr std::size_t table_size = []
+        {
+            std::size_t n = 4;
+            while (n < 2 * route_count)
+            {
+                n *= 2;
+            }
+            return n;
+        }();
+
+        static constexpr bool has_params(std::string_view pattern)
+        {
+            return pattern.find(':') != std::string_view::npos;
+        }
+
+        // FNV-1a，混入方法与种子
+        static constexpr std::uint32_t hash(std::uint32_t seed, http::verb method, std::string_view path)
+        {
+            std::uint32_t h = 2166136261u ^ seed;
+            h = (h ^ static_cast<std::uint32_t>(method)) * 16777619u;
+            for (char c : path)
+            {
+                h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+            }
+            return h;
+        }
+
+        // 逐个尝试种子，直到所有静态路由落在不同的槽里
+        constexpr void build_table()
+        {
+            for (std::uint32_t seed = 0; seed < 4096; ++seed)
+            {
+                bool collision = false;
+                for (auto &s : slots_)
+                {
+                    s.index = empty_slot;
+                }
+                for (std::size_t i = 0; i < route_count && !collision; ++i)
+                {
+                    if (entries_[i].parameterized)
+                    {
+                        continue;
+                    }
+                    auto &s = slots_[hash(seed, entries_[i].method, entries_[i].pattern) & (table_size - 1)];
+                    if (s.index != empty_slot)
+                    {
+                        collision = true;
+                    }
+                    s.index = i;
+                }
+                if (!collision)
+                {
+                    seed_ = seed;
+                    return;
+                }
+            }
+            throw std::logic_error("no perfect hash seed for route table");
+        }
+
+        // 按 '/' 分段比较，":name" 段匹配任意非空段
+        static constexpr bool match_params(std::string_view pattern, std::string_view path, route_params &params)
+        {
+            while (!pattern.empty() && !path.empty())
+            {
+                // 两者都以 '/' 开头
+                if (pattern.front() != '/' || path.front() != '/')
+                {
+                    return false;
+                }
+                pattern.remove_prefix(1);
+                path.remove_prefix(1);
+
+                auto const pattern_end = pattern.find('/');
+                auto const path_end = path.find('/');
+                auto const segment = pattern.substr(0, pattern_end);
+                auto const value = path.substr(0, path_end);
+
+                if (!segment.empty() && segment.front() == ':')
+                {
+                    if (value.empty() || !params.add(segment.substr(1), value))
+                    {
+                        return false;
+                    }
+                }
+                else if (segment != value)
+                {
+                    return false;
+                }
+
+                pattern.remove_prefix(segment.size());
+                path.remove_prefix(value.size());
+            }
+            return pattern.empty() && path.empty();
+        }
+
+        template <std::size_t I, class... Args>
+        static decltype(auto) call(router const &self, route_params const &params, Args &&...args)
+        {
+            return std::get<I>(self.handlers_)(params, std::forward<Args>(args)...);
+        }
+
+        template <std::size_t... I, class... Args>
+        decltype(auto) invoke_impl(std::index_sequence<I...>, std::size_t index, route_params const &params,
+                                   Args &&...args) const
+        {
+            using result_type = decltype(call<0>(*this, params, std::forward<Args>(args)...));
+            using function_type = result_type (*)(router const &, route_params const &, Args &&...);
+            static constexpr function_type table[] = {&call<I, Args...>...};
+            return table[index](*this, params, std::forward<Args>(args)...);
+        }
+
+        std::array<entry, route_count> entries_;
+        std::tuple<Handlers...> handlers_;
+        std::array<slot, table_size> slots_{};
+        std::array<std::size_t, route_count> param_routes_{};
+        std::size_t param_count_{0};
+        std::uint32_t seed_{0};
+    };
+
+    template <class... Handlers>
+    constexpr router<Handlers...> make_router(route<Handlers>... routes)
+    {
+        return router<Handlers...>(routes...);
+    }
+
+} // namespace http_server
+
+#endif // ROUTER_HPP
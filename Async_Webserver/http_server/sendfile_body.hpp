@@ -0,0 +1,58 @@
+#ifndef SENDFILE_BODY_HPP
+#define SENDFILE_BODY_HPP
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
+
+#include <cstdint>
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace net = boost::asio;
+
+namespace http_server
+{
+    // 大文件响应体：序列化器只输出响应头，正文由 session 通过 sendfile(2)
+    // 从文件直接交给内核发送，不经过用户态缓冲区
+    struct sendfile_body
+    {
+        struct value_type
+        {
+            beast::file file;         // 已打开的文件
+            std::uint64_t offset{0};  // 下一次发送的起始偏移
+            std::uint64_t remaining{0}; // 剩余待发送的字节数
+        };
+
+        static std::uint64_t size(value_type const &body)
+        {
+            return body.remaining;
+        }
+
+        class writer
+        {
+        public:
+            using const_buffers_type = net::const_buffer;
+
+            template <bool isRequest, class Fields>
+            writer(http::header<isRequest, Fields> const &, value_type const &)
+            {
+            }
+
+            void init(beast::error_code &ec)
+            {
+                ec = {};
+            }
+
+            // 不产生任何缓冲区，正文由 session::do_sendfile 发送
+            boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code &ec)
+            {
+                ec = {};
+                return boost::none;
+            }
+        };
+    };
+
+} // namespace http_server
+
+#endif // SENDFILE_BODY_HPP
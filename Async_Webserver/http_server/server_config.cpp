@@ -138,6 +138,243 @@ std::string ServerConfig::getDocRoot()
     return config_["server"]["doc_root"].get<std::string>();
 }
 
+std::string ServerConfig::getCacheControl()
+{
+    return config_["server"].value("cache_control", std::string("public, max-age=0, must-revalidate"));
+}
+
+std::string ServerConfig::getMimeTypesFile()
+{
+    return config_["server"].value("mime_types", std::string("/etc/mime.types"));
+}
+
+bool ServerConfig::isReusePortEnabled()
+{
+    return config_["server"].value("reuse_port", false);
+}
+
+bool ServerConfig::isThreadPinningEnabled()
+{
+    return config_["server"].value("pin_threads", true);
+}
+
+const json &ServerConfig::section(const std::string &name)
+{
+    static const json empty = json::object();
+    auto it = config_.find(name);
+    return it != config_.end() ? *it : empty;
+}
+
+bool ServerConfig::isFileCacheEnabled()
+{
+    return section("file_cache").value("enabled", true);
+}
+
+size_t ServerConfig::getFileCacheMaxBytes()
+{
+    return section("file_cache").value("max_bytes", size_t{64} * 1024 * 1024);
+}
+
+size_t ServerConfig::getFileCacheMaxFileSize()
+{
+    return section("file_cache").value("max_file_size", size_t{1024} * 1024);
+}
+
+size_t ServerConfig::getFileCacheShards()
+{
+    return section("file_cache").value("shards", size_t{16});
+}
+
+uint64_t ServerConfig::getSendfileThreshold()
+{
+    const auto &sendfile = section("sendfile");
+    if (!sendfile.value("enabled", true))
+    {
+        return 0;
+    }
+    return sendfile.value("threshold", uint64_t{1024} * 1024);
+}
+
+bool ServerConfig::isCompressionEnabled()
+{
+    return section("compression").value("enabled", true);
+}
+
+size_t ServerConfig::getCompressionThreads()
+{
+    return section("compression").value("threads", size_t{1});
+}
+
+size_t ServerConfig::getCompressionMinSize()
+{
+    return section("compression").value("min_size", size_t{256});
+}
+
+int ServerConfig::getGzipLevel()
+{
+    return section("compression").value("gzip_level", 6);
+}
+
+int ServerConfig::getBrotliQuality()
+{
+    return section("compression").value("brotli_quality", 9);
+}
+
+bool ServerConfig::isAccessLogEnabled()
+{
+    return section("access_log").value("enabled", true);
+}
+
+std::string ServerConfig::getAccessLogPath()
+{
+    return section("access_log").value("path", std::string("./logs/access.log"));
+}
+
+size_t ServerConfig::getAccessLogRingSize()
+{
+    return section("access_log").value("ring_size", size_t{8192});
+}
+
+size_t ServerConfig::getAccessLogMaxBytes()
+{
+    return section("access_log").value("max_bytes", size_t{100} * 1024 * 1024);
+}
+
+size_t ServerConfig::getAccessLogMaxFiles()
+{
+    return section("access_log").value("max_files", size_t{5});
+}
+
+bool ServerConfig::isTracingEnabled()
+{
+    return section("tracing").value("enabled", false);
+}
+
+double ServerConfig::getTracingSampleRate()
+{
+    return section("tracing").value("sample_rate", 0.01);
+}
+
+std::string ServerConfig::getTracingDirectory()
+{
+    return section("tracing").value("directory", std::string("./logs/traces"));
+}
+
+size_t ServerConfig::getTracingMaxTracesPerFile()
+{
+    return section("tracing").value("max_traces_per_file", size_t{10000});
+}
+
+size_t ServerConfig::getMaxSessions()
+{
+    return section("admission").value("max_sessions", size_t{10000});
+}
+
+size_t ServerConfig::getMaxLightInflight()
+{
+    return section("admission").value("max_light_inflight", size_t{0});
+}
+
+size_t ServerConfig::getMaxDbInflight()
+{
+    return section("admission").value("max_db_inflight", size_t{64});
+}
+
+bool ServerConfig::isAdaptiveDbLimitEnabled()
+{
+    return section("admission").value("adaptive", true);
+}
+
+size_t ServerConfig::getMinDbInflight()
+{
+    return section("admission").value("min_db_inflight", size_t{4});
+}
+
+size_t ServerConfig::getDbLatencyTarget()
+{
+    return section("admission").value("db_latency_target_ms", size_t{200});
+}
+
+double ServerConfig::getAdaptiveBackoff()
+{
+    return section("admission").value("backoff", 0.9);
+}
+
+unsigned ServerConfig::getRetryAfter()
+{
+    return section("admission").value("retry_after", 1u);
+}
+
+bool ServerConfig::isUserCacheEnabled()
+{
+    return section("user_cache").value("enabled", true);
+}
+
+size_t ServerConfig::getUserCacheMaxEntries()
+{
+    return section("user_cache").value("max_entries", static_cast<size_t>(100000));
+}
+
+size_t ServerConfig::getUserCacheMaxNegativeEntries()
+{
+    return section("user_cache").value("max_negative_entries", static_cast<size_t>(10000));
+}
+
+size_t ServerConfig::getUserCacheShards()
+{
+    return section("user_cache").value("shards", static_cast<size_t>(16));
+}
+
+size_t ServerConfig::getUserCacheTtl()
+{
+    return section("user_cache").value("ttl", static_cast<size_t>(300));
+}
+
+size_t ServerConfig::getUserCacheNegativeTtl()
+{
+    return section("user_cache").value("negative_ttl", static_cast<size_t>(30));
+}
+
+size_t ServerConfig::getPasswordHashThreads()
+{
+    return section("password_hash").value("threads", static_cast<size_t>(2));
+}
+
+size_t ServerConfig::getPasswordHashMaxQueue()
+{
+    return section("password_hash").value("max_queue", static_cast<size_t>(64));
+}
+
+unsigned ServerConfig::getScryptLogN()
+{
+    return section("password_hash").value("scrypt_log_n", 15u);
+}
+
+unsigned ServerConfig::getScryptR()
+{
+    return section("password_hash").value("scrypt_r", 8u);
+}
+
+unsigned ServerConfig::getScryptP()
+{
+    return section("password_hash").value("scrypt_p", 1u);
+}
+
+bool ServerConfig::isRegistrationBatchEnabled()
+{
+    return section("registration").value("batch", false);
+}
+
+size_t ServerConfig::getRegistrationMaxBatch()
+{
+    return section("registration").value("max_batch", static_cast<size_t>(32));
+}
+
+size_t ServerConfig::getRegistrationMaxInflight()
+{
+    return section("registration").value("max_inflight", static_cast<size_t>(2));
+}
+
 std::string ServerConfig::getDbHost()
 {
     return config_["database"]["host"].get<std::string>();
@@ -168,6 +405,41 @@ size_t ServerConfig::getDbPoolSize()
     return config_["database"]["pool_size"].get<size_t>();
 }
 
+size_t ServerConfig::getDbExecutorThreads()
+{
+    return config_["database"].value("executor_threads", getDbPoolSize());
+}
+
+size_t ServerConfig::getDbMaxPoolSize()
+{
+    return config_["database"].value("max_pool_size", getDbPoolSize());
+}
+
+size_t ServerConfig::getDbMinIdle()
+{
+    return config_["database"].value("min_idle", static_cast<size_t>(0));
+}
+
+size_t ServerConfig::getDbMaxIdle()
+{
+    return config_["database"].value("max_idle", getDbMaxPoolSize());
+}
+
+size_t ServerConfig::getDbAcquireTimeout()
+{
+    return config_["database"].value("acquire_timeout_ms", static_cast<size_t>(3000));
+}
+
+size_t ServerConfig::getDbHealthCheckInterval()
+{
+    return config_["database"].value("health_check_interval", static_cast<size_t>(30));
+}
+
+size_t ServerConfig::getDbIdlePingThreshold()
+{
+    return config_["database"].value("idle_ping_threshold", static_cast<size_t>(60));
+}
+
 void ServerConfig::initializeGlog(const char *program_name)
 {
     const auto &logging = config_["logging"];
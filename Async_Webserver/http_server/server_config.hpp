@@ -19,6 +19,67 @@ public:
     static uint16_t getPort();
     static size_t getThreadCount();
     static std::string getDocRoot();
+    static std::string getCacheControl(); // 静态文件响应的 Cache-Control
+    static std::string getMimeTypesFile(); // mime.types 格式的扩展名映射文件
+    static bool isReusePortEnabled();     // 每个线程一个 io_context 与 SO_REUSEPORT 监听套接字
+    static bool isThreadPinningEnabled(); // SO_REUSEPORT 模式下把 I/O 线程绑定到 CPU
+
+    // 静态文件缓存配置获取器
+    static bool isFileCacheEnabled();
+    static size_t getFileCacheMaxBytes();
+    static size_t getFileCacheMaxFileSize();
+    static size_t getFileCacheShards();
+    static uint64_t getSendfileThreshold(); // 未启用 sendfile 时返回 0
+
+    // 静态文件压缩配置获取器
+    static bool isCompressionEnabled();
+    static size_t getCompressionThreads();
+    static size_t getCompressionMinSize();
+    static int getGzipLevel();
+    static int getBrotliQuality();
+
+    // 访问日志配置获取器
+    static bool isAccessLogEnabled();
+    static std::string getAccessLogPath();
+    static size_t getAccessLogRingSize(); // 每个 I/O 线程的队列容量（条），满时丢弃
+    static size_t getAccessLogMaxBytes(); // 超过后轮转，0 表示不轮转
+    static size_t getAccessLogMaxFiles(); // 轮转保留的旧文件数
+
+    // 请求跟踪配置获取器
+    static bool isTracingEnabled();
+    static double getTracingSampleRate(); // 0 到 1 之间的采样比例
+    static std::string getTracingDirectory();
+    static size_t getTracingMaxTracesPerFile();
+
+    // 准入控制配置获取器，上限为 0 表示不限制
+    static size_t getMaxSessions();
+    static size_t getMaxLightInflight(); // 静态文件等轻量请求的并发上限
+    static size_t getMaxDbInflight(); // 登录、注册等数据库请求的并发上限（自适应时为最大值）
+    static bool isAdaptiveDbLimitEnabled();
+    static size_t getMinDbInflight(); // 自适应上限的最小值
+    static size_t getDbLatencyTarget(); // 毫秒，数据库操作超过该延迟时收缩上限
+    static double getAdaptiveBackoff(); // 收缩时乘以的系数
+    static unsigned getRetryAfter(); // 秒
+
+    // 用户缓存配置获取器
+    static bool isUserCacheEnabled();
+    static size_t getUserCacheMaxEntries();
+    static size_t getUserCacheMaxNegativeEntries();
+    static size_t getUserCacheShards();
+    static size_t getUserCacheTtl();         // 秒
+    static size_t getUserCacheNegativeTtl(); // 秒，0 表示不缓存不存在的用户名
+
+    // 密码哈希配置获取器
+    static size_t getPasswordHashThreads();
+    static size_t getPasswordHashMaxQueue(); // 排队上限，超过时返回 503
+    static unsigned getScryptLogN();
+    static unsigned getScryptR();
+    static unsigned getScryptP();
+
+    // 注册批处理配置获取器
+    static bool isRegistrationBatchEnabled();
+    static size_t getRegistrationMaxBatch();
+    static size_t getRegistrationMaxInflight();
 
     // 数据库配置获取器
     static std::string getDbHost();
@@ -27,6 +88,13 @@ public:
     static std::string getDbPassword();
     static std::string getDbName();
     static size_t getDbPoolSize();
+    static size_t getDbExecutorThreads(); // 执行数据库请求的线程数，缺省与连接池大小相同
+    static size_t getDbMaxPoolSize();         // 连接总数上限，缺省与 pool_size 相同
+    static size_t getDbMinIdle();
+    static size_t getDbMaxIdle();
+    static size_t getDbAcquireTimeout();      // 等待连接的超时（毫秒）
+    static size_t getDbHealthCheckInterval(); // 连接健康检查间隔（秒），0 表示关闭
+    static size_t getDbIdlePingThreshold();   // 空闲超过该秒数的连接才会被 ping
 
     // 初始化 Google 日志库
     static void initializeGlog(const char *program_name);
@@ -36,6 +104,7 @@ private:
     static void validateConfig();                             // 验证配置文件
     static void validateDatabaseConfig(const json &database); // 验证数据库配置
     static json readConfigFile();                             // 读取配置文件
+    static const json &section(const std::string &name);      // 获取可选配置段，缺失时返回空对象
 };
 
 #endif // SERVER_CONFIG_HPP
@@ -0,0 +1,303 @@
+#include "tracing.hpp"
+
+#include <glog/logging.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace http_server
+{
+    namespace
+    {
+        constexpr auto flush_interval = std::chrono::seconds(1);
+        constexpr std::size_t max_pending = 4096; // 后台线程来不及写出时丢弃新的 trace
+
+        std::uint32_t thread_id()
+        {
+            thread_local std::uint32_t const tid = static_cast<std::uint32_t>(::syscall(SYS_gettid));
+            return tid;
+        }
+
+        // 每个线程一个 xorshift 生成器，采样判断不加锁
+        std::uint64_t next_random()
+        {
+            thread_local std::uint64_t state =
+                trace_clock() ^ (static_cast<std::uint64_t>(thread_id()) << 32) ^ 0x9e3779b97f4a7c15ull;
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+
+        void append_escaped(std::string &out, std::string_view s)
+        {
+            constexpr char hex[] = "0123456789abcdef";
+            for (char c : s)
+            {
+                auto const u = static_cast<unsigned char>(c);
+                if (c == '"' || c == '\\')
+                {
+                    out += '\\';
+                    out += c;
+                }
+                else if (u < 0x20 || u == 0x7f)
+                {
+                    out += "\\u00";
+                    out += hex[u >> 4];
+                    out += hex[u & 0xf];
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+
+        bool write_all(int fd, std::string const &data)
+        {
+            char const *p = data.data();
+            std::size_t left = data.size();
+            while (left != 0)
+            {
+                auto const n = ::write(fd, p, left);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return false;
+                }
+                p += n;
+                left -= static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+    } // namespace
+
+    thread_local request_trace *Tracer::current_ = nullptr;
+
+    void request_trace::add(char const *name, std::uint64_t begin, std::uint64_t end)
+    {
+        auto const i = size.fetch_add(1, std::memory_order_relaxed);
+        if (i < max_spans)
+        {
+            spans[i] = span{name, begin, end, thread_id()};
+        }
+    }
+
+    Tracer &Tracer::getInstance()
+    {
+        static Tracer instance;
+        return instance;
+    }
+
+    Tracer::~Tracer()
+    {
+        shutdown();
+    }
+
+    bool Tracer::initialize(const std::string &directory, double sample_rate, std::size_t max_traces_per_file)
+    {
+        if (writer_.joinable() || !(sample_rate > 0))
+        {
+            return false;
+        }
+
+        directory_ = directory;
+        max_traces_per_file_ = std::max<std::size_t>(max_traces_per_file, 1);
+        sample_threshold_ = sample_rate >= 1
+                                ? UINT64_MAX
+                                : static_cast<std::uint64_t>(std::ldexp(sample_rate, 64));
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory_, ec);
+        if (ec)
+        {
+            LOG(ERROR) << "Cannot create trace directory " << directory_ << ": " << ec.message();
+            return false;
+        }
+
+        // 用 steady_clock 校准计数器频率
+        auto const t0 = std::chrono::steady_clock::now();
+        auto const c0 = trace_clock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto const t1 = std::chrono::steady_clock::now();
+        auto const c1 = trace_clock();
+        auto const elapsed_us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        us_per_tick_ = elapsed_us / static_cast<double>(c1 - c0);
+        base_tick_ = c1;
+
+        stop_ = false;
+        writer_ = std::thread(&Tracer::run, this);
+        enabled_.store(true, std::memory_order_relaxed);
+        LOG(INFO) << "Request tracing enabled: sample rate " << sample_rate << ", writing to " << directory_;
+        return true;
+    }
+
+    void Tracer::shutdown()
+    {
+        if (!writer_.joinable())
+        {
+            return;
+        }
+
+        enabled_.store(false, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        writer_.join();
+        close_file();
+    }
+
+    trace_ptr Tracer::start(http::verb method, std::string_view target)
+    {
+        if (!enabled() || next_random() >= sample_threshold_)
+        {
+            return nullptr;
+        }
+
+        auto trace = std::make_shared<request_trace>();
+        trace->id = next_id_.fetch_add(1, std::memory_order_relaxed);
+        trace->start = trace_clock();
+        trace->method = method;
+        auto const n = std::min(target.size(), request_trace::max_target);
+        std::memcpy(trace->target, target.data(), n);
+        trace->target_size = static_cast<std::uint8_t>(n);
+        return trace;
+    }
+
+    void Tracer::finish(trace_ptr trace, unsigned status)
+    {
+        trace->end = trace_clock();
+        trace->status = status;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.size() >= max_pending)
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pending_.push_back(std::move(trace));
+    }
+
+    void Tracer::run()
+    {
+        std::vector<trace_ptr> traces;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_)
+        {
+            cv_.wait_for(lock, flush_interval, [this]
+                         { return stop_; });
+            traces.swap(pending_);
+            lock.unlock();
+            write_traces(traces);
+            lock.lock();
+        }
+    }
+
+    void Tracer::write_traces(std::vector<trace_ptr> &traces)
+    {
+        std::string out;
+        char number[64];
+        auto const to_us = [this](std::uint64_t tick)
+        {
+            return tick > base_tick_ ? static_cast<double>(tick - base_tick_) * us_per_tick_ : 0.0;
+        };
+
+        for (auto const &trace : traces)
+        {
+            if (fd_ < 0 && !open_file())
+            {
+                break;
+            }
+
+            // 每个阶段一个完整事件（"ph":"X"），另有一个覆盖整个请求的 "request" 事件带上请求信息
+            auto const append_event = [&](char const *name, std::uint64_t begin, std::uint64_t end,
+                                          std::uint32_t thread)
+            {
+                out += first_event_ ? "\n" : ",\n";
+                first_event_ = false;
+                out += "{\"name\":\"";
+                out += name;
+                std::snprintf(number, sizeof(number), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+                              to_us(begin), std::max(0.0, to_us(end) - to_us(begin)));
+                out += number;
+                std::snprintf(number, sizeof(number), ",\"pid\":1,\"tid\":%llu,\"args\":{",
+                              static_cast<unsigned long long>(trace->id));
+                out += number;
+                if (thread != 0)
+                {
+                    std::snprintf(number, sizeof(number), "\"thread\":%u}}", thread);
+                    out += number;
+                }
+            };
+
+            append_event("request", trace->start, trace->end, 0);
+            out += "\"method\":\"";
+            auto const method = http::to_string(trace->method);
+            out.append(method.data(), method.size());
+            out += "\",\"target\":\"";
+            append_escaped(out, std::string_view(trace->target, trace->target_size));
+            std::snprintf(number, sizeof(number), "\",\"status\":%u}}", trace->status);
+            out += number;
+
+            auto const size = std::min(trace->size.load(std::memory_order_relaxed), request_trace::max_spans);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                auto const &s = trace->spans[i];
+                append_event(s.name, s.begin, s.end, s.thread);
+            }
+
+            if (++file_traces_ >= max_traces_per_file_)
+            {
+                write_all(fd_, out);
+                out.clear();
+                close_file();
+            }
+        }
+
+        if (fd_ >= 0 && !out.empty() && !write_all(fd_, out))
+        {
+            LOG_EVERY_N(WARNING, 100) << "Trace write failed: " << std::strerror(errno);
+        }
+        traces.clear();
+    }
+
+    // trace-<pid>-<n>.json，JSON 数组格式；数组在文件写满或停止时闭合
+    bool Tracer::open_file()
+    {
+        char name[64];
+        std::snprintf(name, sizeof(name), "/trace-%d-%zu.json", static_cast<int>(::getpid()), file_index_++);
+        auto const path = directory_ + name;
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+        {
+            LOG_EVERY_N(ERROR, 100) << "Cannot open trace file " << path << ": " << std::strerror(errno);
+            return false;
+        }
+        file_traces_ = 0;
+        first_event_ = true;
+        return write_all(fd_, "[");
+    }
+
+    void Tracer::close_file()
+    {
+        if (fd_ < 0)
+        {
+            return;
+        }
+        write_all(fd_, "\n]\n");
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+} // namespace http_server
@@ -0,0 +1,204 @@
+#ifndef TRACING_HPP
+#define TRACING_HPP
+
+#include <boost/beast/http/verb.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace http = boost::beast::http;
+
+namespace http_server
+{
+    // 时间戳：x86 上直接读 TSC（假定 constant/invariant TSC，各核同步），其他平台退回 steady_clock。
+    // 换算为纳秒的系数在 Tracer::initialize 时校准，记录阶段时只读计数器
+    inline std::uint64_t trace_clock()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    // 一个被采样请求的各阶段，沿着请求的处理链记录（I/O 线程 -> 数据库/哈希线程 -> strand）。
+    // I/O 线程上的阶段可能与已投递到其他线程的阶段同时结束，记录时用原子计数领取位置；
+    // 响应写出后才读取，此时所有记录都已经过 post 与读取方同步
+    class request_trace : public std::enable_shared_from_this<request_trace>
+    {
+    public:
+        static constexpr std::size_t max_spans = 24; // 超出的阶段被丢弃
+        static constexpr std::size_t max_target = 96;
+
+        struct span
+        {
+            char const *name; // 字符串字面量
+            std::uint64_t begin;
+            std::uint64_t end;
+            std::uint32_t thread;
+        };
+
+        void add(char const *name, std::uint64_t begin, std::uint64_t end);
+
+        std::uint64_t id{0};
+        std::uint64_t start{0}; // 请求读完
+        std::uint64_t end{0};   // 响应写出
+        http::verb method{http::verb::unknown};
+        unsigned status{0};
+        std::uint8_t target_size{0};
+        char target[max_target];
+        std::array<span, max_spans> spans;
+        std::atomic<std::size_t> size{0}; // 可能超过 max_spans，读取时取较小值
+    };
+
+    using trace_ptr = std::shared_ptr<request_trace>;
+
+    // 按采样率跟踪请求，记录各阶段的起止时间，后台线程定期把完成的 trace
+    // 以 Chrome trace-event JSON（chrome://tracing、Perfetto 可直接打开）写到目录中。
+    // 每个请求占一行（tid 为请求 id），阶段所在的线程记录在 args.thread 中
+    class Tracer
+    {
+    public:
+        static Tracer &getInstance();
+
+        // sample_rate 为 0 到 1 之间的采样比例；每个文件最多写 max_traces_per_file 个请求
+        bool initialize(const std::string &directory, double sample_rate, std::size_t max_traces_per_file);
+        void shutdown(); // 写出剩余的 trace 后停止后台线程
+
+        bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        // 决定是否采样；不采样（或未启用）时返回空
+        trace_ptr start(http::verb method, std::string_view target);
+
+        // 请求的响应已写出，交给后台线程导出
+        void finish(trace_ptr trace, unsigned status);
+
+        // 当前线程正在处理的请求，未采样时为空
+        static request_trace *current() { return current_; }
+
+        std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        friend class trace_scope;
+
+        Tracer() = default;
+        ~Tracer();
+        Tracer(const Tracer &) = delete;
+        Tracer &operator=(const Tracer &) = delete;
+
+        void run();
+        void write_traces(std::vector<trace_ptr> &traces);
+        bool open_file();
+        void close_file();
+
+        static thread_local request_trace *current_;
+
+        std::atomic<bool> enabled_{false};
+        std::uint64_t sample_threshold_{0}; // 随机数小于它时采样
+        std::atomic<std::uint64_t> next_id_{1};
+        std::atomic<std::uint64_t> dropped_{0};
+
+        // TSC 到微秒的换算，以 initialize 时刻为零点
+        std::uint64_t base_tick_{0};
+        double us_per_tick_{0};
+
+        std::string directory_;
+        std::size_t max_traces_per_file_{0};
+
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<trace_ptr> pending_;
+        bool stop_{false};
+        std::thread writer_;
+
+        // 以下只由后台线程访问
+        int fd_{-1};
+        std::size_t file_traces_{0};
+        std::size_t file_index_{0};
+        bool first_event_{true};
+    };
+
+    // 在当前线程上把 trace 设为当前请求，离开作用域时恢复
+    class trace_scope
+    {
+    public:
+        explicit trace_scope(request_trace *trace) : previous_(Tracer::current_) { Tracer::current_ = trace; }
+        ~trace_scope() { Tracer::current_ = previous_; }
+        trace_scope(const trace_scope &) = delete;
+        trace_scope &operator=(const trace_scope &) = delete;
+
+    private:
+        request_trace *previous_;
+    };
+
+    // 记录一个阶段：构造时取时间戳，析构时写入当前请求的 trace；未采样时只有一次线程局部变量的读取
+    class trace_phase
+    {
+    public:
+        explicit trace_phase(char const *name)
+            : trace_(Tracer::current()), name_(name), begin_(trace_ ? trace_clock() : 0) {}
+
+        ~trace_phase()
+        {
+            if (trace_)
+            {
+                trace_->add(name_, begin_, trace_clock());
+            }
+        }
+
+        trace_phase(const trace_phase &) = delete;
+        trace_phase &operator=(const trace_phase &) = delete;
+
+    private:
+        request_trace *trace_;
+        char const *name_;
+        std::uint64_t begin_;
+    };
+
+    // 把当前请求的 trace 带到另一个线程：投递时构造，在目标线程上 resume()，
+    // 同时把投递到开始执行之间的排队时间记为名为 name 的阶段
+    class trace_handoff
+    {
+    public:
+        explicit trace_handoff(char const *name)
+            : name_(name)
+        {
+            if (auto *trace = Tracer::current())
+            {
+                trace_ = trace->shared_from_this();
+                posted_ = trace_clock();
+            }
+        }
+
+        [[nodiscard]] trace_scope resume() const
+        {
+            if (trace_)
+            {
+                trace_->add(name_, posted_, trace_clock());
+            }
+            return trace_scope(trace_.get());
+        }
+
+    private:
+        trace_ptr trace_;
+        char const *name_;
+        std::uint64_t posted_{0};
+    };
+
+} // namespace http_server
+
+#endif // TRACING_HPP
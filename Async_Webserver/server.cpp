@@ -1,14 +1,49 @@
 #include "http_server/http_server.hpp"
+#include "http_server/file_cache.hpp"
+#include "http_server/compressor.hpp"
+#include "http_server/mime_types.hpp"
+#include "http_server/access_log.hpp"
+#include "http_server/admission.hpp"
+#include "http_server/tracing.hpp"
 #include "http_server/server_config.hpp"
 #include "database/db_pool.hpp"
+#include "database/db_executor.hpp"
 #include "database/schema.hpp"
+#include "database/user_cache.hpp"
+#include "database/registration.hpp"
+#include "auth/password_hasher.hpp"
 
 #include <boost/asio/signal_set.hpp>
+#include <cstring>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <vector>
 #include <thread>
+#include <pthread.h>
+#include <sched.h>
+
+namespace
+{
+    // 把当前线程绑定到第 index 个 CPU（按 CPU 数取模），失败时只记录日志
+    void pin_current_thread(size_t index)
+    {
+        unsigned const cpus = std::thread::hardware_concurrency();
+        if (cpus == 0)
+        {
+            return;
+        }
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(index % cpus, &set);
+        int const rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0)
+        {
+            LOG(WARNING) << "Failed to pin I/O thread " << index << ": " << std::strerror(rc);
+        }
+    }
+} // namespace
 
 int main(int argc, char *argv[])
 {
@@ -35,8 +70,16 @@ int main(int argc, char *argv[])
         auto const doc_root = std::make_shared<std::string>(ServerConfig::getDocRoot());
         auto const threads = ServerConfig::getThreadCount();
 
-        // 所有 I/O 操作都需要一个 io_context 对象
-        net::io_context ioc{threads};
+        // 所有 I/O 操作都需要一个 io_context 对象。
+        // SO_REUSEPORT 模式下每个线程一个 io_context，连接由内核分配，之后只在该线程上处理
+        bool const reuse_port = ServerConfig::isReusePortEnabled();
+        bool const pin_threads = reuse_port && ServerConfig::isThreadPinningEnabled();
+        std::vector<std::unique_ptr<net::io_context>> contexts;
+        for (size_t i = 0; i < (reuse_port ? threads : 1); ++i)
+        {
+            contexts.push_back(std::make_unique<net::io_context>(reuse_port ? 1 : static_cast<int>(threads)));
+        }
+        auto &ioc = *contexts.front();
 
         // 初始化数据库连接池
         auto &pool = db::ConnectionPool::getInstance();
@@ -52,6 +95,11 @@ int main(int argc, char *argv[])
             LOG(ERROR) << "Failed to initialize database connection pool";
             return EXIT_FAILURE;
         }
+        pool.setLimits(
+            ServerConfig::getDbMaxPoolSize(),
+            ServerConfig::getDbMinIdle(),
+            ServerConfig::getDbMaxIdle(),
+            std::chrono::milliseconds(ServerConfig::getDbAcquireTimeout()));
         LOG(INFO) << "Database connection pool initialized successfully";
 
         // 初始化数据库表结构
@@ -62,12 +110,106 @@ int main(int argc, char *argv[])
         }
         LOG(INFO) << "Database schema initialized successfully";
 
-        // 创建并运行 HTTP 服务器
-        std::make_shared<http_server::listener>(
-            ioc,
-            tcp::endpoint{address, port},
-            doc_root)
-            ->run();
+        // 数据库请求在独立线程池中执行，I/O 线程不会阻塞在 MySQL 调用上
+        db::Executor::getInstance().initialize(ServerConfig::getDbExecutorThreads());
+
+        // 密码哈希在独立的有界线程池中计算，过载时拒绝新请求
+        auth::PasswordHasher::getInstance().initialize(
+            ServerConfig::getPasswordHashThreads(),
+            ServerConfig::getPasswordHashMaxQueue(),
+            {ServerConfig::getScryptLogN(), ServerConfig::getScryptR(), ServerConfig::getScryptP()});
+
+        // 注册高峰时把并发的注册合并为多行 INSERT
+        if (ServerConfig::isRegistrationBatchEnabled())
+        {
+            db::RegistrationBatcher::getInstance().initialize(
+                ServerConfig::getRegistrationMaxBatch(),
+                ServerConfig::getRegistrationMaxInflight());
+        }
+
+        // 连接有效性由后台定时检查，归还连接时不再访问数据库
+        pool.startHealthCheck(
+            std::chrono::seconds(ServerConfig::getDbHealthCheckInterval()),
+            std::chrono::seconds(ServerConfig::getDbIdlePingThreshold()));
+
+        // 登录请求先查用户缓存，命中时不访问数据库
+        if (ServerConfig::isUserCacheEnabled())
+        {
+            db::UserCache::getInstance().initialize(
+                ServerConfig::getUserCacheMaxEntries(),
+                ServerConfig::getUserCacheMaxNegativeEntries(),
+                ServerConfig::getUserCacheShards(),
+                std::chrono::seconds(ServerConfig::getUserCacheTtl()),
+                std::chrono::seconds(ServerConfig::getUserCacheNegativeTtl()));
+        }
+
+        http_server::set_cache_control(ServerConfig::getCacheControl());
+
+        // 扩展名到 MIME 类型的映射：内置表加上 mime.types 文件，须在处理请求前完成
+        http_server::MimeTypes::getInstance().load(ServerConfig::getMimeTypesFile());
+
+        // 访问日志由后台线程批量写出，I/O 线程只把定长记录放入各自的队列
+        if (ServerConfig::isAccessLogEnabled())
+        {
+            http_server::AccessLog::getInstance().initialize(
+                ServerConfig::getAccessLogPath(),
+                ServerConfig::getAccessLogRingSize(),
+                ServerConfig::getAccessLogMaxBytes(),
+                ServerConfig::getAccessLogMaxFiles());
+        }
+
+        // 准入控制：连接数、各类请求的并发上限，数据库请求的上限随数据库延迟调整
+        http_server::admission_options admission;
+        admission.max_sessions = ServerConfig::getMaxSessions();
+        admission.max_light_inflight = ServerConfig::getMaxLightInflight();
+        admission.max_db_inflight = ServerConfig::getMaxDbInflight();
+        admission.adaptive = ServerConfig::isAdaptiveDbLimitEnabled();
+        admission.min_db_inflight = ServerConfig::getMinDbInflight();
+        admission.db_latency_target = std::chrono::milliseconds(ServerConfig::getDbLatencyTarget());
+        admission.backoff = ServerConfig::getAdaptiveBackoff();
+        admission.retry_after = ServerConfig::getRetryAfter();
+        http_server::Admission::getInstance().initialize(admission);
+
+        // 按采样率记录请求各阶段的耗时，写成 Chrome trace-event JSON
+        if (ServerConfig::isTracingEnabled())
+        {
+            http_server::Tracer::getInstance().initialize(
+                ServerConfig::getTracingDirectory(),
+                ServerConfig::getTracingSampleRate(),
+                ServerConfig::getTracingMaxTracesPerFile());
+        }
+
+        // 初始化静态文件缓存，失败时退化为每次请求直接读取文件
+        if (ServerConfig::isFileCacheEnabled())
+        {
+            http_server::FileCache::getInstance().initialize(
+                *doc_root,
+                ServerConfig::getFileCacheMaxBytes(),
+                ServerConfig::getFileCacheMaxFileSize(),
+                ServerConfig::getFileCacheShards());
+        }
+        http_server::set_sendfile_threshold(ServerConfig::getSendfileThreshold());
+
+        // 静态文件压缩在独立线程池中进行，不占用 I/O 线程
+        if (ServerConfig::isCompressionEnabled())
+        {
+            http_server::Compressor::getInstance().initialize(
+                ServerConfig::getCompressionThreads(),
+                ServerConfig::getCompressionMinSize(),
+                ServerConfig::getGzipLevel(),
+                ServerConfig::getBrotliQuality());
+        }
+
+        // 创建并运行 HTTP 服务器，每个 io_context 一个监听器
+        for (auto &context : contexts)
+        {
+            std::make_shared<http_server::listener>(
+                *context,
+                tcp::endpoint{address, port},
+                doc_root,
+                reuse_port)
+                ->run();
+        }
 
         // Capture SIGINT and SIGTERM to perform a clean shutdown
         net::signal_set signals(ioc, SIGINT, SIGTERM);
@@ -75,29 +217,50 @@ int main(int argc, char *argv[])
             [&](beast::error_code const &, int sig)
             {
                 // LOG(INFO) << "Received signal " << sig << ", shutting down...";
-                ioc.stop();
+                for (auto &context : contexts)
+                {
+                    context->stop();
+                }
             });
 
         std::cout << "Server starting on " << address << ":" << port << std::endl;
         std::cout << "Document root: " << *doc_root << std::endl;
-        std::cout << "Using " << threads << " threads" << std::endl;
+        std::cout << "Using " << threads << " threads"
+                  << (reuse_port ? " (SO_REUSEPORT, one io_context per thread)" : "") << std::endl;
 
         // Run the I/O service on the requested number of threads
         std::vector<std::thread> v;
         v.reserve(threads - 1);
         for (auto i = threads - 1; i > 0; --i)
         {
+            auto &context = reuse_port ? *contexts[i] : ioc;
             v.emplace_back(
-                [&ioc]
+                [&context, i, pin_threads]
                 {
-                    ioc.run();
+                    if (pin_threads)
+                    {
+                        pin_current_thread(i);
+                    }
+                    context.run();
                 });
         }
 
         // Block until all the threads exit
+        if (pin_threads)
+        {
+            pin_current_thread(0);
+        }
         ioc.run();
         for (auto &t : v)
             t.join();
+
+        auth::PasswordHasher::getInstance().shutdown();
+        db::Executor::getInstance().shutdown();
+        pool.stopHealthCheck();
+        http_server::Compressor::getInstance().shutdown();
+        http_server::FileCache::getInstance().shutdown();
+        http_server::AccessLog::getInstance().shutdown();
+        http_server::Tracer::getInstance().shutdown();
     }
     catch (const std::exception &e)
     {
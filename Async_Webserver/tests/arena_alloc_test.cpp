@@ -0,0 +1,172 @@
+// 零分配测试：稳定运行的 keep-alive GET（命中文件缓存）不应有任何全局堆分配。
+// 与 BM_SessionKeepAliveGet 相同，在进程内通过回环连接运行真实的 listener/session，客户端与服务器
+// 共用一个 io_context 和线程，计数覆盖完整的会话路径：async_read（bind_allocator）、解析进 request_arena、
+// handle_request、响应队列、合并写出、指标与访问日志。客户端只写入预先构造的请求、读入固定长度的响应，
+// 异步操作的中间状态放在自己的 handler_memory 中，自身不分配。
+// 预热之后出现任何一次全局 operator new 都使测试失败（计数由 benchmarks/alloc_counter.cpp 提供）
+#include "../benchmarks/alloc_counter.hpp"
+#include "../http_server/handler_memory.hpp"
+#include "../http_server/http_server.hpp"
+#include "../http_server/file_cache.hpp"
+
+#include <boost/asio/bind_allocator.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/http/read.hpp>
+#include <glog/logging.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace http_server;
+
+namespace
+{
+    constexpr int warmup_requests = 16;
+    constexpr int measured_requests = 1000;
+
+    constexpr std::string_view raw_request =
+        "GET / HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "User-Agent: arena_alloc_test\r\n"
+        "Accept: text/html,application/xhtml+xml,*/*;q=0.8\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+
+    std::string make_doc_root()
+    {
+        char dir[] = "/tmp/arena_alloc_test.XXXXXX";
+        if (!::mkdtemp(dir))
+        {
+            std::perror("mkdtemp");
+            std::exit(2);
+        }
+        std::string root = dir;
+        std::ofstream(root + "/index.html") << "<!DOCTYPE html><html><head><title>test</title></head><body>"
+                                            << std::string(2048, 'x') << "</body></html>\n";
+        return root;
+    }
+
+    // 运行事件循环直到 done 为真
+    void run_until(net::io_context &ioc, bool const &done)
+    {
+        while (!done && ioc.run_one() != 0)
+        {
+        }
+    }
+} // namespace
+
+int main()
+{
+    FLAGS_minloglevel = google::GLOG_ERROR;
+    auto const doc_root = make_doc_root();
+    FileCache::getInstance().initialize(doc_root, 64 * 1024 * 1024, 1024 * 1024, 4);
+
+    net::io_context ioc{1};
+
+    // 先绑定 0 端口取得一个空闲端口，listener 再绑定该端口
+    tcp::endpoint endpoint;
+    {
+        tcp::acceptor probe(ioc, tcp::endpoint{net::ip::make_address("127.0.0.1"), 0});
+        endpoint = probe.local_endpoint();
+    }
+    std::make_shared<listener>(ioc, endpoint, std::make_shared<std::string const>(doc_root))->run();
+
+    // 客户端的 socket 使用具体的执行器类型：any_io_executor 派发完成回调时要分配类型擦除的函数对象
+    tcp::socket::rebind_executor<net::io_context::executor_type>::other client(ioc.get_executor());
+    client.connect(endpoint);
+    client.set_option(tcp::no_delay(true));
+
+    // 第一个请求把文件读入缓存，并取得响应的长度（响应没有 Date 等变长字段，长度固定）
+    std::size_t response_size = 0;
+    {
+        beast::flat_buffer buffer;
+        http::response<http::string_body> res;
+        bool done = false;
+        beast::error_code ec;
+        net::async_write(client, net::buffer(raw_request.data(), raw_request.size()),
+                         [](beast::error_code, std::size_t) {});
+        http::async_read(client, buffer, res,
+                         [&](beast::error_code e, std::size_t n)
+                         {
+                             ec = e;
+                             response_size = n;
+                             done = true;
+                         });
+        run_until(ioc, done);
+        if (ec || res.result() != http::status::ok || !res.keep_alive() || buffer.size() != 0)
+        {
+            std::cerr << "unexpected first response: " << (ec ? ec.message() : std::to_string(res.result_int()))
+                      << '\n';
+            return 1;
+        }
+    }
+
+    std::vector<char> response(response_size);
+    handler_memory client_memory;
+    auto round_trip = [&]
+    {
+        bool done = false;
+        beast::error_code ec;
+        net::async_write(client, net::buffer(raw_request.data(), raw_request.size()),
+                         net::bind_allocator(handler_allocator<void>(client_memory),
+                                             [](beast::error_code, std::size_t) {}));
+        net::async_read(client, net::buffer(response),
+                        net::bind_allocator(handler_allocator<void>(client_memory),
+                                            [&](beast::error_code e, std::size_t)
+                                            {
+                                                ec = e;
+                                                done = true;
+                                            }));
+        run_until(ioc, done);
+        if (ec || std::string_view(response.data(), 15) != "HTTP/1.1 200 OK")
+        {
+            std::cerr << "unexpected response: " << (ec ? ec.message() : std::string(response.data(), 15)) << '\n';
+            return false;
+        }
+        return true;
+    };
+
+    // 预热：建立会话的 arena、缓冲区、处理器内存与各处的线程局部缓冲区
+    for (int i = 0; i < warmup_requests; ++i)
+    {
+        if (!round_trip())
+        {
+            return 1;
+        }
+    }
+
+    auto const before = bench::allocations();
+    for (int i = 0; i < measured_requests; ++i)
+    {
+        if (!round_trip())
+        {
+            return 1;
+        }
+    }
+    auto const allocations = bench::allocations() - before;
+
+    // 关闭连接并让服务器端的会话处理完 EOF
+    client.close();
+    ioc.poll();
+
+    FileCache::getInstance().shutdown();
+    std::filesystem::remove_all(doc_root);
+
+    if (allocations != 0)
+    {
+        std::cerr << "FAIL: " << allocations << " global heap allocations in " << measured_requests
+                  << " keep-alive GET requests\n";
+        return 1;
+    }
+    std::cout << "PASS: no global heap allocations in " << measured_requests << " keep-alive GET requests\n";
+    return 0;
+}